@@ -121,18 +121,29 @@
 #define configTOTAL_HEAP_SIZE                   10240
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
+/* Set to 1 to run the OPTIGA PAL events from a task that only wakes up while an OPTIGA operation is in progress,
+ * instead of polling them from the tick hook on every tick (see source/optiga_event.h). Defined here rather than
+ * in app_config.h because the tick hook is only enabled without it. */
+#define APP_OPTIGA_EVENT_TASK                   (1)
+
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
-#define configUSE_TICK_HOOK                     1    //
+#define configUSE_TICK_HOOK                     (!APP_OPTIGA_EVENT_TASK)
 #define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* The run time counter is a free running 1 MHz timer (source/runtime_stats.c) */
+extern void runtime_stats_counter_init(void);
+extern uint32_t runtime_stats_counter(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    runtime_stats_counter_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()            runtime_stats_counter()
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         2
@@ -199,7 +210,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
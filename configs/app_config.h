@@ -28,4 +28,112 @@
 // you can choose to use your own NTP server to obtain network time, or simply time.google.com for better stability
 #define IOTCONNECT_SNTP_SERVER "pool.ntp.org"
 
+// The MQTT connection is kept open until it fails. Set this to a non-zero value to disconnect
+// and reconnect after every APP_PUBLISHES_PER_CONNECTION messages instead.
+#define APP_PUBLISHES_PER_CONNECTION (0)
+
+// Failed connections are retried after a random delay between half and all of a limit that starts at
+// APP_RECONNECT_BACKOFF_MIN_MS and doubles with every failure, up to APP_RECONNECT_BACKOFF_MAX_MS.
+#define APP_RECONNECT_BACKOFF_MIN_MS (2000)
+#define APP_RECONNECT_BACKOFF_MAX_MS (300000)
+
+// Without the certificate from the OPTIGA the device cannot connect. The samples are then kept for
+// APP_OPTIGA_FAILURE_RESET_MS and moved to the flash store, and the MCU is reset to start the OPTIGA again.
+#define APP_OPTIGA_FAILURE_RESET_MS (600000)
+
+// Telemetry serializers:
+// TELEMETRY_SERIALIZER_IOTCL builds every message as a cJSON tree with the IoTConnect library (heap allocated).
+// TELEMETRY_SERIALIZER_STATIC writes the same JSON into a static buffer without any heap allocations, with the
+// temperature and the pressure rounded to 2 decimals.
+#define TELEMETRY_SERIALIZER_IOTCL  (1)
+#define TELEMETRY_SERIALIZER_STATIC (2)
+
+#define APP_TELEMETRY_SERIALIZER TELEMETRY_SERIALIZER_IOTCL
+
+// Sensors are sampled every APP_TELEMETRY_SAMPLE_PERIOD_MS. The queued samples are published every
+// APP_TELEMETRY_BATCH_PERIOD_MS, APP_TELEMETRY_PUBLISH_PHASE_MS into the period, in multi-point messages of up to
+// APP_TELEMETRY_BATCH_SIZE samples. Sampling, publishing, the diagnostics and the time resync are periodic jobs
+// (see source/periodic.h) on one grid, so the half sample period phase keeps a whole number of samples in every
+// message. The PAS CO2 data ready interrupt (APP_SAMPLER_DATA_READY) keeps its own time though, and a message
+// has a sample more or less whenever its samples drift across the publish phase.
+// Set APP_TELEMETRY_BATCH_SIZE to 1 and APP_TELEMETRY_BATCH_PERIOD_MS to the sample period to publish every sample.
+#define APP_TELEMETRY_SAMPLE_PERIOD_MS (10000)
+#define APP_TELEMETRY_BATCH_SIZE (6)
+#define APP_TELEMETRY_BATCH_PERIOD_MS (60000)
+#define APP_TELEMETRY_PUBLISH_PHASE_MS (APP_TELEMETRY_SAMPLE_PERIOD_MS / 2)
+
+// Set to 1 to run the PAS CO2 in continuous mode with a measurement every APP_TELEMETRY_SAMPLE_PERIOD_MS
+// (5 s to 4095 s) and take a sample on its data ready interrupt, with the DPS310 measuring in background mode.
+// No task then waits for a conversion to finish. Set to 0 to read both sensors on a timer.
+#define APP_SAMPLER_DATA_READY (1)
+
+// Samples queued between the sensor sampler task and the publisher (power of two)
+#define APP_SAMPLER_QUEUE_LENGTH (8)
+
+// Samples kept while the connection is down. The oldest ones are dropped beyond this.
+#define APP_TELEMETRY_BATCH_CAPACITY (APP_TELEMETRY_BATCH_SIZE * 4)
+
+// Set to 1 to keep the samples that do not fit into the batch while the connection is down in a log on the
+// work flash (see source/telemetry_store.h), in up to APP_STORE_FLASH_SIZE bytes. Once connected, the backlog is
+// published in messages of APP_STORE_REPLAY_BATCH_SIZE samples, at most one every APP_STORE_REPLAY_PERIOD_MS.
+#define APP_TELEMETRY_STORE (1)
+#define APP_STORE_FLASH_SIZE (16384)
+#define APP_STORE_REPLAY_BATCH_SIZE (12)
+#define APP_STORE_REPLAY_PERIOD_MS (2000)
+
+// Set to 1 to add a "diag" object with the CPU share and free stack of every task and the heap usage
+// to the last data point of the first message after every APP_DIAGNOSTICS_PERIOD_MS (less than an hour).
+// They are taken just before that message, at the same phase. Off by default, since it adds two fields per task.
+#define APP_TELEMETRY_DIAGNOSTICS (0)
+#define APP_DIAGNOSTICS_PERIOD_MS (300000)
+
+// SNTP sets the time once before the first connection and the telemetry timestamps count ticks from there
+// (see source/timestamp.h). Set to a non-zero value to get the time again every APP_TIME_RESYNC_PERIOD_MS
+// while connected, at APP_TIME_RESYNC_PHASE_MS into the period: half a period after the start, between two publishes.
+#define APP_TIME_RESYNC_PERIOD_MS (6 * 60 * 60 * 1000)
+#define APP_TIME_RESYNC_PHASE_MS (APP_TIME_RESYNC_PERIOD_MS / 2 + APP_TELEMETRY_PUBLISH_PHASE_MS + APP_TELEMETRY_BATCH_PERIOD_MS / 2)
+
+// Set to 1 to publish a sensor value only when it moved at least the absolute or the relative deadband
+// (0 to disable) away from the last published value, or when it was not published for APP_TELEMETRY_MAX_SILENCE_MS.
+// The version and cpu fields are published on connect only. See source/telemetry_filter.h.
+#define APP_TELEMETRY_FILTER (1)
+#define APP_TELEMETRY_MAX_SILENCE_MS (600000)
+#define APP_DEADBAND_CO2_ABS (20.0f)            // ppm
+#define APP_DEADBAND_CO2_REL (0.02f)
+#define APP_DEADBAND_TEMPERATURE_ABS (0.2f)     // degrees Celsius
+#define APP_DEADBAND_TEMPERATURE_REL (0.0f)
+#define APP_DEADBAND_PRESSURE_ABS (0.5f)        // mBar
+#define APP_DEADBAND_PRESSURE_REL (0.0f)
+
+// Size of the static telemetry message buffer: message header plus the data points of the largest message
+// (a live batch or a replayed one) and the diagnostics
+#define APP_TELEMETRY_MAX_POINTS \
+    (APP_TELEMETRY_STORE && APP_STORE_REPLAY_BATCH_SIZE > APP_TELEMETRY_BATCH_SIZE ? APP_STORE_REPLAY_BATCH_SIZE : APP_TELEMETRY_BATCH_SIZE)
+#define APP_TELEMETRY_BUFFER_SIZE (256 + 160 * APP_TELEMETRY_MAX_POINTS + 1024 * APP_TELEMETRY_DIAGNOSTICS)
+
+// Set to 1 to create the tasks of the application from static stacks and control blocks instead of the heap,
+// so that the heap left for the SDK, lwIP and mbedTLS is fixed at link time. See source/ram_map.h.
+#define APP_STATIC_ALLOCATION (1)
+
+// Size of the dedicated mbedTLS heap (see source/tls_arena.h). Size it from the handshake peak and the steady state
+// use that are printed after every connection. Set to 0 to have mbedTLS allocate from the heap.
+#define APP_TLS_ARENA_SIZE (49152)
+
+// Set to 1 to answer the IoTConnect discovery and sync requests of a reconnection from the responses of the last
+// successful connection, for up to APP_DISCOVERY_CACHE_TTL_S seconds (see source/discovery_cache.h).
+// With APP_DISCOVERY_CACHE_FLASH the responses are also kept in flash across resets.
+#define APP_DISCOVERY_CACHE (1)
+#define APP_DISCOVERY_CACHE_TTL_S (86400)
+#define APP_DISCOVERY_CACHE_FLASH (1)
+
+// APP_OPTIGA_EVENT_TASK is in FreeRTOSConfig.h, which enables the tick hook only without it.
+
+// Set to 1 when profiling to record spans of the telemetry path (see source/trace.h). Up to APP_TRACE_TASKS tasks
+// keep their last APP_TRACE_RECORDS records, which are printed on the debug UART every APP_TRACE_DUMP_PUBLISHES
+// messages. Off in production builds: the rings take RAM and the dumps flood the debug UART.
+#define APP_TRACE_ENABLED (0)
+#define APP_TRACE_TASKS (4)
+#define APP_TRACE_RECORDS (64)
+#define APP_TRACE_DUMP_PUBLISHES (10)
+
 #endif // APP_CONFIG_H
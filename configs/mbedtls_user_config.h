@@ -446,8 +446,10 @@
  * callbacks are provided by MBEDTLS_SSL_TICKET_C.
  *
  * Comment this macro to disable support for SSL session tickets
+ *
+ * Kept enabled so that reconnects can resume the previous session instead of
+ * doing a full handshake (see source/tls_session_cache.c).
  */
-#undef MBEDTLS_SSL_SESSION_TICKETS
 
 /**
  * \def MBEDTLS_SSL_EXPORT_KEYS
@@ -954,4 +956,14 @@
  */
 #define MBEDTLS_DEPRECATED_REMOVED
 
+/**
+ * \def MBEDTLS_PLATFORM_MEMORY
+ *
+ * Allocate through mbedtls_calloc() and mbedtls_free(), which the application
+ * points at its dedicated TLS arena with mbedtls_platform_set_calloc_free()
+ * before the first allocation (source/tls_arena.c, APP_TLS_ARENA_SIZE in
+ * app_config.h).
+ */
+#define MBEDTLS_PLATFORM_MEMORY
+
 #endif /* MBEDTLS_USER_CONFIG_HEADER */
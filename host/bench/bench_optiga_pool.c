@@ -0,0 +1,143 @@
+//
+// Copyright: Avnet 2021
+//
+// Compares the per-operation setup cost of creating and destroying an
+// optiga_util instance around every operation with borrowing one from
+// optiga_pool.c.
+//
+// Runs against the simulated OPTIGA (shims/optiga_sim.c), which models the
+// heap allocation and command layer registration of an instance. The real
+// library also sets up its command and communication contexts on create, so
+// the saving on the target is larger than the one measured here.
+//
+// Usage: build/bench_optiga_pool  (BENCH_ITERATIONS overrides the loop count,
+// the end to end loop runs BENCH_ITERATIONS / 1000 OPTIGA reads)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "optiga/optiga_util.h"
+#include "optiga/pal/pal.h"
+#include "optiga/pal/pal_os_event.h"
+#include "optiga_pool.h"
+#include "bench_util.h"
+
+#define BENCH_OID       (0xE0E0)
+#define BENCH_READ_LEN  (32)
+
+static SemaphoreHandle_t done;
+static volatile optiga_lib_status_t status;
+
+// The PAL event is serviced from the tick hook, like main.c does without APP_OPTIGA_EVENT_TASK
+void vApplicationTickHook(void) {
+    pal_os_event_trigger_registered_callback();
+}
+
+static void callback(void *context, optiga_lib_status_t return_status) {
+    (void) context;
+    status = return_status;
+    xSemaphoreGive(done);
+}
+
+static bool read_object(optiga_util_t *me) {
+    uint8_t data[BENCH_READ_LEN];
+    uint16_t length = sizeof(data);
+
+    if (OPTIGA_LIB_SUCCESS != optiga_util_read_data(me, BENCH_OID, 0, data, &length)) {
+        return false;
+    }
+    xSemaphoreTake(done, portMAX_DELAY);
+    return OPTIGA_LIB_SUCCESS == status;
+}
+
+static bool read_object_pooled(optiga_util_t *me) {
+    uint8_t data[BENCH_READ_LEN];
+    uint16_t length = sizeof(data);
+
+    optiga_pool_prepare(me);
+    return OPTIGA_LIB_SUCCESS == optiga_pool_wait(me, optiga_util_read_data(me, BENCH_OID, 0, data, &length));
+}
+
+// One operation the way the helpers used to do it
+static bool op_create(bool with_read) {
+    optiga_util_t *me = optiga_util_create(0, callback, NULL);
+    if (!me) {
+        return false;
+    }
+    bool ok = !with_read || read_object(me);
+    optiga_util_destroy(me);
+    return ok;
+}
+
+static bool op_pooled(bool with_read) {
+    optiga_util_t *me = optiga_pool_acquire_util();
+    if (!me) {
+        return false;
+    }
+    bool ok = !with_read || read_object_pooled(me);
+    optiga_pool_release_util(me);
+    return ok;
+}
+
+static void run(const char *name, bool (*op)(bool), bool with_read, unsigned long iterations) {
+    bench_timer_t timer;
+    bench_heap_t heap;
+    uint64_t ns, cycles;
+    unsigned long failures = 0;
+
+    op(with_read); // warm up
+    bench_heap_reset();
+    bench_timer_start(&timer);
+    for (unsigned long i = 0; i < iterations; i++) {
+        if (!op(with_read)) {
+            failures++;
+        }
+    }
+    bench_timer_stop(&timer, &ns, &cycles);
+    bench_heap_get(&heap);
+
+    printf("%-8s %-6s %12.1f ns/op %12.1f cycles/op %8.1f allocs/op %8lu failures\n",
+            name,
+            with_read ? "read" : "setup",
+            (double) ns / iterations,
+            (double) cycles / iterations,
+            (double) heap.allocs / iterations,
+            failures);
+}
+
+static void bench_task(void *arg) {
+    unsigned long iterations = bench_iterations(100000);
+    unsigned long reads = iterations / 1000 ? iterations / 1000 : 1;
+    optiga_util_t *me;
+
+    (void) arg;
+    done = xSemaphoreCreateBinary();
+    pal_init();
+    optiga_pool_init();
+
+    me = optiga_pool_acquire_util();
+    optiga_pool_prepare(me);
+    if (!me || OPTIGA_LIB_SUCCESS != optiga_pool_wait(me, optiga_util_open_application(me, 0))) {
+        printf("Error: Failed to open the OPTIGA application\n");
+        exit(1);
+    }
+    optiga_pool_release_util(me);
+
+    printf("%lu iterations, %lu reads of %u bytes\n\n", iterations, reads, BENCH_READ_LEN);
+    run("create", op_create, false, iterations);
+    run("pool", op_pooled, false, iterations);
+    run("create", op_create, true, reads);
+    run("pool", op_pooled, true, reads);
+    exit(0);
+}
+
+int main(void) {
+    xTaskCreate(bench_task, "Bench", configMINIMAL_STACK_SIZE * 4, NULL, 2, NULL);
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,156 @@
+//
+// Copyright: Avnet 2021
+//
+// Measures the CPU that a start-up task leaves to the App Task once its
+// work is done: spinning in while(1) at the App Task priority, like the
+// Optiga Client Task used to, against deleting itself (main.c).
+//
+// A task at APP_TASK_PRIORITY runs a fixed amount of work every
+// BENCH_APP_PERIOD_MS. The bench reports how long one unit of work takes
+// from start to end, the share of the CPU the task got and what was left to
+// the idle task, from the run-time stats (runtime_stats.c). One unit takes
+// BENCH_APP_WORK_MS when the task runs alone, several ticks like a publish
+// with its TLS write, so that time slicing with a spinning task shows in the
+// time per unit and in the units that miss their period.
+//
+// Usage: build/bench_startup_task  (BENCH_ITERATIONS overrides the loop
+// count of one unit of work)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "runtime_stats.h"
+#include "bench_util.h"
+
+#define BENCH_PRIORITY          (2)     // of the App Task and the Optiga Client Task
+#define BENCH_STARTUP_MS        (50)    // OPTIGA init and certificate read
+#define BENCH_APP_PERIOD_MS     (20)
+#define BENCH_APP_WORK_MS       (10)
+#define BENCH_CALIBRATION       (100000UL)
+#define BENCH_WINDOW_MS         (2000)
+
+typedef struct {
+    uint64_t units;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} bench_app_stats_t;
+
+static unsigned long work_iterations;
+static volatile uint32_t work_sink;
+static volatile bool startup_spin;
+static volatile bool startup_spinning;
+static bench_app_stats_t app_stats;
+
+void vApplicationTickHook(void) {
+}
+
+static void work(void) {
+    uint32_t x = work_sink;
+    for (unsigned long i = 0; i < work_iterations; i++) {
+        x = x * 1664525U + 1013904223U;
+    }
+    work_sink = x;
+}
+
+static void startup_task(void *arg) {
+    (void) arg;
+    vTaskDelay(pdMS_TO_TICKS(BENCH_STARTUP_MS));
+    if (startup_spin) {
+        startup_spinning = true;
+        while(1);
+    }
+    vTaskDelete(NULL);
+}
+
+static void app_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+
+    (void) arg;
+    for (;;) {
+        uint64_t start = bench_now_ns();
+        work();
+        uint64_t ns = bench_now_ns() - start;
+        app_stats.units++;
+        app_stats.total_ns += ns;
+        if (ns > app_stats.max_ns) {
+            app_stats.max_ns = ns;
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(BENCH_APP_PERIOD_MS));
+    }
+}
+
+static uint16_t cpu_permille(const runtime_stats_t *stats, const char *name) {
+    for (uint8_t i = 0; i < stats->task_count; i++) {
+        if (0 == strcmp(stats->tasks[i].name, name)) {
+            return stats->tasks[i].cpu_permille;
+        }
+    }
+    return 0;
+}
+
+static void run(const char *name, bool spin, uint64_t alone_ns) {
+    TaskHandle_t startup, app;
+    runtime_stats_t stats;
+
+    startup_spin = spin;
+    startup_spinning = false;
+    memset(&app_stats, 0, sizeof(app_stats));
+    xTaskCreate(startup_task, "Startup", configMINIMAL_STACK_SIZE * 2, NULL, BENCH_PRIORITY, &startup);
+    xTaskCreate(app_task, "App", configMINIMAL_STACK_SIZE * 4, NULL, BENCH_PRIORITY, &app);
+
+    // measured once the start-up work is over
+    vTaskDelay(pdMS_TO_TICKS(BENCH_STARTUP_MS * 2));
+    runtime_stats_sample(&stats);
+    memset(&app_stats, 0, sizeof(app_stats));
+    vTaskDelay(pdMS_TO_TICKS(BENCH_WINDOW_MS));
+    runtime_stats_sample(&stats);
+    bench_app_stats_t s = app_stats;
+
+    vTaskDelete(app);
+    if (startup_spinning) {
+        vTaskDelete(startup);
+    }
+    // the idle task frees the deleted tasks
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    printf("%-8s %8lu units %10.1f us/unit (max %8.1f, %4.2fx alone) %5.1f%% CPU app %5.1f%% idle\n",
+            name, (unsigned long) s.units,
+            s.units ? (double) s.total_ns / s.units / 1000 : 0.0, (double) s.max_ns / 1000,
+            s.units && alone_ns ? (double) s.total_ns / s.units / alone_ns : 0.0,
+            cpu_permille(&stats, "App") / 10.0, (1000 - stats.cpu_load_permille) / 10.0);
+}
+
+static void bench_task(void *arg) {
+    bench_timer_t timer;
+    uint64_t ns, cycles;
+
+    (void) arg;
+    // nothing else is ready at this priority
+    work_iterations = BENCH_CALIBRATION;
+    bench_timer_start(&timer);
+    work();
+    bench_timer_stop(&timer, &ns, &cycles);
+    work_iterations = bench_iterations(ns ? (unsigned long) (BENCH_CALIBRATION * BENCH_APP_WORK_MS * 1000000ULL / ns)
+            : BENCH_CALIBRATION);
+
+    bench_timer_start(&timer);
+    work();
+    bench_timer_stop(&timer, &ns, &cycles);
+    printf("%lu iterations of work take %.1f us alone, every %d ms\n\n", work_iterations, (double) ns / 1000,
+            BENCH_APP_PERIOD_MS);
+
+    run("spin", true, ns);
+    run("delete", false, ns);
+    exit(0);
+}
+
+int main(void) {
+    xTaskCreate(bench_task, "Bench", configMINIMAL_STACK_SIZE * 4, NULL, BENCH_PRIORITY + 1, NULL);
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,197 @@
+//
+// Copyright: Avnet 2021
+//
+// Compares the cost of building one publish_telemetry() message with the
+// IoTConnect C library (cJSON), with telemetry_writer.c (JSON) and with
+// telemetry_cbor.c (CBOR), for a single data point and for a batch of
+// APP_TELEMETRY_BATCH_SIZE data points. Every CBOR message is decoded back
+// into JSON and has to match the telemetry_writer.c output.
+//
+// Usage: build/bench_telemetry  (BENCH_ITERATIONS overrides the loop count)
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotconnect_lib.h"
+#include "telemetry_writer.h"
+#include "telemetry_cbor.h"
+#include "bench_util.h"
+#include "cbor_json.h"
+#include "app_config.h"
+
+#define BENCH_VERSION   "01.00.00" // APP_VERSION in app_task.c
+
+typedef struct {
+    const char *timestamp;
+    int32_t co2level;
+    float temperature;
+    float pressure;
+} bench_sample_t;
+
+// Taken every APP_TELEMETRY_SAMPLE_PERIOD_MS
+static const bench_sample_t samples[] = {
+    { "2021-09-01T12:34:56.000Z", 612, 23.45f, 1013.25f },
+    { "2021-09-01T12:35:06.000Z", 615, 23.47f, 1013.2f },
+    { "2021-09-01T12:35:16.000Z", 619, 23.5f, 1013.22f },
+    { "2021-09-01T12:35:26.000Z", 624, 23.51f, 1013.19f },
+    { "2021-09-01T12:35:36.000Z", 627, 23.53f, 1013.21f },
+    { "2021-09-01T12:35:46.000Z", 633, 23.56f, 1013.18f },
+    { "2021-09-01T12:35:56.000Z", 641, 23.6f, 1013.2f },
+    { "2021-09-01T12:36:06.000Z", 646, 23.61f, 1013.17f },
+};
+
+#define MAX_POINTS (sizeof(samples) / sizeof(samples[0]))
+
+static uint16_t points; // data points per message
+
+typedef struct {
+    const char *name;
+    const void *(*build)(size_t *len);
+    void (*release)(const void *msg);
+} serializer_t;
+
+static const void *build_iotcl(size_t *len) {
+    IotclMessageHandle msg = iotcl_telemetry_create();
+    for (uint16_t i = 0; i < points; i++) {
+        iotcl_telemetry_add_with_iso_time(msg, samples[i].timestamp);
+        iotcl_telemetry_set_string(msg, "version", BENCH_VERSION);
+        iotcl_telemetry_set_number(msg, "cpu", 3.123);
+        iotcl_telemetry_set_number(msg, "co2level", samples[i].co2level);
+        iotcl_telemetry_set_number(msg, "temperature", samples[i].temperature);
+        iotcl_telemetry_set_number(msg, "pressure", samples[i].pressure);
+    }
+    const char *str = iotcl_create_serialized_string(msg, false);
+    iotcl_telemetry_destroy(msg);
+    *len = str ? strlen(str) : 0;
+    return str;
+}
+
+static void release_iotcl(const void *msg) {
+    iotcl_destroy_serialized(msg);
+}
+
+static const void *build_writer(size_t *len) {
+    static char buffer[256 + 160 * MAX_POINTS];
+    telemetry_writer_t writer;
+
+    telemetry_writer_begin(&writer, buffer, sizeof(buffer), iotcl_get_config());
+    for (uint16_t i = 0; i < points; i++) {
+        telemetry_writer_add_point(&writer, samples[i].timestamp);
+        telemetry_writer_set_string(&writer, "version", BENCH_VERSION);
+        telemetry_writer_set_float(&writer, "cpu", 3.123f, 3);
+        telemetry_writer_set_int(&writer, "co2level", samples[i].co2level);
+        telemetry_writer_set_float(&writer, "temperature", samples[i].temperature, 2);
+        telemetry_writer_set_float(&writer, "pressure", samples[i].pressure, 2);
+    }
+    const char *str = telemetry_writer_finish(&writer);
+    *len = str ? strlen(str) : 0;
+    return str;
+}
+
+static const void *build_cbor(size_t *len) {
+    static uint8_t buffer[256 + 160 * MAX_POINTS];
+    telemetry_cbor_t writer;
+
+    telemetry_cbor_begin(&writer, buffer, sizeof(buffer), iotcl_get_config());
+    for (uint16_t i = 0; i < points; i++) {
+        telemetry_cbor_add_point(&writer, samples[i].timestamp);
+        telemetry_cbor_set_string(&writer, "version", BENCH_VERSION);
+        telemetry_cbor_set_float(&writer, "cpu", 3.123f, 3);
+        telemetry_cbor_set_int(&writer, "co2level", samples[i].co2level);
+        telemetry_cbor_set_float(&writer, "temperature", samples[i].temperature, 2);
+        telemetry_cbor_set_float(&writer, "pressure", samples[i].pressure, 2);
+    }
+    *len = telemetry_cbor_finish(&writer);
+    return *len ? buffer : NULL;
+}
+
+static const serializer_t serializers[] = {
+    { "iotcl", build_iotcl, release_iotcl },
+    { "writer", build_writer, NULL },
+    { "cbor", build_cbor, NULL },
+};
+
+static void run(const serializer_t *s, unsigned long iterations) {
+    bench_timer_t timer;
+    bench_heap_t heap;
+    uint64_t ns, cycles;
+    size_t bytes = 0;
+    size_t len;
+
+    // warm up caches and the allocator
+    const void *msg = s->build(&len);
+    if (msg && s->release) {
+        s->release(msg);
+    }
+
+    bench_heap_reset();
+    bench_timer_start(&timer);
+    for (unsigned long i = 0; i < iterations; i++) {
+        msg = s->build(&len);
+        if (msg) {
+            bytes += len;
+            if (s->release) {
+                s->release(msg);
+            }
+        }
+    }
+    bench_timer_stop(&timer, &ns, &cycles);
+    bench_heap_get(&heap);
+
+    printf("%-8s %10.1f ns/msg %10.1f cycles/msg %8zu bytes/msg %8.1f allocs/msg %8zu peak heap bytes\n",
+            s->name,
+            (double) ns / iterations,
+            (double) cycles / iterations,
+            bytes / iterations,
+            (double) heap.allocs / iterations,
+            heap.peak - heap.current);
+}
+
+// Decodes the CBOR message and compares it with the JSON one
+static bool verify_cbor(void) {
+    static char decoded[2 * (256 + 160 * MAX_POINTS)];
+    size_t json_len, cbor_len;
+    const char *json = build_writer(&json_len);
+    const uint8_t *cbor = build_cbor(&cbor_len);
+
+    if (!json || !cbor || cbor_to_json(cbor, cbor_len, decoded, sizeof(decoded)) < 0) {
+        printf("cbor: failed to encode or decode\n");
+        return false;
+    }
+    if (strcmp(json, decoded)) {
+        printf("cbor: round trip mismatch\n  json:    %s\n  decoded: %s\n", json, decoded);
+        return false;
+    }
+    printf("cbor: %zu bytes, decodes to the %zu bytes of JSON: %s\n", cbor_len, json_len, decoded);
+    return true;
+}
+
+int main(void) {
+    IotclConfig config;
+    unsigned long iterations = bench_iterations(100000);
+    const uint16_t batch = APP_TELEMETRY_BATCH_SIZE < MAX_POINTS ? APP_TELEMETRY_BATCH_SIZE : MAX_POINTS;
+    bool ok = true;
+
+    memset(&config, 0, sizeof(config));
+    config.device.cpid = IOTCONNECT_CPID;
+    config.device.duid = IOTCONNECT_DUID;
+    config.device.env = IOTCONNECT_ENV;
+    config.telemetry.dtg = "00000000-0000-0000-0000-000000000000";
+    if (!iotcl_init(&config)) {
+        printf("Error: Failed to initialize the IoTConnect Lib\n");
+        return 1;
+    }
+
+    printf("%lu iterations\n", iterations);
+    for (points = 1; points; points = points < batch ? batch : 0) {
+        printf("\n%u data points per message\n", (unsigned int) points);
+        ok = verify_cbor() && ok;
+        for (size_t i = 0; i < sizeof(serializers) / sizeof(serializers[0]); i++) {
+            run(&serializers[i], iterations);
+        }
+    }
+
+    iotcl_deinit();
+    return ok ? 0 : 1;
+}
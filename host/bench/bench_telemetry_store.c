@@ -0,0 +1,177 @@
+//
+// Copyright: Avnet 2021
+//
+// Throughput and wear of the telemetry flash store (telemetry_store.c) on
+// the simulated flash (shims/flash_sim.c), backed by a file.
+//
+// - append: samples written during an outage, a page write per full page
+// - replay: samples read back and consumed in APP_STORE_REPLAY_BATCH_SIZE messages
+// - cycles: repeated outages of 2.5 times the log capacity and full replays,
+//   with the erase cycles of the least and the most worn page
+// - recovery: the store is reopened like after a reset and has to return the
+//   samples that were written to flash
+//
+// Usage: build/bench_telemetry_store  (BENCH_ITERATIONS overrides the number of
+// samples, HOST_FLASH_FILE the backing file, HOST_FLASH_WRITE_US etc. add page
+// operation times, see shims/flash_sim.c)
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "host_sim.h"
+#include "telemetry_store.h"
+#include "bench_util.h"
+
+/* Erase cycles that the PSoC 6 flash is specified for */
+#define BENCH_FLASH_ENDURANCE (100000UL)
+
+static telemetry_store_t store;
+
+static void make_sample(uint32_t n, telemetry_sample_t *sample) {
+    memset(sample, 0, sizeof(*sample));
+    // one sample every 10 s from 2021-09-01T00:00:00
+    snprintf(sample->timestamp, sizeof(sample->timestamp), "2021-09-%02luT%02lu:%02lu:%02lu.000Z",
+            (unsigned long) (1 + n / 8640 % 28), (unsigned long) (n / 360 % 24),
+            (unsigned long) (n / 6 % 60), (unsigned long) (n % 6 * 10));
+    sample->co2level = (uint16_t) (400 + n % 600);
+    sample->temperature = 20.0f + (float) (n % 100) / 10.0f;
+    sample->pressure = 1000.0f + (float) (n % 300) / 10.0f;
+}
+
+static uint32_t replay_all(void) {
+    telemetry_sample_t sample;
+    uint32_t replayed = 0;
+
+    while (telemetry_store_count(&store)) {
+        uint32_t count = 0;
+        while (count < APP_STORE_REPLAY_BATCH_SIZE && telemetry_store_get(&store, count, &sample)) {
+            count++;
+        }
+        telemetry_store_consume(&store, count ? count : 1);
+        replayed += count;
+    }
+    return replayed;
+}
+
+static void report(const char *name, unsigned long samples, uint64_t ns) {
+    printf("%-10s %10lu samples %10.1f ns/sample %12.0f samples/s\n",
+            name, samples, (double) ns / samples, samples * 1e9 / (double) ns);
+}
+
+static bool check_recovery(void) {
+    telemetry_sample_t expected, sample;
+    const uint32_t written = (uint32_t) store.records_per_page * 3 + 5;
+
+    for (uint32_t n = 0; n < written; n++) {
+        make_sample(n, &sample);
+        telemetry_store_append(&store, &sample);
+    }
+    // the samples of the partial page in RAM are lost on a reset
+    if (!telemetry_store_init(&store) || telemetry_store_count(&store) != written - 5) {
+        printf("recovery: %lu samples instead of %lu\n",
+                (unsigned long) telemetry_store_count(&store), (unsigned long) (written - 5));
+        return false;
+    }
+    for (uint32_t n = 0; n < written - 5; n++) {
+        make_sample(n, &expected);
+        if (!telemetry_store_get(&store, n, &sample) || memcmp(&sample, &expected, sizeof(sample))) {
+            printf("recovery: sample %lu differs\n", (unsigned long) n);
+            return false;
+        }
+    }
+    replay_all();
+    if (!telemetry_store_init(&store) || telemetry_store_count(&store)) {
+        printf("recovery: replayed samples found again\n");
+        return false;
+    }
+    printf("recovery:  %lu samples recovered after a reset, none after they were replayed\n",
+            (unsigned long) (written - 5));
+    return true;
+}
+
+int main(void) {
+    static char path[] = "/tmp/bench_flash_XXXXXX";
+    unsigned long iterations = bench_iterations(100000);
+    telemetry_sample_t sample;
+    bench_timer_t timer;
+    host_sim_flash_stats_t flash;
+    uint64_t ns, cycles;
+    bool temporary = !getenv("HOST_FLASH_FILE");
+    bool ok;
+
+    if (temporary) {
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            perror(path);
+            return 1;
+        }
+        close(fd);
+        setenv("HOST_FLASH_FILE", path, 1);
+    }
+    // only the log, so that the wear figures cover its pages
+    char size[16];
+    snprintf(size, sizeof(size), "%lu", (unsigned long) APP_STORE_FLASH_SIZE);
+    setenv("HOST_FLASH_SIZE", size, 0);
+    if (!telemetry_store_init(&store)) {
+        return 1;
+    }
+    ok = check_recovery();
+
+    uint32_t capacity = (uint32_t) store.page_count * store.records_per_page;
+    printf("\n%lu samples, %lu sample log on %s\n", iterations, (unsigned long) capacity, getenv("HOST_FLASH_FILE"));
+
+    bench_timer_start(&timer);
+    for (unsigned long n = 0; n < iterations; n++) {
+        make_sample((uint32_t) n, &sample);
+        telemetry_store_append(&store, &sample);
+    }
+    bench_timer_stop(&timer, &ns, &cycles);
+    report("append", iterations, ns);
+
+    uint32_t stored = telemetry_store_count(&store);
+    bench_timer_start(&timer);
+    uint32_t replayed = replay_all();
+    bench_timer_stop(&timer, &ns, &cycles);
+    report("replay", replayed ? replayed : 1, ns);
+    if (replayed != stored) {
+        printf("replay: %lu of %lu samples\n", (unsigned long) replayed, (unsigned long) stored);
+        ok = false;
+    }
+
+    unsigned long total = 0;
+    bench_timer_start(&timer);
+    while (total < iterations) {
+        uint32_t outage = capacity * 5 / 2;
+        for (uint32_t n = 0; n < outage; n++) {
+            make_sample((uint32_t) (total + n), &sample);
+            telemetry_store_append(&store, &sample);
+        }
+        total += outage;
+        replay_all();
+    }
+    bench_timer_stop(&timer, &ns, &cycles);
+    report("cycles", total, ns);
+
+    host_sim_flash_stats(&flash);
+    telemetry_store_print_stats(&store);
+    printf("Flash: %lu pages, %llu page writes, %llu erases, erase cycles per page %lu to %lu\n",
+            (unsigned long) flash.pages, (unsigned long long) flash.programs, (unsigned long long) flash.erases,
+            (unsigned long) flash.min_page_erases, (unsigned long) flash.max_page_erases);
+    if (flash.erases) {
+        // samples that reach the flash per erase of the most worn page, at the measured wear
+        double samples_per_cycle = (double) store.stats.appended / flash.max_page_erases;
+        printf("Lifetime: %.3g samples until a page reaches %lu erase cycles (%.0f years at one sample every %d s)\n",
+                samples_per_cycle * BENCH_FLASH_ENDURANCE, BENCH_FLASH_ENDURANCE,
+                samples_per_cycle * BENCH_FLASH_ENDURANCE * APP_TELEMETRY_SAMPLE_PERIOD_MS / 1000.0 / 86400 / 365,
+                APP_TELEMETRY_SAMPLE_PERIOD_MS / 1000);
+    }
+
+    if (temporary) {
+        unlink(path);
+    }
+    return ok ? 0 : 1;
+}
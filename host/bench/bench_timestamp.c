@@ -0,0 +1,128 @@
+//
+// Copyright: Avnet 2021
+//
+// Compares the cost of a telemetry timestamp from iotcl_iso_timestamp_now()
+// (time(), gmtime() and strftime() in the IoTConnect C library) with
+// timestamp.c:
+//
+// - iotcl: iotcl_iso_timestamp_now() copied into a sample, as sensor_sampler.c did
+// - now_iso: timestamp_now_iso() copied into a sample
+// - format: timestamp_format_iso() of timestamps APP_TELEMETRY_SAMPLE_PERIOD_MS
+//   apart, the formatting alone, with a new hour prefix every 3600 s
+// - now_ms: timestamp_now_ms(), the integer epoch
+//
+// Every format result is checked against iotcl_to_iso_timestamp() for a
+// sweep of times from 1970 to 2100.
+//
+// Usage: build/bench_timestamp  (BENCH_ITERATIONS overrides the loop count)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "iotconnect_common.h"
+#include "app_config.h"
+#include "telemetry_sample.h"
+#include "timestamp.h"
+#include "bench_util.h"
+
+static telemetry_sample_t sample;
+static timestamp_formatter_t formatter;
+static int64_t next_ms;
+static volatile int64_t sink;
+
+// configUSE_TICK_HOOK is set for the application
+void vApplicationTickHook(void) {
+}
+
+static void op_iotcl(void) {
+    strncpy(sample.timestamp, iotcl_iso_timestamp_now(), sizeof(sample.timestamp) - 1);
+    sample.timestamp[sizeof(sample.timestamp) - 1] = '\0';
+}
+
+static void op_now_iso(void) {
+    memcpy(sample.timestamp, timestamp_now_iso(&formatter), sizeof(sample.timestamp));
+}
+
+static void op_format(void) {
+    sink = (int64_t) timestamp_format_iso(&formatter, next_ms)[0];
+    next_ms += APP_TELEMETRY_SAMPLE_PERIOD_MS;
+}
+
+static void op_now_ms(void) {
+    sink = timestamp_now_ms();
+}
+
+static void run(const char *name, void (*op)(void), unsigned long iterations) {
+    bench_timer_t timer;
+    uint64_t ns, cycles;
+
+    timestamp_formatter_init(&formatter);
+    next_ms = 1630499696000LL; // 2021-09-01T12:34:56.000Z
+    op();
+
+    bench_timer_start(&timer);
+    for (unsigned long i = 0; i < iterations; i++) {
+        op();
+    }
+    bench_timer_stop(&timer, &ns, &cycles);
+
+    printf("%-8s %10.1f ns/call %10.1f cycles/call\n",
+            name, (double) ns / iterations, (double) cycles / iterations);
+}
+
+// Same output as iotcl_to_iso_timestamp(), apart from the milliseconds
+static bool verify(void) {
+    const int64_t end_ms = 4102444800000LL; // 2100-01-01
+    char expected[TIMESTAMP_ISO_LEN];
+    unsigned long checked = 0;
+
+    timestamp_formatter_init(&formatter);
+    // steps that are not a multiple of a second, a minute or an hour, so that every digit changes
+    for (int64_t ms = 0; ms < end_ms; ms += 3599937LL) {
+        const char *iso = timestamp_format_iso(&formatter, ms);
+        snprintf(expected, sizeof(expected), "%.20s%03dZ", iotcl_to_iso_timestamp((time_t) (ms / 1000)), (int) (ms % 1000));
+        if (strcmp(iso, expected)) {
+            printf("format: %s instead of %s\n", iso, expected);
+            return false;
+        }
+        checked++;
+    }
+    printf("format: %lu timestamps from 1970 to 2100 match iotcl_to_iso_timestamp()\n", checked);
+    return true;
+}
+
+static void bench_task(void *arg) {
+    unsigned long iterations = bench_iterations(1000000);
+    bool ok;
+
+    (void) arg;
+    ok = verify();
+    timestamp_sync();
+
+    printf("\n%lu iterations\n", iterations);
+    run("iotcl", op_iotcl, iterations);
+    run("now_iso", op_now_iso, iterations);
+    run("format", op_format, iterations);
+    run("now_ms", op_now_ms, iterations);
+
+    // the tick based time has to agree with time() to the second
+    int64_t ticks_s = timestamp_now();
+    time_t clock_s = time(NULL);
+    printf("\nclock: timestamp_now() %lld, time() %lld, %s\n", (long long) ticks_s, (long long) clock_s, sample.timestamp);
+    if (ticks_s < clock_s - 1 || ticks_s > clock_s + 1) {
+        ok = false;
+    }
+    exit(ok ? 0 : 1);
+}
+
+int main(void) {
+    xTaskCreate(bench_task, "Bench", configMINIMAL_STACK_SIZE * 4, NULL, 2, NULL);
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,111 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bench_util.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static bench_heap_t heap;
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t bench_now_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+void bench_timer_start(bench_timer_t *t) {
+    t->start_ns = bench_now_ns();
+    t->start_cycles = bench_now_cycles();
+}
+
+void bench_timer_stop(const bench_timer_t *t, uint64_t *ns, uint64_t *cycles) {
+    uint64_t now_cycles = bench_now_cycles();
+    uint64_t now_ns = bench_now_ns();
+    *ns = now_ns - t->start_ns;
+    *cycles = now_cycles - t->start_cycles;
+}
+
+void bench_heap_reset(void) {
+    heap.peak = heap.current;
+    heap.allocs = 0;
+    heap.frees = 0;
+}
+
+void bench_heap_get(bench_heap_t *stats) {
+    *stats = heap;
+}
+
+unsigned long bench_iterations(unsigned long default_value) {
+    const char *value = getenv("BENCH_ITERATIONS");
+    unsigned long iterations = value ? strtoul(value, NULL, 0) : 0;
+    return iterations ? iterations : default_value;
+}
+
+static void account_alloc(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    heap.allocs++;
+    heap.current += malloc_usable_size(ptr);
+    if (heap.current > heap.peak) {
+        heap.peak = heap.current;
+    }
+}
+
+static void account_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    heap.frees++;
+    heap.current -= malloc_usable_size(ptr);
+}
+
+void *__wrap_malloc(size_t size) {
+    void *ptr = __real_malloc(size);
+    account_alloc(ptr);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    void *ptr = __real_calloc(nmemb, size);
+    account_alloc(ptr);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    account_free(ptr);
+    void *new_ptr = __real_realloc(ptr, size);
+    if (!new_ptr && ptr && size) {
+        // the original block is still allocated
+        account_alloc(ptr);
+        heap.allocs--;
+        return NULL;
+    }
+    account_alloc(new_ptr);
+    return new_ptr;
+}
+
+void __wrap_free(void *ptr) {
+    account_free(ptr);
+    __real_free(ptr);
+}
@@ -0,0 +1,47 @@
+//
+// Copyright: Avnet 2021
+//
+// Helpers shared by the host micro benchmarks.
+//
+// Time is taken from CLOCK_MONOTONIC and, on x86, from the TSC. Heap usage is
+// tracked by wrapping the libc allocator at link time
+// (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free, see host/Makefile).
+//
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t start_cycles;
+} bench_timer_t;
+
+typedef struct {
+    size_t current;     // bytes allocated right now
+    size_t peak;        // highest value of 'current' since bench_heap_reset()
+    uint64_t allocs;    // malloc/calloc/realloc calls since bench_heap_reset()
+    uint64_t frees;
+} bench_heap_t;
+
+uint64_t bench_now_ns(void);
+
+/* Returns 0 on targets without a cycle counter */
+uint64_t bench_now_cycles(void);
+
+void bench_timer_start(bench_timer_t *t);
+
+/* Elapsed time since bench_timer_start() */
+void bench_timer_stop(const bench_timer_t *t, uint64_t *ns, uint64_t *cycles);
+
+/* Restarts peak and call counting from the current heap usage */
+void bench_heap_reset(void);
+
+void bench_heap_get(bench_heap_t *stats);
+
+/* Number of iterations, overridable with BENCH_ITERATIONS */
+unsigned long bench_iterations(unsigned long default_value);
+
+#endif // BENCH_UTIL_H
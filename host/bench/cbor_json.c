@@ -0,0 +1,227 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cbor_json.h"
+
+#define MAX_DEPTH   (16)
+#define BREAK       (0xFFU)
+
+typedef struct {
+    const uint8_t *in;
+    size_t in_len;
+    size_t pos;
+    char *out;
+    size_t size;
+    size_t len;
+    bool failed;
+} decoder_t;
+
+static bool item(decoder_t *d, int depth);
+
+static void emit_raw(decoder_t *d, const char *data, size_t len) {
+    if (d->failed || len >= d->size - d->len) {
+        d->failed = true;
+        return;
+    }
+    memcpy(&d->out[d->len], data, len);
+    d->len += len;
+}
+
+static void emit(decoder_t *d, const char *str) {
+    emit_raw(d, str, strlen(str));
+}
+
+// Initial byte and argument. 'indefinite' is set for additional information 31.
+static bool head(decoder_t *d, uint8_t *major, uint64_t *value, bool *indefinite) {
+    if (d->pos >= d->in_len) {
+        return false;
+    }
+    uint8_t initial = d->in[d->pos++];
+    uint8_t info = initial & 0x1F;
+    size_t bytes = info < 24 ? 0 : info <= 27 ? (size_t) 1 << (info - 24) : 0;
+
+    *major = initial >> 5;
+    *indefinite = info == 31;
+    if ((info > 27 && info < 31) || bytes > d->in_len - d->pos) {
+        return false;
+    }
+    *value = info < 24 ? info : 0;
+    for (size_t i = 0; i < bytes; i++) {
+        *value = *value << 8 | d->in[d->pos++];
+    }
+    return true;
+}
+
+static bool at_break(decoder_t *d) {
+    if (d->pos < d->in_len && d->in[d->pos] == BREAK) {
+        d->pos++;
+        return true;
+    }
+    return false;
+}
+
+// Reads an integer item (major type 0 or 1)
+static bool integer(decoder_t *d, int64_t *value) {
+    uint8_t major;
+    uint64_t arg;
+    bool indefinite;
+
+    if (!head(d, &major, &arg, &indefinite) || indefinite || major > 1 || arg > INT64_MAX) {
+        return false;
+    }
+    *value = major ? -1 - (int64_t) arg : (int64_t) arg;
+    return true;
+}
+
+static void emit_int(decoder_t *d, int64_t value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lld", (long long) value);
+    emit(d, text);
+}
+
+static bool text(decoder_t *d, uint64_t len) {
+    static const char hex[] = "0123456789abcdef";
+
+    if (len > d->in_len - d->pos) {
+        return false;
+    }
+    emit(d, "\"");
+    for (uint64_t i = 0; i < len; i++) {
+        unsigned char c = d->in[d->pos++];
+        if (c == '"' || c == '\\') {
+            char esc[2] = { '\\', (char) c };
+            emit_raw(d, esc, sizeof(esc));
+        } else if (c < 0x20) {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+            emit_raw(d, esc, sizeof(esc));
+        } else {
+            emit_raw(d, (const char *) &c, 1);
+        }
+    }
+    emit(d, "\"");
+    return true;
+}
+
+// Items of an array (pairs == false) or a map, 'count' of them or up to a break
+static bool container(decoder_t *d, bool pairs, uint64_t count, bool indefinite, int depth) {
+    emit(d, pairs ? "{" : "[");
+    for (uint64_t i = 0; indefinite ? !at_break(d) : i < count; i++) {
+        if (i) {
+            emit(d, ",");
+        }
+        if (!item(d, depth + 1)) {
+            return false;
+        }
+        if (pairs) {
+            emit(d, ":");
+            if (!item(d, depth + 1)) {
+                return false;
+            }
+        }
+    }
+    emit(d, pairs ? "}" : "]");
+    return true;
+}
+
+static bool epoch_timestamp(decoder_t *d) {
+    int64_t epoch;
+    struct tm tm;
+    char iso[32];
+
+    if (!integer(d, &epoch)) {
+        return false;
+    }
+    time_t t = (time_t) epoch;
+    if (!gmtime_r(&t, &tm)) {
+        return false;
+    }
+    strftime(iso, sizeof(iso), "\"%Y-%m-%dT%H:%M:%S.000Z\"", &tm);
+    emit(d, iso);
+    return true;
+}
+
+// [exponent, mantissa] as a decimal number
+static bool decimal_fraction(decoder_t *d) {
+    uint8_t major;
+    uint64_t count;
+    bool indefinite;
+    int64_t exponent, mantissa;
+
+    if (!head(d, &major, &count, &indefinite) || major != 4 || indefinite || count != 2
+            || !integer(d, &exponent) || !integer(d, &mantissa) || exponent > 0 || exponent < -18) {
+        return false;
+    }
+
+    uint64_t scale = 1;
+    for (int64_t i = exponent; i < 0; i++) {
+        scale *= 10;
+    }
+    uint64_t magnitude = mantissa < 0 ? (uint64_t) -mantissa : (uint64_t) mantissa;
+    char number[48];
+    snprintf(number, sizeof(number), "%s%llu.%0*llu", mantissa < 0 ? "-" : "",
+            (unsigned long long) (magnitude / scale), (int) -exponent, (unsigned long long) (magnitude % scale));
+    emit(d, number);
+    return true;
+}
+
+static bool item(decoder_t *d, int depth) {
+    uint8_t major;
+    uint64_t arg;
+    bool indefinite;
+
+    if (depth > MAX_DEPTH || !head(d, &major, &arg, &indefinite)) {
+        return false;
+    }
+    if (indefinite && major != 4 && major != 5) {
+        return false; // indefinite strings are not used
+    }
+    switch (major) {
+    case 0:
+        if (arg > INT64_MAX) {
+            return false;
+        }
+        emit_int(d, (int64_t) arg);
+        return true;
+    case 1:
+        if (arg > INT64_MAX) {
+            return false;
+        }
+        emit_int(d, -1 - (int64_t) arg);
+        return true;
+    case 3:
+        return text(d, arg);
+    case 4:
+        return container(d, false, arg, indefinite, depth);
+    case 5:
+        return container(d, true, arg, indefinite, depth);
+    case 6:
+        if (arg == 1) {
+            return epoch_timestamp(d);
+        }
+        return arg == 4 && decimal_fraction(d);
+    case 7:
+        if (arg == 20 || arg == 21 || arg == 22) {
+            emit(d, arg == 20 ? "false" : arg == 21 ? "true" : "null");
+            return true;
+        }
+        return false;
+    default:
+        return false; // byte strings
+    }
+}
+
+long cbor_to_json(const uint8_t *cbor, size_t len, char *json, size_t size) {
+    decoder_t d = { .in = cbor, .in_len = len, .out = json, .size = size };
+
+    if (!size || !item(&d, 0) || d.pos != len || d.failed) {
+        return -1;
+    }
+    json[d.len] = '\0';
+    return (long) d.len;
+}
@@ -0,0 +1,23 @@
+//
+// Copyright: Avnet 2021
+//
+// Decodes the CBOR telemetry messages of source/telemetry_cbor.c back into
+// the compact JSON that telemetry_writer.c produces, so that both encodings
+// of a message can be compared byte for byte.
+//
+// Epoch timestamps (tag 1) become "YYYY-MM-DDTHH:MM:SS.000Z" strings and
+// decimal fractions (tag 4) become decimal numbers. Other tags, floating
+// point numbers and byte strings are not used by the encoder and rejected.
+//
+
+#ifndef CBOR_JSON_H
+#define CBOR_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Writes the NUL terminated JSON of the CBOR item in 'cbor' into 'json'.
+ * Returns the JSON length, or -1 if the input is malformed, has trailing bytes or the JSON does not fit. */
+long cbor_to_json(const uint8_t *cbor, size_t len, char *json, size_t size);
+
+#endif // CBOR_JSON_H
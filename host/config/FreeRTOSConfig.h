@@ -0,0 +1,99 @@
+//
+// Copyright: Avnet 2021
+//
+// FreeRTOS configuration for the Linux host build (POSIX port).
+// Scheduling related values mirror configs/FreeRTOSConfig.h so that the task
+// layout and timing of the application behave the same as on the target.
+//
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configTICK_RATE_HZ                      1000u
+#define configMAX_PRIORITIES                    7
+/* Every task runs on its own pthread, which needs at least PTHREAD_STACK_MIN */
+#define configMINIMAL_STACK_SIZE                4096
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configQUEUE_REGISTRY_SIZE               10
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  1
+#define configENABLE_BACKWARD_COMPATIBILITY     0
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 16
+
+/* Memory allocation related definitions. heap_3 wraps the libc malloc() */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configTOTAL_HEAP_SIZE                   10240
+#define configAPPLICATION_ALLOCATED_HEAP        0
+
+/* See configs/FreeRTOSConfig.h */
+#define APP_OPTIGA_EVENT_TASK                   (1)
+
+/* Hook function related definitions. Unlike on the target the tick hook is
+ * always on: the kernel is shared with the benches, which poll the OPTIGA PAL
+ * events from it (bench/bench_optiga_pool.c). */
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     1
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_MALLOC_FAILED_HOOK            1
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+
+/* Run time and task stats gathering related definitions. */
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+
+/* The run time counter is a free running 1 MHz timer (source/runtime_stats.c) */
+extern void runtime_stats_counter_init(void);
+extern uint32_t runtime_stats_counter(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    runtime_stats_counter_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()            runtime_stats_counter()
+
+/* Co-routine related definitions. */
+#define configUSE_CO_ROUTINES                   0
+#define configMAX_CO_ROUTINE_PRIORITIES         2
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               2
+#define configTIMER_QUEUE_LENGTH                10
+#define configTIMER_TASK_STACK_DEPTH            ( configMINIMAL_STACK_SIZE * 2 )
+
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xResumeFromISR                  1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_xTaskGetIdleTaskHandle          0
+#define INCLUDE_eTaskGetState                   0
+#define INCLUDE_xEventGroupSetBitFromISR        1
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xTaskAbortDelay                 0
+#define INCLUDE_xTaskGetHandle                  0
+#define INCLUDE_xTaskResumeFromISR              1
+
+#define configASSERT( x ) assert( x )
+
+/* The POSIX port has no way to tell interrupt context. The only callers are the
+ * OPTIGA completion callback and the OPTIGA event registration, which may run
+ * from the tick hook, and the FromISR API is safe to use from tasks as well on
+ * this port. */
+#define xPortIsInsideInterrupt()                pdTRUE
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,25 @@
+//
+// Copyright: Avnet 2021
+//
+// mbedTLS configuration for the Linux host build.
+// Starts from the target configuration and drops the options that are backed
+// by the OPTIGA mbedTLS port and the PSoC 6 platform, which are not part of
+// the host build.
+//
+
+#ifndef MBEDTLS_HOST_CONFIG_H
+#define MBEDTLS_HOST_CONFIG_H
+
+#include "mbedtls_user_config.h"
+
+#undef MBEDTLS_ECDH_GEN_PUBLIC_ALT
+#undef MBEDTLS_ECDSA_SIGN_ALT
+#undef MBEDTLS_ECDSA_VERIFY_ALT
+#undef MBEDTLS_ECDH_COMPUTE_SHARED_ALT
+#undef MBEDTLS_ECDSA_GENKEY_ALT
+
+#undef MBEDTLS_PLATFORM_TIME_ALT
+#undef MBEDTLS_ENTROPY_HARDWARE_ALT
+#undef MBEDTLS_NO_PLATFORM_ENTROPY
+
+#endif /* MBEDTLS_HOST_CONFIG_H */
@@ -0,0 +1,15 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the PSoC 6 peripheral driver library.
+//
+
+#ifndef CY_PDL_H
+#define CY_PDL_H
+
+#include "cy_utils.h"
+
+/* Work flash of the PSoC 6 (cy_device_headers.h) */
+#define CY_EM_EEPROM_BASE           (0x14000000UL)
+
+#endif // CY_PDL_H
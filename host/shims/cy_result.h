@@ -0,0 +1,30 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the ModusToolbox core-lib result type.
+//
+
+#ifndef CY_RESULT_H
+#define CY_RESULT_H
+
+#include <stdint.h>
+
+/* unsigned long like uint32_t on arm-none-eabi, so that format strings match */
+typedef unsigned long cy_rslt_t;
+
+#define CY_RSLT_SUCCESS ((cy_rslt_t)0x00000000U)
+
+#define CY_RSLT_TYPE_INFO                   (0U)
+#define CY_RSLT_TYPE_WARNING                (1U)
+#define CY_RSLT_TYPE_ERROR                  (2U)
+#define CY_RSLT_TYPE_FATAL                  (3U)
+
+#define CY_RSLT_MODULE_MIDDLEWARE_BASE      (0x0A00U)
+
+#define CY_RSLT_CREATE(type, module, code) \
+    ((cy_rslt_t)((((module) & 0x3FFFU) << 18U) | (((code) & 0xFFFFU) << 0U) | (((type) & 0x3U) << 16U)))
+
+/* Generic failure used by the simulated peripherals */
+#define CY_RSLT_SIM_ERROR ((cy_rslt_t)0x04000001U)
+
+#endif // CY_RESULT_H
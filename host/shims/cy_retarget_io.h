@@ -0,0 +1,17 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of retarget-io. The debug UART is the process stdout.
+//
+
+#ifndef CY_RETARGET_IO_H
+#define CY_RETARGET_IO_H
+
+#include <stdio.h>
+#include "cyhal.h"
+
+#define CY_RETARGET_IO_BAUDRATE     (115200)
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate);
+
+#endif // CY_RETARGET_IO_H
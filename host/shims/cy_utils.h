@@ -0,0 +1,27 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the ModusToolbox core-lib utilities and PDL system types.
+//
+
+#ifndef CY_UTILS_H
+#define CY_UTILS_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "cy_result.h"
+
+typedef float float32_t;
+typedef double float64_t;
+
+#define CY_ASSERT(x)                assert(x)
+#define CY_UNUSED_PARAMETER(x)      ((void)(x))
+#define CY_HALT()                   abort()
+
+/* Interrupts are owned by the FreeRTOS POSIX port on the host */
+#define __enable_irq()              do { } while (0)
+
+#endif // CY_UTILS_H
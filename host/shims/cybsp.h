@@ -0,0 +1,20 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the CYSBSYSKIT-DEV-01 board support package.
+//
+
+#ifndef CYBSP_H
+#define CYBSP_H
+
+#include "cyhal.h"
+
+#define CYBSP_I2C_SCL               P6_0
+#define CYBSP_I2C_SDA               P6_1
+#define CYBSP_USER_LED              P11_1
+#define CYBSP_DEBUG_UART_RX         P5_0
+#define CYBSP_DEBUG_UART_TX         P5_1
+
+cy_rslt_t cybsp_init(void);
+
+#endif // CYBSP_H
@@ -0,0 +1,52 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated board support package and debug UART.
+//
+// Set APP_HOST_RUN_SECONDS to terminate the process after the given number of
+// seconds, so that a run can be bounded in CI.
+//
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "cybsp.h"
+#include "cy_retarget_io.h"
+#include "host_sim.h"
+
+static void *run_limit_thread(void *arg) {
+    uint32_t seconds = (uint32_t) (uintptr_t) arg;
+    sleep(seconds);
+    printf("\nHost run time of %u seconds elapsed. Exiting.\n", (unsigned) seconds);
+    fflush(stdout);
+    _exit(0);
+    return NULL;
+}
+
+cy_rslt_t cybsp_init(void) {
+    uint32_t run_seconds = host_sim_config("APP_HOST_RUN_SECONDS", 0);
+    if (run_seconds) {
+        pthread_t thread;
+        sigset_t all_signals, previous;
+        // the FreeRTOS POSIX port drives its tick with a process wide signal,
+        // which must never be delivered to a thread the scheduler doesn't own
+        sigfillset(&all_signals);
+        pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+        int ret = pthread_create(&thread, NULL, run_limit_thread, (void *) (uintptr_t) run_seconds);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (0 != ret) {
+            return CY_RSLT_SIM_ERROR;
+        }
+        pthread_detach(thread);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate) {
+    (void) tx;
+    (void) rx;
+    (void) baudrate;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return CY_RSLT_SUCCESS;
+}
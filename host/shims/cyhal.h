@@ -0,0 +1,186 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the cyhal GPIO, I2C, timer, flash and system drivers.
+// GPIO writes are logged, simulated devices drive input pins and raise their
+// events with host_sim_gpio_drive(), I2C transfers are routed to the simulated devices in
+// xensiv_sim.c and take as long as the bytes would take on the real bus.
+// Timers count up from the host monotonic clock. Flash is kept in RAM or in
+// a file (see flash_sim.c). A system reset ends the process.
+//
+
+#ifndef CYHAL_H
+#define CYHAL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "cy_utils.h"
+
+typedef uint32_t cyhal_gpio_t;
+
+#define CYHAL_GET_GPIO(port, pin)   ((cyhal_gpio_t)(((port) << 3U) | (pin)))
+#define NC                          ((cyhal_gpio_t)0xFFFFFFFFU)
+
+#define P5_0                        CYHAL_GET_GPIO(5U, 0U)
+#define P5_1                        CYHAL_GET_GPIO(5U, 1U)
+#define P5_3                        CYHAL_GET_GPIO(5U, 3U)
+#define P5_5                        CYHAL_GET_GPIO(5U, 5U)
+#define P6_0                        CYHAL_GET_GPIO(6U, 0U)
+#define P6_1                        CYHAL_GET_GPIO(6U, 1U)
+#define P9_0                        CYHAL_GET_GPIO(9U, 0U)
+#define P9_1                        CYHAL_GET_GPIO(9U, 1U)
+#define P10_5                       CYHAL_GET_GPIO(10U, 5U)
+#define P11_1                       CYHAL_GET_GPIO(11U, 1U)
+
+typedef enum
+{
+    CYHAL_GPIO_DIR_INPUT,
+    CYHAL_GPIO_DIR_OUTPUT,
+    CYHAL_GPIO_DIR_BIDIRECTIONAL,
+} cyhal_gpio_direction_t;
+
+typedef enum
+{
+    CYHAL_GPIO_DRIVE_NONE,
+    CYHAL_GPIO_DRIVE_ANALOG,
+    CYHAL_GPIO_DRIVE_PULLUP,
+    CYHAL_GPIO_DRIVE_PULLDOWN,
+    CYHAL_GPIO_DRIVE_OPENDRAINDRIVESLOW,
+    CYHAL_GPIO_DRIVE_OPENDRAINDRIVESHIGH,
+    CYHAL_GPIO_DRIVE_STRONG,
+    CYHAL_GPIO_DRIVE_PULLUPDOWN,
+} cyhal_gpio_drive_mode_t;
+
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction, cyhal_gpio_drive_mode_t drive_mode, bool init_val);
+void cyhal_gpio_free(cyhal_gpio_t pin);
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value);
+bool cyhal_gpio_read(cyhal_gpio_t pin);
+
+typedef enum
+{
+    CYHAL_GPIO_IRQ_NONE = 0,
+    CYHAL_GPIO_IRQ_RISE = 1 << 0,
+    CYHAL_GPIO_IRQ_FALL = 1 << 1,
+    CYHAL_GPIO_IRQ_BOTH = (1 << 0) | (1 << 1),
+} cyhal_gpio_event_t;
+
+typedef void (*cyhal_gpio_event_callback_t)(void *callback_arg, cyhal_gpio_event_t event);
+
+#define CYHAL_ISR_PRIORITY_DEFAULT  (7U)
+
+void cyhal_gpio_register_callback(cyhal_gpio_t pin, cyhal_gpio_event_callback_t callback, void *callback_arg);
+void cyhal_gpio_enable_event(cyhal_gpio_t pin, cyhal_gpio_event_t event, uint8_t intr_priority, bool enable);
+
+#define CYHAL_I2C_MODE_MASTER       (false)
+#define CYHAL_I2C_MODE_SLAVE        (true)
+
+typedef struct
+{
+    bool is_slave;
+    uint16_t address;
+    uint32_t frequencyhal_hz;
+} cyhal_i2c_cfg_t;
+
+typedef enum
+{
+    CYHAL_I2C_EVENT_NONE = 0,
+    CYHAL_I2C_MASTER_WR_IN_FIFO_EVENT = 1 << 17,
+    CYHAL_I2C_MASTER_WR_CMPLT_EVENT = 1 << 18,
+    CYHAL_I2C_MASTER_RD_CMPLT_EVENT = 1 << 19,
+    CYHAL_I2C_MASTER_ERR_EVENT = 1 << 20,
+} cyhal_i2c_event_t;
+
+typedef void (*cyhal_i2c_event_callback_t)(void *callback_arg, cyhal_i2c_event_t event);
+
+typedef struct
+{
+    cyhal_gpio_t sda;
+    cyhal_gpio_t scl;
+    uint32_t frequency_hz;
+    // asynchronous transfers
+    cyhal_i2c_event_callback_t callback;
+    void *callback_arg;
+    cyhal_i2c_event_t enabled_events;
+    cyhal_i2c_event_t pending_event;
+    void *completion_timer;
+} cyhal_i2c_t;
+
+cy_rslt_t cyhal_i2c_init(cyhal_i2c_t *obj, cyhal_gpio_t sda, cyhal_gpio_t scl, const void *clk);
+void cyhal_i2c_free(cyhal_i2c_t *obj);
+cy_rslt_t cyhal_i2c_configure(cyhal_i2c_t *obj, const cyhal_i2c_cfg_t *cfg);
+cy_rslt_t cyhal_i2c_master_write(cyhal_i2c_t *obj, uint16_t dev_addr, const uint8_t *data, uint16_t size, uint32_t timeout, bool send_stop);
+cy_rslt_t cyhal_i2c_master_read(cyhal_i2c_t *obj, uint16_t dev_addr, uint8_t *data, uint16_t size, uint32_t timeout, bool send_stop);
+/* Writes tx, then reads rx after a repeated start. Either size may be 0. Completion is signalled by the events. */
+cy_rslt_t cyhal_i2c_master_transfer_async(cyhal_i2c_t *obj, uint16_t address, const void *tx, size_t tx_size, void *rx, size_t rx_size);
+cy_rslt_t cyhal_i2c_abort_async(cyhal_i2c_t *obj);
+void cyhal_i2c_register_callback(cyhal_i2c_t *obj, cyhal_i2c_event_callback_t callback, void *callback_arg);
+void cyhal_i2c_enable_event(cyhal_i2c_t *obj, cyhal_i2c_event_t event, uint8_t intr_priority, bool enable);
+
+typedef enum
+{
+    CYHAL_TIMER_DIR_UP,
+    CYHAL_TIMER_DIR_DOWN,
+    CYHAL_TIMER_DIR_UP_DOWN,
+} cyhal_timer_direction_t;
+
+typedef struct
+{
+    bool is_continuous;
+    cyhal_timer_direction_t direction;
+    bool is_compare;
+    uint32_t period;
+    uint32_t compare_value;
+    uint32_t value;
+} cyhal_timer_cfg_t;
+
+typedef struct
+{
+    uint32_t frequency_hz;
+    uint64_t start_us;
+    uint32_t value;
+    bool running;
+} cyhal_timer_t;
+
+cy_rslt_t cyhal_timer_init(cyhal_timer_t *obj, cyhal_gpio_t pin, const void *clk);
+void cyhal_timer_free(cyhal_timer_t *obj);
+cy_rslt_t cyhal_timer_configure(cyhal_timer_t *obj, const cyhal_timer_cfg_t *cfg);
+cy_rslt_t cyhal_timer_set_frequency(cyhal_timer_t *obj, uint32_t hz);
+cy_rslt_t cyhal_timer_start(cyhal_timer_t *obj);
+cy_rslt_t cyhal_timer_stop(cyhal_timer_t *obj);
+uint32_t cyhal_timer_read(const cyhal_timer_t *obj);
+
+typedef struct
+{
+    uint32_t start_address;
+    uint32_t size;
+    uint32_t sector_size;
+    uint32_t page_size;
+    uint8_t erase_value;
+} cyhal_flash_block_info_t;
+
+typedef struct
+{
+    uint8_t block_count;
+    const cyhal_flash_block_info_t *blocks;
+} cyhal_flash_info_t;
+
+typedef struct
+{
+    bool initialized;
+} cyhal_flash_t;
+
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj);
+void cyhal_flash_free(cyhal_flash_t *obj);
+void cyhal_flash_get_info(const cyhal_flash_t *obj, cyhal_flash_info_t *info);
+cy_rslt_t cyhal_flash_read(cyhal_flash_t *obj, uint32_t address, uint8_t *data, size_t size);
+/* Erases the page at 'address' */
+cy_rslt_t cyhal_flash_erase(cyhal_flash_t *obj, uint32_t address);
+/* Erases and programs one page */
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data);
+/* Programs one erased page */
+cy_rslt_t cyhal_flash_program(cyhal_flash_t *obj, uint32_t address, const uint32_t *data);
+
+/* Ends the process. With HOST_FLASH_FILE the flash contents survive it, like they survive a reset. */
+void cyhal_system_reset_device(void);
+
+#endif // CYHAL_H
@@ -0,0 +1,289 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated cyhal GPIO, I2C master and timer.
+//
+// I2C transfers are dispatched to the device attached at the target address
+// and hold the caller for the time the transfer takes on the wire:
+// 9 bit clocks per byte (including the address byte) at the configured bus
+// frequency, plus HOST_I2C_EXTRA_US of per-transfer overhead, plus the time
+// the device stretches the clock (its latency knob, see host_sim_i2c_attach()).
+// Asynchronous transfers exchange the data right away and signal completion
+// from the FreeRTOS timer task once that time has passed, rounded up to ticks.
+//
+// Timers only count up and wrap at 32 bits, whatever period is configured.
+//
+// A system reset exits the process, which a supervisor can restart.
+//
+
+#include <stdio.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "timers.h"
+#include "cyhal.h"
+#include "host_sim.h"
+
+#define SIM_MAX_GPIO            (16U * 8U)
+#define SIM_MAX_I2C_DEVICES     (8U)
+
+typedef struct {
+    cyhal_gpio_event_callback_t callback;
+    void *callback_arg;
+    cyhal_gpio_event_t enabled;
+} sim_gpio_event_t;
+
+typedef struct {
+    uint16_t address;
+    host_sim_i2c_handler_t handler;
+    void *ctx;
+    const char *latency_knob;
+} sim_i2c_device_t;
+
+static bool gpio_state[SIM_MAX_GPIO];
+static sim_gpio_event_t gpio_events[SIM_MAX_GPIO];
+static sim_i2c_device_t i2c_devices[SIM_MAX_I2C_DEVICES];
+static uint32_t i2c_device_count;
+
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction, cyhal_gpio_drive_mode_t drive_mode, bool init_val) {
+    (void) direction;
+    (void) drive_mode;
+    if (pin >= SIM_MAX_GPIO) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    gpio_state[pin] = init_val;
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_gpio_free(cyhal_gpio_t pin) {
+    (void) pin;
+}
+
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value) {
+    if (pin < SIM_MAX_GPIO) {
+        gpio_state[pin] = value;
+    }
+}
+
+bool cyhal_gpio_read(cyhal_gpio_t pin) {
+    return pin < SIM_MAX_GPIO ? gpio_state[pin] : false;
+}
+
+void cyhal_gpio_register_callback(cyhal_gpio_t pin, cyhal_gpio_event_callback_t callback, void *callback_arg) {
+    if (pin < SIM_MAX_GPIO) {
+        gpio_events[pin].callback = callback;
+        gpio_events[pin].callback_arg = callback_arg;
+    }
+}
+
+void cyhal_gpio_enable_event(cyhal_gpio_t pin, cyhal_gpio_event_t event, uint8_t intr_priority, bool enable) {
+    (void) intr_priority;
+    if (pin < SIM_MAX_GPIO) {
+        gpio_events[pin].enabled = enable
+                ? (cyhal_gpio_event_t) (gpio_events[pin].enabled | event)
+                : (cyhal_gpio_event_t) (gpio_events[pin].enabled & ~event);
+    }
+}
+
+void host_sim_gpio_drive(cyhal_gpio_t pin, bool value) {
+    if (pin >= SIM_MAX_GPIO || gpio_state[pin] == value) {
+        return;
+    }
+    gpio_state[pin] = value;
+
+    cyhal_gpio_event_t edge = value ? CYHAL_GPIO_IRQ_RISE : CYHAL_GPIO_IRQ_FALL;
+    sim_gpio_event_t *event = &gpio_events[pin];
+    if (event->callback && (event->enabled & edge)) {
+        event->callback(event->callback_arg, edge);
+    }
+}
+
+void host_sim_i2c_attach(uint16_t address, host_sim_i2c_handler_t handler, void *ctx, const char *latency_knob) {
+    sim_i2c_device_t *device = NULL;
+    for (uint32_t i = 0; i < i2c_device_count; i++) {
+        if (i2c_devices[i].address == address) {
+            device = &i2c_devices[i];
+        }
+    }
+    if (!device) {
+        CY_ASSERT(i2c_device_count < SIM_MAX_I2C_DEVICES);
+        device = &i2c_devices[i2c_device_count++];
+        device->address = address;
+    }
+    device->handler = handler;
+    device->ctx = ctx;
+    device->latency_knob = latency_knob;
+}
+
+static sim_i2c_device_t *find_device(uint16_t address) {
+    for (uint32_t i = 0; i < i2c_device_count; i++) {
+        if (i2c_devices[i].address == address) {
+            return &i2c_devices[i];
+        }
+    }
+    return NULL;
+}
+
+cy_rslt_t cyhal_i2c_init(cyhal_i2c_t *obj, cyhal_gpio_t sda, cyhal_gpio_t scl, const void *clk) {
+    (void) clk;
+    memset(obj, 0, sizeof(*obj));
+    obj->sda = sda;
+    obj->scl = scl;
+    obj->frequency_hz = 100000U;
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_i2c_free(cyhal_i2c_t *obj) {
+    (void) obj;
+}
+
+cy_rslt_t cyhal_i2c_configure(cyhal_i2c_t *obj, const cyhal_i2c_cfg_t *cfg) {
+    if (cfg->is_slave || cfg->frequencyhal_hz == 0) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    obj->frequency_hz = cfg->frequencyhal_hz;
+    return CY_RSLT_SUCCESS;
+}
+
+// Time a transfer of 'size' bytes holds the bus
+static uint32_t transfer_us(const cyhal_i2c_t *obj, const sim_i2c_device_t *device, size_t size) {
+    uint64_t bits = 9ULL * (size + 1U);
+    uint32_t us = (uint32_t) (bits * 1000000ULL / obj->frequency_hz) + host_sim_config("HOST_I2C_EXTRA_US", 20);
+    if (device && device->latency_knob) {
+        us += host_sim_config(device->latency_knob, 0);
+    }
+    return us;
+}
+
+static cy_rslt_t exchange(const sim_i2c_device_t *device, bool is_read, uint8_t *data, uint16_t size) {
+    // address NACK
+    return device ? device->handler(device->ctx, is_read, data, size) : CY_RSLT_SIM_ERROR;
+}
+
+static cy_rslt_t i2c_transfer(cyhal_i2c_t *obj, uint16_t dev_addr, bool is_read, uint8_t *data, uint16_t size) {
+    const sim_i2c_device_t *device = find_device(dev_addr);
+    host_sim_busy_us(transfer_us(obj, device, size));
+    return exchange(device, is_read, data, size);
+}
+
+cy_rslt_t cyhal_i2c_master_write(cyhal_i2c_t *obj, uint16_t dev_addr, const uint8_t *data, uint16_t size, uint32_t timeout, bool send_stop) {
+    (void) timeout;
+    (void) send_stop;
+    return i2c_transfer(obj, dev_addr, false, (uint8_t *) data, size);
+}
+
+cy_rslt_t cyhal_i2c_master_read(cyhal_i2c_t *obj, uint16_t dev_addr, uint8_t *data, uint16_t size, uint32_t timeout, bool send_stop) {
+    (void) timeout;
+    (void) send_stop;
+    return i2c_transfer(obj, dev_addr, true, data, size);
+}
+
+static void async_completion(TimerHandle_t timer) {
+    cyhal_i2c_t *obj = (cyhal_i2c_t *) pvTimerGetTimerID(timer);
+    cyhal_i2c_event_t event = obj->pending_event;
+
+    obj->pending_event = CYHAL_I2C_EVENT_NONE;
+    if (obj->callback && (obj->enabled_events & event)) {
+        obj->callback(obj->callback_arg, event);
+    }
+}
+
+cy_rslt_t cyhal_i2c_master_transfer_async(cyhal_i2c_t *obj, uint16_t address, const void *tx, size_t tx_size, void *rx, size_t rx_size) {
+    const sim_i2c_device_t *device = find_device(address);
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t us = 0;
+
+    if (obj->pending_event != CYHAL_I2C_EVENT_NONE || tx_size > UINT16_MAX || rx_size > UINT16_MAX) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    if (tx_size) {
+        us += transfer_us(obj, device, tx_size);
+        result = exchange(device, false, (uint8_t *) tx, (uint16_t) tx_size);
+    }
+    if (result == CY_RSLT_SUCCESS && rx_size) {
+        us += transfer_us(obj, device, rx_size);
+        result = exchange(device, true, (uint8_t *) rx, (uint16_t) rx_size);
+    }
+    obj->pending_event = result != CY_RSLT_SUCCESS ? CYHAL_I2C_MASTER_ERR_EVENT
+            : rx_size ? CYHAL_I2C_MASTER_RD_CMPLT_EVENT : CYHAL_I2C_MASTER_WR_CMPLT_EVENT;
+
+    if (!obj->completion_timer) {
+        obj->completion_timer = xTimerCreate("I2C sim", 1, pdFALSE, obj, async_completion);
+    }
+    TickType_t ticks = pdMS_TO_TICKS((us + 999U) / 1000U);
+    xTimerChangePeriod((TimerHandle_t) obj->completion_timer, ticks ? ticks : 1, portMAX_DELAY);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_i2c_abort_async(cyhal_i2c_t *obj) {
+    if (obj->completion_timer) {
+        xTimerStop((TimerHandle_t) obj->completion_timer, portMAX_DELAY);
+    }
+    obj->pending_event = CYHAL_I2C_EVENT_NONE;
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_i2c_register_callback(cyhal_i2c_t *obj, cyhal_i2c_event_callback_t callback, void *callback_arg) {
+    obj->callback = callback;
+    obj->callback_arg = callback_arg;
+}
+
+void cyhal_i2c_enable_event(cyhal_i2c_t *obj, cyhal_i2c_event_t event, uint8_t intr_priority, bool enable) {
+    (void) intr_priority;
+    obj->enabled_events = enable
+            ? (cyhal_i2c_event_t) (obj->enabled_events | event)
+            : (cyhal_i2c_event_t) (obj->enabled_events & ~event);
+}
+
+cy_rslt_t cyhal_timer_init(cyhal_timer_t *obj, cyhal_gpio_t pin, const void *clk) {
+    (void) pin;
+    (void) clk;
+    memset(obj, 0, sizeof(*obj));
+    obj->frequency_hz = 1000000U;
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_timer_free(cyhal_timer_t *obj) {
+    obj->running = false;
+}
+
+cy_rslt_t cyhal_timer_configure(cyhal_timer_t *obj, const cyhal_timer_cfg_t *cfg) {
+    if (cfg->direction != CYHAL_TIMER_DIR_UP) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    obj->value = cfg->value;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_set_frequency(cyhal_timer_t *obj, uint32_t hz) {
+    if (hz == 0 || hz > 1000000U) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    obj->frequency_hz = hz;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_start(cyhal_timer_t *obj) {
+    obj->start_us = host_sim_now_us();
+    obj->running = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_stop(cyhal_timer_t *obj) {
+    obj->value = cyhal_timer_read(obj);
+    obj->running = false;
+    return CY_RSLT_SUCCESS;
+}
+
+uint32_t cyhal_timer_read(const cyhal_timer_t *obj) {
+    if (!obj->running) {
+        return obj->value;
+    }
+    uint64_t elapsed_us = host_sim_now_us() - obj->start_us;
+    return obj->value + (uint32_t) (elapsed_us * obj->frequency_hz / 1000000U);
+}
+
+void cyhal_system_reset_device(void) {
+    printf("\nSystem reset. Exiting.\n");
+    fflush(stdout);
+    _exit(0);
+}
@@ -0,0 +1,172 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated cyhal flash: one block of HOST_FLASH_SIZE bytes (default 32 KB)
+// at the address of the PSoC 6 work flash, with 512 byte pages that erase to 0.
+//
+// The contents are kept in RAM. With HOST_FLASH_FILE set they are loaded from
+// and written through to that file, so that they survive a restart of the
+// application like the real flash does. HOST_FLASH_WRITE_US, HOST_FLASH_ERASE_US
+// and HOST_FLASH_PROGRAM_US hold the caller for as long as a page operation
+// takes (default 0). Every page counts its erase cycles, see host_sim_flash_stats().
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "host_sim.h"
+
+#define SIM_FLASH_BASE          CY_EM_EEPROM_BASE
+#define SIM_FLASH_PAGE_SIZE     (512U)
+#define SIM_FLASH_ERASE_VALUE   (0x00U)
+
+static cyhal_flash_block_info_t block;
+static uint8_t *image;
+static uint32_t *page_erases;
+static FILE *backing;
+static host_sim_flash_stats_t stats;
+
+static bool setup(void) {
+    if (image) {
+        return true;
+    }
+    uint32_t size = host_sim_config("HOST_FLASH_SIZE", 32768);
+    size -= size % SIM_FLASH_PAGE_SIZE;
+    block.start_address = SIM_FLASH_BASE;
+    block.size = size;
+    block.sector_size = size;
+    block.page_size = SIM_FLASH_PAGE_SIZE;
+    block.erase_value = SIM_FLASH_ERASE_VALUE;
+
+    image = malloc(size);
+    page_erases = calloc(size / SIM_FLASH_PAGE_SIZE, sizeof(uint32_t));
+    if (!image || !page_erases) {
+        return false;
+    }
+    memset(image, SIM_FLASH_ERASE_VALUE, size);
+
+    const char *path = getenv("HOST_FLASH_FILE");
+    if (path && *path) {
+        backing = fopen(path, "r+b");
+        if (backing) {
+            size_t loaded = fread(image, 1, size, backing);
+            printf("Sim: loaded %u bytes of flash from %s\n", (unsigned) loaded, path);
+        } else if (!(backing = fopen(path, "w+b"))) {
+            perror(path);
+        }
+    }
+    return true;
+}
+
+static bool page_offset(uint32_t address, uint32_t *offset) {
+    if (!setup() || address < block.start_address || address - block.start_address >= block.size
+            || (address - block.start_address) % SIM_FLASH_PAGE_SIZE) {
+        return false;
+    }
+    *offset = address - block.start_address;
+    return true;
+}
+
+static void store_page(uint32_t offset) {
+    if (backing) {
+        fseek(backing, (long) offset, SEEK_SET);
+        fwrite(&image[offset], 1, SIM_FLASH_PAGE_SIZE, backing);
+        fflush(backing);
+    }
+}
+
+static void erase_page(uint32_t offset) {
+    memset(&image[offset], SIM_FLASH_ERASE_VALUE, SIM_FLASH_PAGE_SIZE);
+    page_erases[offset / SIM_FLASH_PAGE_SIZE]++;
+    stats.erases++;
+}
+
+cy_rslt_t cyhal_flash_init(cyhal_flash_t *obj) {
+    obj->initialized = setup();
+    return obj->initialized ? CY_RSLT_SUCCESS : CY_RSLT_SIM_ERROR;
+}
+
+void cyhal_flash_free(cyhal_flash_t *obj) {
+    obj->initialized = false;
+}
+
+void cyhal_flash_get_info(const cyhal_flash_t *obj, cyhal_flash_info_t *info) {
+    (void) obj;
+    info->block_count = 1;
+    info->blocks = &block;
+}
+
+cy_rslt_t cyhal_flash_read(cyhal_flash_t *obj, uint32_t address, uint8_t *data, size_t size) {
+    (void) obj;
+    if (!setup() || address < block.start_address || address - block.start_address > block.size
+            || size > block.size - (address - block.start_address)) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    memcpy(data, &image[address - block.start_address], size);
+    stats.bytes_read += size;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_flash_erase(cyhal_flash_t *obj, uint32_t address) {
+    uint32_t offset;
+
+    (void) obj;
+    if (!page_offset(address, &offset)) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    host_sim_busy_us(host_sim_config("HOST_FLASH_ERASE_US", 0));
+    erase_page(offset);
+    store_page(offset);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_flash_write(cyhal_flash_t *obj, uint32_t address, const uint32_t *data) {
+    uint32_t offset;
+
+    (void) obj;
+    if (!page_offset(address, &offset)) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    host_sim_busy_us(host_sim_config("HOST_FLASH_WRITE_US", 0));
+    erase_page(offset);
+    memcpy(&image[offset], data, SIM_FLASH_PAGE_SIZE);
+    stats.programs++;
+    store_page(offset);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_flash_program(cyhal_flash_t *obj, uint32_t address, const uint32_t *data) {
+    uint32_t offset;
+
+    (void) obj;
+    if (!page_offset(address, &offset)) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    host_sim_busy_us(host_sim_config("HOST_FLASH_PROGRAM_US", 0));
+    // programming can only clear bits of the erase value
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (uint32_t i = 0; i < SIM_FLASH_PAGE_SIZE; i++) {
+        image[offset + i] = SIM_FLASH_ERASE_VALUE ? image[offset + i] & bytes[i] : image[offset + i] | bytes[i];
+    }
+    stats.programs++;
+    store_page(offset);
+    return CY_RSLT_SUCCESS;
+}
+
+void host_sim_flash_stats(host_sim_flash_stats_t *out) {
+    *out = stats;
+    out->pages = setup() ? block.size / SIM_FLASH_PAGE_SIZE : 0;
+    out->min_page_erases = out->pages ? UINT32_MAX : 0;
+    out->max_page_erases = 0;
+    for (uint32_t i = 0; i < out->pages; i++) {
+        if (page_erases[i] < out->min_page_erases) {
+            out->min_page_erases = page_erases[i];
+        }
+        if (page_erases[i] > out->max_page_erases) {
+            out->max_page_erases = page_erases[i];
+        }
+    }
+}
@@ -0,0 +1,36 @@
+//
+// Copyright: Avnet 2021
+//
+// FreeRTOS application hooks that the ModusToolbox RTOS abstraction provides
+// on the target.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+void vApplicationMallocFailedHook(void) {
+    printf("Error: FreeRTOS heap allocation failed\n");
+    abort();
+}
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+        uint32_t *pulIdleTaskStackSize) {
+    static StaticTask_t idle_task_tcb;
+    static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+        uint32_t *pulTimerTaskStackSize) {
+    static StaticTask_t timer_task_tcb;
+    static StackType_t timer_task_stack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timer_task_tcb;
+    *ppxTimerTaskStackBuffer = timer_task_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
@@ -0,0 +1,36 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host_sim.h"
+
+uint32_t host_sim_config(const char *name, uint32_t default_value) {
+    const char *value = getenv(name);
+    if (!value || !*value) {
+        return default_value;
+    }
+    return (uint32_t) strtoul(value, NULL, 0);
+}
+
+uint64_t host_sim_now_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000u + (uint64_t) now.tv_nsec / 1000u;
+}
+
+void host_sim_busy_us(uint32_t us) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += us / 1000000u;
+    deadline.tv_nsec += (long) (us % 1000000u) * 1000;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    // the FreeRTOS tick signal interrupts the sleep, so keep going until the deadline
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Copyright: Avnet 2021
+//
+// Common helpers of the simulated peripherals.
+//
+// Every simulation knob is read from an environment variable with the given
+// name, so the same binary can model slow sensors, lossy links or slow cloud
+// endpoints without being rebuilt.
+//
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cy_result.h"
+#include "cyhal.h"
+
+/* Board wiring of the simulated devices (see source/sensor_sampler.c) */
+#define HOST_SIM_PASCO2_INT_PIN     P5_5
+
+/* Handler of a simulated I2C device. 'is_read' selects the direction. */
+typedef cy_rslt_t (*host_sim_i2c_handler_t)(void *ctx, bool is_read, uint8_t *data, uint16_t size);
+
+uint32_t host_sim_config(const char *name, uint32_t default_value);
+
+uint64_t host_sim_now_us(void);
+
+/* Holds the calling task for 'us' microseconds, like a blocking peripheral access would */
+void host_sim_busy_us(uint32_t us);
+
+/* Drives an input pin from a simulated device. An enabled event callback runs in the caller's context. */
+void host_sim_gpio_drive(cyhal_gpio_t pin, bool value);
+
+/* Attaches a simulated I2C device. The environment variable 'latency_knob' (may be NULL) sets how many
+ * microseconds the device stretches the clock on every transfer, to model a slow device. */
+void host_sim_i2c_attach(uint16_t address, host_sim_i2c_handler_t handler, void *ctx, const char *latency_knob);
+
+typedef struct {
+    uint32_t pages;
+    uint64_t programs;          // page writes and programs
+    uint64_t erases;            // page erases, including those of page writes
+    uint64_t bytes_read;
+    uint32_t min_page_erases;   // erase cycles of the least and the most worn page
+    uint32_t max_page_erases;
+} host_sim_flash_stats_t;
+
+/* Usage of the simulated flash since the start */
+void host_sim_flash_stats(host_sim_flash_stats_t *stats);
+
+#endif // HOST_SIM_H
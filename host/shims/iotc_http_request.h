@@ -0,0 +1,20 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the IoTConnect SDK HTTPS client, which iotconnect_sdk_init()
+// uses for the discovery and sync requests. Simulated by iotc_http_sim.c.
+//
+
+#ifndef IOTC_HTTP_REQUEST_H
+#define IOTC_HTTP_REQUEST_H
+
+typedef struct IotConnectHttpResponse {
+    char *data;             // response body, allocated with malloc(), NULL on failure
+} IotConnectHttpResponse;
+
+/* GET if send_str is NULL, otherwise POST of send_str. Returns 0 on success. */
+int iotconnect_https_request(IotConnectHttpResponse *response, const char *host, const char *path, const char *send_str);
+
+void iotconnect_free_https_response(IotConnectHttpResponse *response);
+
+#endif // IOTC_HTTP_REQUEST_H
@@ -0,0 +1,49 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated IoTConnect discovery and sync HTTPS requests. Each request takes
+// HOST_IOTC_DISCOVERY_MS (GET) or HOST_IOTC_SYNC_MS (POST), the time of a TLS
+// handshake and the request, and returns a canned response.
+//
+// Kept apart from iotconnect_sim.c, so that the calls of iotconnect_sdk_init()
+// go through -Wl,--wrap=iotconnect_https_request like on the target.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "iotc_http_request.h"
+#include "host_sim.h"
+
+#define SIM_DISCOVERY_RESPONSE \
+    "{\"baseUrl\":\"https://sim-agent.iotconnect.io/api/2.0/agent/\",\"log:mqtt\":{\"hn\":\"\",\"un\":\"\",\"pwd\":\"\",\"topic\":\"\"},\"pf\":\"az\"}"
+
+#define SIM_SYNC_RESPONSE \
+    "{\"d\":{\"ec\":0,\"ct\":200,\"ds\":0,\"dtg\":\"00000000-0000-0000-0000-000000000000\"," \
+    "\"p\":{\"n\":\"mqtt\",\"h\":\"sim-hub.azure-devices.net\",\"p\":8883,\"id\":\"your-cpid-device-id\"," \
+    "\"un\":\"sim-hub.azure-devices.net/your-cpid-device-id/?api-version=2018-06-30\",\"pwd\":\"\"," \
+    "\"topics\":{\"rpt\":\"devices/your-cpid-device-id/messages/events/cd=sim&v=2.1&msgtype=rpt\"," \
+    "\"ack\":\"devices/your-cpid-device-id/messages/events/cd=sim&v=2.1&msgtype=ack\"," \
+    "\"c2d\":\"devices/your-cpid-device-id/messages/devicebound/#\"}}," \
+    "\"has\":{\"d\":0,\"attr\":1,\"set\":0,\"r\":0,\"ota\":0}}}"
+
+static uint32_t requests;
+
+int iotconnect_https_request(IotConnectHttpResponse *response, const char *host, const char *path, const char *send_str) {
+    bool sync = send_str != NULL;
+
+    requests++;
+    vTaskDelay(pdMS_TO_TICKS(host_sim_config(sync ? "HOST_IOTC_SYNC_MS" : "HOST_IOTC_DISCOVERY_MS", sync ? 600 : 800)));
+    response->data = strdup(sync ? SIM_SYNC_RESPONSE : SIM_DISCOVERY_RESPONSE);
+    if (!host_sim_config("HOST_IOTC_QUIET", 0)) {
+        printf("Sim: HTTPS %s https://%s%s\n", sync ? "POST" : "GET", host, path);
+    }
+    return response->data ? 0 : -1;
+}
+
+void iotconnect_free_https_response(IotConnectHttpResponse *response) {
+    free(response->data);
+    response->data = NULL;
+}
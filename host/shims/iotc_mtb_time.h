@@ -0,0 +1,13 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the IoTConnect SDK SNTP helper. The host clock is already
+// synchronized, so only the SNTP round trip time is simulated.
+//
+
+#ifndef IOTC_MTB_TIME_H
+#define IOTC_MTB_TIME_H
+
+int iotc_mtb_time_obtain(const char *server);
+
+#endif // IOTC_MTB_TIME_H
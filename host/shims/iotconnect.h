@@ -0,0 +1,68 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the IoTConnect ModusToolbox SDK client.
+// Message building uses the real IoTConnect C library; discovery, sync and the
+// MQTT connection are simulated by iotconnect_sim.c.
+//
+
+#ifndef IOTCONNECT_H
+#define IOTCONNECT_H
+
+#include <stdbool.h>
+#include "cy_result.h"
+#include "iotconnect_lib.h"
+#include "iotconnect_telemetry.h"
+
+typedef enum
+{
+    IOTC_CS_UNDEFINED,
+    IOTC_CS_MQTT_CONNECTED,
+    IOTC_CS_MQTT_DISCONNECTED
+} IotConnectConnectionStatus;
+
+typedef void (*IotConnectStatusCallback)(IotConnectConnectionStatus data);
+
+typedef enum
+{
+    IOTC_AT_UNDEFINED = 0,
+    IOTC_AT_X509 = 1,
+    IOTC_AT_SYMMETRIC_KEY = 2,
+    IOTC_AT_TPM = 4,
+    IOTC_AT_TOKEN = 0x7FFFFFFF
+} IotConnectAuthType;
+
+typedef struct
+{
+    const char *device_cert;
+    const char *device_key;
+} IotConnectX509AuthInfo;
+
+typedef struct
+{
+    IotConnectAuthType type;
+    union
+    {
+        IotConnectX509AuthInfo cert_info;
+        char *symmetric_key;
+        char *scope_id;
+    } data;
+} IotConnectAuthInfo;
+
+typedef struct
+{
+    char *env;
+    char *cpid;
+    char *duid;
+    IotConnectAuthInfo auth;
+    IotConnectStatusCallback status_cb;
+} IotConnectClientConfig;
+
+IotConnectClientConfig *iotconnect_sdk_init_and_get_config(void);
+cy_rslt_t iotconnect_sdk_init(void);
+bool iotconnect_sdk_is_connected(void);
+IotclConfig *iotconnect_sdk_get_lib_config(void);
+void iotconnect_sdk_send_packet(const char *data);
+void iotconnect_sdk_disconnect(void);
+
+#endif // IOTCONNECT_H
@@ -0,0 +1,142 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated IoTConnect SDK client.
+//
+// iotconnect_sdk_init() makes the HTTPS discovery and sync requests like the
+// SDK does (simulated by iotc_http_sim.c), takes the time of the TLS + MQTT
+// connection, then initializes the real IoTConnect C library so that
+// telemetry is built exactly like on the target. Published packets are
+// written to stdout.
+//
+// HOST_IOTC_DISCOVERY_MS - discovery request time (default 800)
+// HOST_IOTC_SYNC_MS      - sync request time (default 600)
+// HOST_IOTC_CONNECT_MS   - TLS handshake and MQTT CONNECT time (default 900)
+// HOST_IOTC_PUBLISH_MS   - TLS write of a publish (default 20)
+// HOST_IOTC_FAIL_INITS   - number of initial iotconnect_sdk_init() calls that fail (default 0)
+// HOST_IOTC_DROP_EVERY   - drop the connection after every N publishes, 0 never (default 0)
+// HOST_IOTC_QUIET        - set to 1 to not print published packets (default 0)
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "iotconnect.h"
+#include "iotc_mtb_time.h"
+#include "iotc_http_request.h"
+#include "host_sim.h"
+
+#define SIM_DTG "00000000-0000-0000-0000-000000000000"
+
+static IotConnectClientConfig config;
+static IotclConfig lib_config;
+static bool connected;
+static uint32_t init_count;
+static uint32_t publish_count;
+
+static void set_status(IotConnectConnectionStatus status) {
+    connected = (status == IOTC_CS_MQTT_CONNECTED);
+    if (config.status_cb) {
+        config.status_cb(status);
+    }
+}
+
+IotConnectClientConfig *iotconnect_sdk_init_and_get_config(void) {
+    memset(&config, 0, sizeof(config));
+    return &config;
+}
+
+IotclConfig *iotconnect_sdk_get_lib_config(void) {
+    return &lib_config;
+}
+
+cy_rslt_t iotconnect_sdk_init(void) {
+    if (!config.cpid || !config.env || !config.duid) {
+        printf("Error: Device configuration is invalid. Configuration values for env, cpid and duid are required.\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+    if (config.auth.type == IOTC_AT_X509 &&
+        (!config.auth.data.cert_info.device_cert || !strstr(config.auth.data.cert_info.device_cert, "-----BEGIN CERTIFICATE-----"))) {
+        printf("Error: Device certificate is invalid.\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+
+    // discovery and sync, the responses are only checked for what the SDK takes from them
+    IotConnectHttpResponse response;
+    char path[128];
+    snprintf(path, sizeof(path), "/api/sdk/cpid/%s/lang/M_C/ver/2.0/env/%s", config.cpid, config.env);
+    iotconnect_https_request(&response, "discovery.iotconnect.io", path, NULL);
+    bool discovered = response.data && strstr(response.data, "\"baseUrl\"");
+    iotconnect_free_https_response(&response);
+    if (!discovered) {
+        printf("Error: Unable to get the discovery response\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+    char body[256];
+    snprintf(body, sizeof(body), "{\"cpId\":\"%s\",\"uniqueId\":\"%s\",\"option\":{\"attribute\":false,"
+            "\"setting\":false,\"protocol\":true,\"device\":false,\"sdkConfig\":false,\"rule\":false}}",
+            config.cpid, config.duid);
+    iotconnect_https_request(&response, "sim-agent.iotconnect.io", "/api/2.0/agent/sync?", body);
+    bool synced = response.data && strstr(response.data, "\"ds\":0");
+    iotconnect_free_https_response(&response);
+    if (!synced) {
+        printf("Error: Unable to get the sync response\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(host_sim_config("HOST_IOTC_CONNECT_MS", 900)));
+    if (init_count++ < host_sim_config("HOST_IOTC_FAIL_INITS", 0)) {
+        printf("Sim: MQTT connection failed\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+
+    memset(&lib_config, 0, sizeof(lib_config));
+    lib_config.device.cpid = config.cpid;
+    lib_config.device.duid = config.duid;
+    lib_config.device.env = config.env;
+    lib_config.telemetry.dtg = SIM_DTG;
+    if (!iotcl_init(&lib_config)) {
+        printf("Error: Failed to initialize the IoTConnect Lib\n");
+        return CY_RSLT_SIM_ERROR;
+    }
+
+    printf("Sim: MQTT connected\n");
+    set_status(IOTC_CS_MQTT_CONNECTED);
+    return CY_RSLT_SUCCESS;
+}
+
+bool iotconnect_sdk_is_connected(void) {
+    return connected;
+}
+
+void iotconnect_sdk_send_packet(const char *data) {
+    if (!connected) {
+        printf("Sim: publish while disconnected\n");
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(host_sim_config("HOST_IOTC_PUBLISH_MS", 20)));
+    publish_count++;
+    if (!host_sim_config("HOST_IOTC_QUIET", 0)) {
+        printf("Sim: published %u bytes\n", (unsigned) strlen(data));
+    }
+
+    uint32_t drop_every = host_sim_config("HOST_IOTC_DROP_EVERY", 0);
+    if (drop_every && (publish_count % drop_every) == 0) {
+        printf("Sim: MQTT connection lost\n");
+        set_status(IOTC_CS_MQTT_DISCONNECTED);
+    }
+}
+
+void iotconnect_sdk_disconnect(void) {
+    if (connected) {
+        set_status(IOTC_CS_MQTT_DISCONNECTED);
+    }
+    iotcl_deinit();
+}
+
+int iotc_mtb_time_obtain(const char *server) {
+    (void) server;
+    vTaskDelay(pdMS_TO_TICKS(host_sim_config("HOST_SNTP_MS", 200)));
+    return 0;
+}
@@ -0,0 +1,10 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of lwIP SNTP. Time is obtained through iotc_mtb_time_obtain().
+//
+
+#ifndef LWIP_HDR_APPS_SNTP_H
+#define LWIP_HDR_APPS_SNTP_H
+
+#endif // LWIP_HDR_APPS_SNTP_H
@@ -0,0 +1,25 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the lwIP address helpers used by the application.
+//
+
+#ifndef LWIP_HDR_NETIF_H
+#define LWIP_HDR_NETIF_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t addr;
+} ip4_addr_t;
+
+typedef struct
+{
+    uint32_t addr[4];
+} ip6_addr_t;
+
+char *ip4addr_ntoa(const ip4_addr_t *addr);
+char *ip6addr_ntoa(const ip6_addr_t *addr);
+
+#endif // LWIP_HDR_NETIF_H
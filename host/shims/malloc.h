@@ -0,0 +1,18 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the newlib mallinfo(). glibc 2.33 deprecates mallinfo(),
+// whose int fields wrap at 2 GB, in favour of mallinfo2(), which the
+// struct and the function are mapped to.
+//
+
+#ifndef HOST_MALLOC_H
+#define HOST_MALLOC_H
+
+#include_next <malloc.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#define mallinfo mallinfo2
+#endif
+
+#endif // HOST_MALLOC_H
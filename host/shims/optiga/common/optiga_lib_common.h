@@ -0,0 +1,32 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M library common types.
+//
+
+#ifndef _OPTIGA_LIB_COMMON_H_
+#define _OPTIGA_LIB_COMMON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint16_t optiga_lib_status_t;
+
+#define OPTIGA_LIB_SUCCESS                  (0x0000)
+#define OPTIGA_LIB_BUSY                     (0x0001)
+#define OPTIGA_UTIL_ERROR                   (0x0100)
+#define OPTIGA_UTIL_ERROR_INVALID_INPUT     (0x0101)
+#define OPTIGA_UTIL_ERROR_INSTANCE_IN_USE   (0x0103)
+#define OPTIGA_CRYPT_ERROR                  (0x0200)
+#define OPTIGA_CRYPT_ERROR_INVALID_INPUT    (0x0201)
+#define OPTIGA_DEVICE_ERROR                 (0x8000)
+
+/* OPTIGA data object write types */
+#define OPTIGA_UTIL_WRITE_ONLY              (0x00)
+#define OPTIGA_UTIL_ERASE_AND_WRITE         (0x40)
+
+typedef void (*callback_handler_t)(void *callback_ctx, optiga_lib_status_t event);
+
+#endif // _OPTIGA_LIB_COMMON_H_
@@ -0,0 +1,19 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M library logger.
+//
+
+#ifndef _OPTIGA_LIB_LOGGER_H_
+#define _OPTIGA_LIB_LOGGER_H_
+
+#include <stdio.h>
+
+#define OPTIGA_UTIL_SERVICE                 "[optiga util]     : "
+#define OPTIGA_CRYPT_SERVICE                "[optiga crypt]    : "
+#define OPTIGA_UTIL_SERVICE_COLOR           ""
+#define OPTIGA_CRYPT_SERVICE_COLOR          ""
+
+#define optiga_lib_print_message(msg, layer, color) printf("%s%s%s\n", (color), (layer), (msg))
+
+#endif // _OPTIGA_LIB_LOGGER_H_
@@ -0,0 +1,12 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA IFX I2C protocol configuration.
+//
+
+#ifndef _IFX_I2C_CONFIG_H_
+#define _IFX_I2C_CONFIG_H_
+
+#include "optiga/pal/pal_ifx_i2c_config.h"
+
+#endif // _IFX_I2C_CONFIG_H_
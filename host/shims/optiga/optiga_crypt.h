@@ -0,0 +1,26 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M crypt API (the subset used by the application).
+//
+
+#ifndef _OPTIGA_CRYPT_H_
+#define _OPTIGA_CRYPT_H_
+
+#include "optiga/common/optiga_lib_common.h"
+
+typedef enum {
+    OPTIGA_KEY_ID_E0F0 = 0xE0F0,
+    OPTIGA_KEY_ID_E0F1 = 0xE0F1,
+    OPTIGA_KEY_ID_E0F2 = 0xE0F2,
+    OPTIGA_KEY_ID_E0F3 = 0xE0F3,
+} optiga_key_id_t;
+
+typedef struct optiga_crypt optiga_crypt_t;
+
+optiga_crypt_t *optiga_crypt_create(uint8_t optiga_instance_id, callback_handler_t handler, void *caller_context);
+optiga_lib_status_t optiga_crypt_destroy(optiga_crypt_t *me);
+optiga_lib_status_t optiga_crypt_ecdsa_sign(optiga_crypt_t *me, const uint8_t *digest, uint8_t digest_length,
+        optiga_key_id_t private_key, uint8_t *signature, uint16_t *signature_length);
+
+#endif // _OPTIGA_CRYPT_H_
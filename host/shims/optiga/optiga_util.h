@@ -0,0 +1,23 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M util API.
+// Operations complete asynchronously through the PAL OS event, exactly like
+// the real library, with the latency of the I2C traffic they would cause.
+//
+
+#ifndef _OPTIGA_UTIL_H_
+#define _OPTIGA_UTIL_H_
+
+#include "optiga/common/optiga_lib_common.h"
+
+typedef struct optiga_util optiga_util_t;
+
+optiga_util_t *optiga_util_create(uint8_t optiga_instance_id, callback_handler_t handler, void *caller_context);
+optiga_lib_status_t optiga_util_destroy(optiga_util_t *me);
+optiga_lib_status_t optiga_util_open_application(optiga_util_t *me, bool perform_restore);
+optiga_lib_status_t optiga_util_close_application(optiga_util_t *me, bool perform_hibernate);
+optiga_lib_status_t optiga_util_read_data(optiga_util_t *me, uint16_t optiga_oid, uint16_t offset, uint8_t *buffer, uint16_t *length);
+optiga_lib_status_t optiga_util_write_data(optiga_util_t *me, uint16_t optiga_oid, uint8_t write_type, uint16_t offset, const uint8_t *buffer, uint16_t length);
+
+#endif // _OPTIGA_UTIL_H_
@@ -0,0 +1,19 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M platform abstraction layer.
+//
+
+#ifndef _PAL_H_
+#define _PAL_H_
+
+#include <stdint.h>
+
+typedef uint16_t pal_status_t;
+
+#define PAL_STATUS_SUCCESS                  (0x0000)
+#define PAL_STATUS_FAILURE                  (0x0001)
+
+pal_status_t pal_init(void);
+
+#endif // _PAL_H_
@@ -0,0 +1,13 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA PAL GPIO interface. Reset and VDD control are not
+// simulated.
+//
+
+#ifndef _PAL_GPIO_H_
+#define _PAL_GPIO_H_
+
+#include "optiga/pal/pal.h"
+
+#endif // _PAL_GPIO_H_
@@ -0,0 +1,23 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA PAL I2C interface.
+//
+
+#ifndef _PAL_I2C_H_
+#define _PAL_I2C_H_
+
+#include "optiga/pal/pal.h"
+
+typedef struct pal_i2c
+{
+    void *p_i2c_hw_config;
+    void *p_upper_layer_ctx;
+    void *upper_layer_event_handler;
+    uint8_t slave_address;
+} pal_i2c_t;
+
+pal_status_t pal_i2c_init(const pal_i2c_t *p_i2c_context);
+pal_status_t pal_i2c_deinit(const pal_i2c_t *p_i2c_context);
+
+#endif // _PAL_I2C_H_
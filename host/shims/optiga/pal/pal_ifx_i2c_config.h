@@ -0,0 +1,13 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA PAL IFX I2C configuration.
+//
+
+#ifndef _PAL_IFX_I2C_CONFIG_H_
+#define _PAL_IFX_I2C_CONFIG_H_
+
+#include "optiga/pal/pal_i2c.h"
+#include "optiga/pal/pal_gpio.h"
+
+#endif // _PAL_IFX_I2C_CONFIG_H_
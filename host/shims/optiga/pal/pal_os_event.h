@@ -0,0 +1,31 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA PAL OS event. As on the target, registered callbacks
+// are dispatched by pal_os_event_trigger_registered_callback(), which the
+// application calls from its tick hook or its OPTIGA event task
+// (source/optiga_event.h).
+//
+
+#ifndef _PAL_OS_EVENT_H_
+#define _PAL_OS_EVENT_H_
+
+#include "optiga/pal/pal.h"
+#include "optiga/pal/pal_os_timer.h"
+
+typedef void (*register_callback)(void *);
+
+typedef struct pal_os_event
+{
+    uint8_t is_event_triggered;
+    register_callback callback_registered;
+    void *callback_ctx;
+    uint64_t due_us;
+} pal_os_event_t;
+
+pal_os_event_t *pal_os_event_create(register_callback callback, void *callback_args);
+void pal_os_event_destroy(pal_os_event_t *pal_os_event);
+void pal_os_event_register_callback_oneshot(pal_os_event_t *p_pal_os_event, register_callback callback, void *callback_args, uint32_t time_us);
+void pal_os_event_trigger_registered_callback(void);
+
+#endif // _PAL_OS_EVENT_H_
@@ -0,0 +1,15 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA PAL OS timer.
+//
+
+#ifndef _PAL_OS_TIMER_H_
+#define _PAL_OS_TIMER_H_
+
+#include "optiga/pal/pal.h"
+
+uint32_t pal_os_timer_get_time_in_milliseconds(void);
+void pal_os_timer_delay_in_milliseconds(uint16_t milliseconds);
+
+#endif // _PAL_OS_TIMER_H_
@@ -0,0 +1,425 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated OPTIGA Trust M util and crypt API and PAL.
+//
+// Util and crypt operations are queued like in the real command layer and
+// complete one at a time through the PAL OS event, so callers observe the
+// same asynchronous completion as on the target. Like the real library,
+// instances are allocated from the heap and at most
+// OPTIGA_CMD_MAX_REGISTRATIONS can exist at the same time.
+// The latency of an operation is the time its APDU would take on the
+// OPTIGA I2C bus plus HOST_OPTIGA_CMD_US (default 2000) of chip processing,
+// or HOST_OPTIGA_SIGN_US (default 60000) for an ECDSA signature.
+// Signatures have the right format, but are not valid.
+//
+// Data object 0xE0E0 holds a test device certificate in the TLS identity
+// format used by the factory provisioned OPTIGA Trust M.
+//
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "optiga/optiga_util.h"
+#include "optiga/optiga_crypt.h"
+#include "optiga/pal/pal_os_event.h"
+#include "optiga/pal/pal_os_timer.h"
+#include "optiga/pal/pal_i2c.h"
+#include "optiga_lib_config_mtb.h"
+#include "host_sim.h"
+
+#define SIM_OPTIGA_I2C_HZ           (1000000U)
+#define SIM_OPTIGA_FRAME_OVERHEAD   (16U)
+#define SIM_OPTIGA_MAX_OBJECT_SIZE  (1728U)
+#define SIM_OPTIGA_MAX_OBJECTS      (4U)
+#define SIM_OPTIGA_SIGNATURE_LEN    (68U)
+#define SIM_OPTIGA_CMD_CONTEXT_SIZE (64U)
+
+typedef enum {
+    SIM_OP_OPEN,
+    SIM_OP_CLOSE,
+    SIM_OP_READ,
+    SIM_OP_WRITE,
+    SIM_OP_SIGN,
+} sim_op_type_t;
+
+// Common part of util and crypt instances
+typedef struct {
+    callback_handler_t handler;
+    void *caller_context;
+    void *cmd;  // command layer context, allocated separately like in the real library
+} sim_instance_t;
+
+struct optiga_util {
+    sim_instance_t instance;
+};
+
+struct optiga_crypt {
+    sim_instance_t instance;
+};
+
+typedef struct {
+    sim_instance_t *instance;
+    sim_op_type_t type;
+    uint16_t oid;
+    uint16_t offset;
+    uint8_t *read_buffer;
+    uint16_t *read_length;
+    const uint8_t *write_buffer;
+    uint16_t write_length;
+    uint8_t write_type;
+    const uint8_t *digest;
+    uint8_t digest_length;
+    uint8_t *signature;
+    uint16_t *signature_length;
+} sim_op_t;
+
+typedef struct {
+    uint16_t oid;
+    uint16_t length;
+    uint8_t data[SIM_OPTIGA_MAX_OBJECT_SIZE];
+} sim_object_t;
+
+static const uint8_t sim_device_certificate[] = {
+    0x30, 0x82, 0x02, 0x3E, 0x30, 0x82, 0x01, 0xE4, 0xA0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x08, 0x66,
+    0xAD, 0x36, 0x73, 0xED, 0xA4, 0x34, 0x24, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+    0x04, 0x03, 0x02, 0x30, 0x77, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02,
+    0x44, 0x45, 0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x18, 0x49, 0x6E, 0x66,
+    0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x54, 0x65, 0x63, 0x68, 0x6E, 0x6F, 0x6C, 0x6F, 0x67, 0x69,
+    0x65, 0x73, 0x20, 0x41, 0x47, 0x31, 0x13, 0x30, 0x11, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x0C, 0x0A,
+    0x4F, 0x50, 0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x31, 0x30, 0x30, 0x2E, 0x06, 0x03,
+    0x55, 0x04, 0x03, 0x0C, 0x27, 0x49, 0x6E, 0x66, 0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x4F, 0x50,
+    0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x20, 0x54, 0x72, 0x75, 0x73, 0x74, 0x20, 0x4D,
+    0x20, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x20, 0x30, 0x30, 0x30, 0x30, 0x1E, 0x17, 0x0D,
+    0x31, 0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x17, 0x0D, 0x32,
+    0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x30, 0x50, 0x31, 0x0B,
+    0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x49, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06,
+    0x03, 0x55, 0x04, 0x07, 0x13, 0x02, 0x4C, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04,
+    0x0A, 0x13, 0x02, 0x4F, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x13, 0x02,
+    0x4F, 0x55, 0x31, 0x1A, 0x30, 0x18, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x11, 0x49, 0x6E, 0x66,
+    0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x5F, 0x49, 0x6F, 0x54, 0x5F, 0x4E, 0x6F, 0x64, 0x65, 0x30, 0x59,
+    0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48,
+    0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x55, 0x1E, 0x0A, 0xD9, 0x01, 0x19, 0xD0,
+    0x44, 0x3E, 0xBD, 0xE4, 0x4B, 0xEC, 0xA3, 0xA2, 0xE9, 0x07, 0x08, 0xD2, 0x0A, 0x39, 0x20, 0xE1,
+    0x0C, 0x69, 0xD7, 0xD6, 0xAE, 0xA5, 0xDD, 0x6F, 0x41, 0x42, 0xE2, 0x73, 0x51, 0x0C, 0x6D, 0xD0,
+    0x05, 0x02, 0x60, 0x5F, 0x6D, 0x45, 0x35, 0x4F, 0xCC, 0x7F, 0x0C, 0xDB, 0x1E, 0xBB, 0xDD, 0x4D,
+    0x8E, 0x40, 0xBC, 0x55, 0x65, 0xD2, 0x7A, 0x2F, 0x81, 0xA3, 0x81, 0x80, 0x30, 0x7E, 0x30, 0x0C,
+    0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF, 0x04, 0x02, 0x30, 0x00, 0x30, 0x1D, 0x06, 0x03,
+    0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xB9, 0x46, 0xB7, 0x00, 0x01, 0xD9, 0x5E, 0xFC, 0x80,
+    0x42, 0x0E, 0xED, 0x6A, 0xF9, 0x0B, 0x53, 0x79, 0xA7, 0x4F, 0xAE, 0x30, 0x1F, 0x06, 0x03, 0x55,
+    0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0x53, 0x1B, 0x46, 0x32, 0xF2, 0xBA, 0x1B, 0xEC,
+    0x35, 0x23, 0xB0, 0xC6, 0x84, 0xE2, 0xBC, 0x7F, 0x11, 0xDA, 0xA2, 0x2E, 0x30, 0x0E, 0x06, 0x03,
+    0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x07, 0x80, 0x30, 0x1E, 0x06, 0x09,
+    0x60, 0x86, 0x48, 0x01, 0x86, 0xF8, 0x42, 0x01, 0x0D, 0x04, 0x11, 0x16, 0x0F, 0x78, 0x63, 0x61,
+    0x20, 0x63, 0x65, 0x72, 0x74, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x65, 0x30, 0x0A, 0x06, 0x08,
+    0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x48, 0x00, 0x30, 0x45, 0x02, 0x21, 0x00,
+    0x98, 0x00, 0x55, 0x8D, 0x58, 0xE9, 0x24, 0xB9, 0x69, 0x1B, 0x12, 0x0D, 0x4E, 0xE0, 0xAB, 0xF3,
+    0x00, 0xDA, 0x14, 0x3A, 0x39, 0x05, 0xE7, 0xC8, 0xCE, 0xBD, 0x07, 0x0F, 0x7D, 0x03, 0xEA, 0x54,
+    0x02, 0x20, 0x45, 0x77, 0x6C, 0x77, 0xD0, 0xCC, 0x51, 0xF8, 0xD5, 0x77, 0x5C, 0xE7, 0xBC, 0xED,
+    0x56, 0xD8, 0x39, 0xF9, 0x98, 0x8C, 0x06, 0xFF, 0x56, 0x73, 0x79, 0x04, 0x1E, 0x37, 0xAB, 0x5F,
+    0x8B, 0x73,
+};
+
+static uint32_t registrations;
+static sim_op_t op_queue[OPTIGA_CMD_MAX_REGISTRATIONS];
+static uint32_t op_head;
+static uint32_t op_count;
+static sim_object_t objects[SIM_OPTIGA_MAX_OBJECTS];
+static bool objects_initialized;
+static bool application_open;
+
+static sim_object_t *find_object(uint16_t oid, bool create) {
+    for (uint32_t i = 0; i < SIM_OPTIGA_MAX_OBJECTS; i++) {
+        if (objects[i].oid == oid) {
+            return &objects[i];
+        }
+    }
+    if (create) {
+        for (uint32_t i = 0; i < SIM_OPTIGA_MAX_OBJECTS; i++) {
+            if (objects[i].oid == 0) {
+                objects[i].oid = oid;
+                objects[i].length = 0;
+                return &objects[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static void init_objects(void) {
+    // TLS identity: tag, length, certificate chain length, certificate length, DER
+    sim_object_t *cert = find_object(0xE0E0, true);
+    uint16_t cert_len = sizeof(sim_device_certificate);
+    uint8_t *p = cert->data;
+    *p++ = 0xC0;
+    *p++ = (uint8_t) ((cert_len + 6) >> 8);
+    *p++ = (uint8_t) (cert_len + 6);
+    *p++ = 0;
+    *p++ = (uint8_t) ((cert_len + 3) >> 8);
+    *p++ = (uint8_t) (cert_len + 3);
+    *p++ = 0;
+    *p++ = (uint8_t) (cert_len >> 8);
+    *p++ = (uint8_t) cert_len;
+    memcpy(p, sim_device_certificate, cert_len);
+    cert->length = (uint16_t) (cert_len + 9);
+    objects_initialized = true;
+}
+
+static uint32_t op_latency_us(const sim_op_t *op) {
+    uint32_t payload = 0;
+    uint32_t processing_us;
+    if (op->type == SIM_OP_READ) {
+        payload = *op->read_length;
+    } else if (op->type == SIM_OP_WRITE) {
+        payload = op->write_length;
+    } else if (op->type == SIM_OP_SIGN) {
+        payload = op->digest_length + SIM_OPTIGA_SIGNATURE_LEN;
+    }
+    if (op->type == SIM_OP_SIGN) {
+        processing_us = host_sim_config("HOST_OPTIGA_SIGN_US", 60000);
+    } else {
+        processing_us = host_sim_config("HOST_OPTIGA_CMD_US", 2000);
+    }
+    uint64_t bits = 9ULL * (payload + SIM_OPTIGA_FRAME_OVERHEAD);
+    return (uint32_t) (bits * 1000000ULL / SIM_OPTIGA_I2C_HZ) + processing_us;
+}
+
+static optiga_lib_status_t op_execute(const sim_op_t *op) {
+    sim_object_t *object;
+    switch (op->type) {
+        case SIM_OP_OPEN:
+            application_open = true;
+            return OPTIGA_LIB_SUCCESS;
+        case SIM_OP_CLOSE:
+            application_open = false;
+            return OPTIGA_LIB_SUCCESS;
+        case SIM_OP_READ:
+            object = find_object(op->oid, false);
+            if (!application_open || !object || op->offset >= object->length) {
+                return OPTIGA_DEVICE_ERROR;
+            }
+            if (*op->read_length > object->length - op->offset) {
+                *op->read_length = (uint16_t) (object->length - op->offset);
+            }
+            memcpy(op->read_buffer, &object->data[op->offset], *op->read_length);
+            return OPTIGA_LIB_SUCCESS;
+        case SIM_OP_WRITE:
+            object = find_object(op->oid, true);
+            if (!application_open || !object || op->offset + op->write_length > SIM_OPTIGA_MAX_OBJECT_SIZE) {
+                return OPTIGA_DEVICE_ERROR;
+            }
+            if (op->write_type == OPTIGA_UTIL_ERASE_AND_WRITE) {
+                object->length = 0;
+            }
+            memcpy(&object->data[op->offset], op->write_buffer, op->write_length);
+            if (op->offset + op->write_length > object->length) {
+                object->length = (uint16_t) (op->offset + op->write_length);
+            }
+            return OPTIGA_LIB_SUCCESS;
+        case SIM_OP_SIGN:
+            if (!application_open || *op->signature_length < SIM_OPTIGA_SIGNATURE_LEN) {
+                return OPTIGA_DEVICE_ERROR;
+            }
+            // r and s as two DER INTEGERs, without the SEQUENCE, like the real chip returns them
+            for (int i = 0; i < 2; i++) {
+                uint8_t *integer = &op->signature[i * (SIM_OPTIGA_SIGNATURE_LEN / 2)];
+                integer[0] = 0x02;
+                integer[1] = 0x20;
+                for (int j = 0; j < 0x20; j++) {
+                    integer[2 + j] = (uint8_t) (op->digest[j % op->digest_length] ^ (0x5A + i));
+                }
+                integer[2] = (uint8_t) ((integer[2] & 0x7F) | 0x01); // positive, no leading zero
+            }
+            *op->signature_length = SIM_OPTIGA_SIGNATURE_LEN;
+            return OPTIGA_LIB_SUCCESS;
+    }
+    return OPTIGA_DEVICE_ERROR;
+}
+
+static void op_complete(void *ctx);
+
+static void op_start_next(void) {
+    if (op_count) {
+        sim_op_t *op = &op_queue[op_head];
+        // the PAL has a single event (shims/pal_os_event_sim.c)
+        pal_os_event_register_callback_oneshot(pal_os_event_create(NULL, NULL), op_complete, op, op_latency_us(op));
+    }
+}
+
+// Runs from the PAL OS event, i.e. from the tick hook or the OPTIGA event task
+static void op_complete(void *ctx) {
+    sim_op_t op = *(sim_op_t *) ctx;
+    op_head = (op_head + 1) % OPTIGA_CMD_MAX_REGISTRATIONS;
+    op_count--;
+    optiga_lib_status_t status = op_execute(&op);
+    op_start_next();
+    op.instance->handler(op.instance->caller_context, status);
+}
+
+static optiga_lib_status_t op_submit(const sim_op_t *op) {
+    optiga_lib_status_t status = OPTIGA_LIB_SUCCESS;
+    if (!op->instance) {
+        return OPTIGA_UTIL_ERROR_INVALID_INPUT;
+    }
+    taskENTER_CRITICAL();
+    if (op_count == OPTIGA_CMD_MAX_REGISTRATIONS) {
+        status = OPTIGA_UTIL_ERROR_INSTANCE_IN_USE;
+    } else {
+        op_queue[(op_head + op_count) % OPTIGA_CMD_MAX_REGISTRATIONS] = *op;
+        if (op_count++ == 0) {
+            op_start_next();
+        }
+    }
+    taskEXIT_CRITICAL();
+    return status;
+}
+
+// Registers a new util or crypt instance with the command layer
+static void *instance_create(size_t size, callback_handler_t handler, void *caller_context) {
+    sim_instance_t *instance = NULL;
+    if (!handler) {
+        return NULL;
+    }
+    taskENTER_CRITICAL();
+    if (!objects_initialized) {
+        init_objects();
+    }
+    if (registrations < OPTIGA_CMD_MAX_REGISTRATIONS) {
+        registrations++;
+    } else {
+        handler = NULL;
+    }
+    taskEXIT_CRITICAL();
+    if (!handler) {
+        return NULL;
+    }
+
+    instance = (sim_instance_t *) pvPortMalloc(size);
+    void *cmd = pvPortMalloc(SIM_OPTIGA_CMD_CONTEXT_SIZE);
+    if (!instance || !cmd) {
+        vPortFree(instance);
+        vPortFree(cmd);
+        taskENTER_CRITICAL();
+        registrations--;
+        taskEXIT_CRITICAL();
+        return NULL;
+    }
+    memset(instance, 0, size);
+    memset(cmd, 0, SIM_OPTIGA_CMD_CONTEXT_SIZE);
+    instance->cmd = cmd;
+    instance->handler = handler;
+    instance->caller_context = caller_context;
+    return instance;
+}
+
+static optiga_lib_status_t instance_destroy(sim_instance_t *instance) {
+    if (!instance) {
+        return OPTIGA_UTIL_ERROR_INVALID_INPUT;
+    }
+    vPortFree(instance->cmd);
+    vPortFree(instance);
+    taskENTER_CRITICAL();
+    registrations--;
+    taskEXIT_CRITICAL();
+    return OPTIGA_LIB_SUCCESS;
+}
+
+optiga_util_t *optiga_util_create(uint8_t optiga_instance_id, callback_handler_t handler, void *caller_context) {
+    (void) optiga_instance_id;
+    return (optiga_util_t *) instance_create(sizeof(optiga_util_t), handler, caller_context);
+}
+
+optiga_lib_status_t optiga_util_destroy(optiga_util_t *me) {
+    return instance_destroy(me ? &me->instance : NULL);
+}
+
+optiga_crypt_t *optiga_crypt_create(uint8_t optiga_instance_id, callback_handler_t handler, void *caller_context) {
+    (void) optiga_instance_id;
+    return (optiga_crypt_t *) instance_create(sizeof(optiga_crypt_t), handler, caller_context);
+}
+
+optiga_lib_status_t optiga_crypt_destroy(optiga_crypt_t *me) {
+    return instance_destroy(me ? &me->instance : NULL);
+}
+
+optiga_lib_status_t optiga_crypt_ecdsa_sign(optiga_crypt_t *me, const uint8_t *digest, uint8_t digest_length,
+        optiga_key_id_t private_key, uint8_t *signature, uint16_t *signature_length) {
+    (void) private_key;
+    if (!me || !digest || !digest_length || !signature || !signature_length) {
+        return OPTIGA_CRYPT_ERROR_INVALID_INPUT;
+    }
+    sim_op_t op = {
+        .instance = &me->instance,
+        .type = SIM_OP_SIGN,
+        .digest = digest,
+        .digest_length = digest_length,
+        .signature = signature,
+        .signature_length = signature_length
+    };
+    return op_submit(&op);
+}
+
+optiga_lib_status_t optiga_util_open_application(optiga_util_t *me, bool perform_restore) {
+    (void) perform_restore;
+    sim_op_t op = { .instance = me ? &me->instance : NULL, .type = SIM_OP_OPEN };
+    return op_submit(&op);
+}
+
+optiga_lib_status_t optiga_util_close_application(optiga_util_t *me, bool perform_hibernate) {
+    (void) perform_hibernate;
+    sim_op_t op = { .instance = me ? &me->instance : NULL, .type = SIM_OP_CLOSE };
+    return op_submit(&op);
+}
+
+optiga_lib_status_t optiga_util_read_data(optiga_util_t *me, uint16_t optiga_oid, uint16_t offset, uint8_t *buffer, uint16_t *length) {
+    if (!buffer || !length) {
+        return OPTIGA_UTIL_ERROR_INVALID_INPUT;
+    }
+    sim_op_t op = {
+        .instance = me ? &me->instance : NULL,
+        .type = SIM_OP_READ,
+        .oid = optiga_oid,
+        .offset = offset,
+        .read_buffer = buffer,
+        .read_length = length
+    };
+    return op_submit(&op);
+}
+
+optiga_lib_status_t optiga_util_write_data(optiga_util_t *me, uint16_t optiga_oid, uint8_t write_type, uint16_t offset, const uint8_t *buffer, uint16_t length) {
+    if (!buffer) {
+        return OPTIGA_UTIL_ERROR_INVALID_INPUT;
+    }
+    sim_op_t op = {
+        .instance = me ? &me->instance : NULL,
+        .type = SIM_OP_WRITE,
+        .oid = optiga_oid,
+        .offset = offset,
+        .write_buffer = buffer,
+        .write_length = length,
+        .write_type = write_type
+    };
+    return op_submit(&op);
+}
+
+pal_status_t pal_init(void) {
+    return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_init(const pal_i2c_t *p_i2c_context) {
+    (void) p_i2c_context;
+    return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_deinit(const pal_i2c_t *p_i2c_context) {
+    (void) p_i2c_context;
+    return PAL_STATUS_SUCCESS;
+}
+
+uint32_t pal_os_timer_get_time_in_milliseconds(void) {
+    return (uint32_t) (host_sim_now_us() / 1000U);
+}
+
+void pal_os_timer_delay_in_milliseconds(uint16_t milliseconds) {
+    vTaskDelay(pdMS_TO_TICKS(milliseconds));
+}
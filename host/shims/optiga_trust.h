@@ -0,0 +1,14 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the OPTIGA Trust M example utilities header.
+//
+
+#ifndef _OPTIGA_TRUST_H_
+#define _OPTIGA_TRUST_H_
+
+#include "optiga/optiga_util.h"
+
+void optiga_trust_init(void);
+
+#endif // _OPTIGA_TRUST_H_
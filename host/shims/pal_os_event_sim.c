@@ -0,0 +1,42 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated OPTIGA PAL OS event.
+//
+// A registered callback runs from the first pal_os_event_trigger_registered_callback()
+// call made once the time it asked for has passed. It is kept apart from
+// optiga_sim.c, which registers its callbacks through the application's
+// wrapper (--wrap=pal_os_event_register_callback_oneshot).
+//
+
+#include <stddef.h>
+#include "optiga/pal/pal_os_event.h"
+#include "host_sim.h"
+
+static pal_os_event_t pal_os_event_0;
+
+pal_os_event_t *pal_os_event_create(register_callback callback, void *callback_args) {
+    if (callback && callback_args) {
+        pal_os_event_register_callback_oneshot(&pal_os_event_0, callback, callback_args, 1000);
+    }
+    return &pal_os_event_0;
+}
+
+void pal_os_event_destroy(pal_os_event_t *pal_os_event) {
+    (void) pal_os_event;
+}
+
+void pal_os_event_register_callback_oneshot(pal_os_event_t *p_pal_os_event, register_callback callback, void *callback_args, uint32_t time_us) {
+    p_pal_os_event->callback_ctx = callback_args;
+    p_pal_os_event->due_us = host_sim_now_us() + time_us;
+    p_pal_os_event->callback_registered = callback;
+}
+
+void pal_os_event_trigger_registered_callback(void) {
+    register_callback callback = pal_os_event_0.callback_registered;
+    if (!callback || host_sim_now_us() < pal_os_event_0.due_us) {
+        return;
+    }
+    pal_os_event_0.callback_registered = NULL;
+    callback(pal_os_event_0.callback_ctx);
+}
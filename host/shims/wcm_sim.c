@@ -0,0 +1,68 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated Wi-Fi Connection Manager and lwIP address helpers.
+//
+// HOST_WIFI_JOIN_MS      - time to associate and obtain an address (default 1500)
+// HOST_WIFI_FAIL_JOINS   - number of initial join attempts that fail (default 0)
+//
+
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cy_wcm.h"
+#include "lwip/netif.h"
+#include "host_sim.h"
+
+static bool wcm_initialized;
+static bool wcm_connected;
+static uint32_t wcm_join_attempts;
+
+cy_rslt_t cy_wcm_init(cy_wcm_config_t *config) {
+    if (config->interface != CY_WCM_INTERFACE_TYPE_STA) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    wcm_initialized = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_connect_ap(const cy_wcm_connect_params_t *connect_params, cy_wcm_ip_address_t *ip_addr) {
+    (void) connect_params;
+    if (!wcm_initialized) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    vTaskDelay(pdMS_TO_TICKS(host_sim_config("HOST_WIFI_JOIN_MS", 1500)));
+    if (wcm_join_attempts++ < host_sim_config("HOST_WIFI_FAIL_JOINS", 0)) {
+        return CY_RSLT_SIM_ERROR;
+    }
+    ip_addr->version = CY_WCM_IP_VER_V4;
+    ip_addr->ip.v4 = 0x0100007FU; // 127.0.0.1 in network byte order
+    wcm_connected = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_disconnect_ap(void) {
+    wcm_connected = false;
+    return CY_RSLT_SUCCESS;
+}
+
+uint8_t cy_wcm_is_connected_to_ap(void) {
+    return wcm_connected ? 1 : 0;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *addr) {
+    static char str[16];
+    const uint8_t *b = (const uint8_t *) &addr->addr;
+    snprintf(str, sizeof(str), "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+    return str;
+}
+
+char *ip6addr_ntoa(const ip6_addr_t *addr) {
+    static char str[40];
+    const uint8_t *b = (const uint8_t *) addr->addr;
+    int len = 0;
+    for (int i = 0; i < 16; i += 2) {
+        len += snprintf(&str[len], sizeof(str) - len, i ? ":%x" : "%x", (b[i] << 8) | b[i + 1]);
+    }
+    return str;
+}
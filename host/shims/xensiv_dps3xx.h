@@ -0,0 +1,58 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the XENSIV DPS3xx platform independent driver.
+//
+
+#ifndef XENSIV_DPS3XX_H_
+#define XENSIV_DPS3XX_H_
+
+#include "cyhal.h"
+
+#define XENSIV_DPS3XX_I2C_ADDR_DEFAULT      (0x77U)
+#define XENSIV_DPS3XX_I2C_ADDR_ALT          (0x76U)
+
+#define XENSIV_DPS3XX_RSLT_ERR_COMM         ((cy_rslt_t)0x02000001U)
+
+typedef enum
+{
+    XENSIV_DPS3XX_MODE_IDLE = 0x00,
+    XENSIV_DPS3XX_MODE_COMMAND_PRESSURE = 0x01,
+    XENSIV_DPS3XX_MODE_COMMAND_TEMPERATURE = 0x02,
+    XENSIV_DPS3XX_MODE_BACKGROUND_PRESSURE = 0x05,
+    XENSIV_DPS3XX_MODE_BACKGROUND_TEMPERATURE = 0x06,
+    XENSIV_DPS3XX_MODE_BACKGROUND_ALL = 0x07,
+} xensiv_dps3xx_mode_t;
+
+typedef enum
+{
+    XENSIV_DPS3XX_RATE_1 = 0x00,
+    XENSIV_DPS3XX_RATE_2 = 0x10,
+    XENSIV_DPS3XX_RATE_4 = 0x20,
+    XENSIV_DPS3XX_RATE_8 = 0x30,
+    XENSIV_DPS3XX_RATE_16 = 0x40,
+    XENSIV_DPS3XX_RATE_32 = 0x50,
+    XENSIV_DPS3XX_RATE_64 = 0x60,
+    XENSIV_DPS3XX_RATE_128 = 0x70,
+} xensiv_dps3xx_rate_t;
+
+typedef struct
+{
+    xensiv_dps3xx_mode_t dev_mode;
+    xensiv_dps3xx_rate_t pressure_rate;
+    xensiv_dps3xx_rate_t temperature_rate;
+} xensiv_dps3xx_config_t;
+
+typedef struct
+{
+    cyhal_i2c_t *i2c;
+    uint8_t i2c_addr;
+    xensiv_dps3xx_config_t config;
+} xensiv_dps3xx_t;
+
+cy_rslt_t xensiv_dps3xx_read(xensiv_dps3xx_t *dev, float *pressure, float *temperature);
+cy_rslt_t xensiv_dps3xx_get_config(xensiv_dps3xx_t *dev, xensiv_dps3xx_config_t *config);
+cy_rslt_t xensiv_dps3xx_set_config(xensiv_dps3xx_t *dev, xensiv_dps3xx_config_t *config);
+cy_rslt_t xensiv_dps3xx_get_revision_id(const xensiv_dps3xx_t *dev, uint8_t *revision_id);
+
+#endif // XENSIV_DPS3XX_H_
@@ -0,0 +1,14 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the XENSIV DPS3xx ModusToolbox driver.
+//
+
+#ifndef XENSIV_DPS3XX_MTB_H_
+#define XENSIV_DPS3XX_MTB_H_
+
+#include "xensiv_dps3xx.h"
+
+cy_rslt_t xensiv_dps3xx_mtb_init_i2c(xensiv_dps3xx_t *dev, cyhal_i2c_t *i2c_inst, uint8_t i2c_addr);
+
+#endif // XENSIV_DPS3XX_MTB_H_
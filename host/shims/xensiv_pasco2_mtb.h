@@ -0,0 +1,64 @@
+//
+// Copyright: Avnet 2021
+//
+// Host shim of the XENSIV PAS CO2 ModusToolbox driver.
+// The simulated sensor answers on the shared cyhal I2C bus at its real
+// address, so the bus time of every access is accounted for.
+//
+
+#ifndef XENSIV_PASCO2_MTB_H_
+#define XENSIV_PASCO2_MTB_H_
+
+#include "cyhal.h"
+
+#define XENSIV_PASCO2_I2C_ADDR              (0x28U)
+
+#define XENSIV_PASCO2_RSLT_ERR_COMM         ((cy_rslt_t)0x01000001U)
+#define XENSIV_PASCO2_READ_NRDY             ((cy_rslt_t)0x01000004U)
+
+typedef enum
+{
+    XENSIV_PASCO2_INTERRUPT_TYPE_LOW_ACTIVE = 0U,
+    XENSIV_PASCO2_INTERRUPT_TYPE_HIGH_ACTIVE = 1U,
+} xensiv_pasco2_interrupt_type_t;
+
+typedef enum
+{
+    XENSIV_PASCO2_INTERRUPT_FUNCTION_NONE = 0U,
+    XENSIV_PASCO2_INTERRUPT_FUNCTION_ALARM = 1U,
+    XENSIV_PASCO2_INTERRUPT_FUNCTION_DRDY = 2U,
+    XENSIV_PASCO2_INTERRUPT_FUNCTION_BUSY = 3U,
+    XENSIV_PASCO2_INTERRUPT_FUNCTION_EARLY = 4U,
+} xensiv_pasco2_interrupt_function_t;
+
+typedef union
+{
+    struct
+    {
+        uint32_t : 1;
+        uint32_t int_typ : 1;
+        uint32_t int_func : 3;
+        uint32_t alarm_typ : 1;
+        uint32_t int_alarm_flag : 1;
+        uint32_t : 1;
+    } b;
+    uint8_t u;
+} xensiv_pasco2_interrupt_config_t;
+
+typedef struct
+{
+    cyhal_i2c_t *i2c;
+    xensiv_pasco2_interrupt_config_t int_config;
+} xensiv_pasco2_t;
+
+cy_rslt_t xensiv_pasco2_mtb_init_i2c(xensiv_pasco2_t *dev, cyhal_i2c_t *i2c);
+cy_rslt_t xensiv_pasco2_mtb_read(xensiv_pasco2_t *dev, uint16_t press_ref, uint16_t *co2_ppm_val);
+cy_rslt_t xensiv_pasco2_set_interrupt_config(const xensiv_pasco2_t *dev, xensiv_pasco2_interrupt_config_t int_config);
+
+/* Continuous mode: a measurement every 'meas_rate' seconds, raising the data ready interrupt if configured */
+cy_rslt_t xensiv_pasco2_start_continuous_mode(const xensiv_pasco2_t *dev, int16_t meas_rate);
+/* Returns XENSIV_PASCO2_READ_NRDY if no new result is available */
+cy_rslt_t xensiv_pasco2_get_result(const xensiv_pasco2_t *dev, uint16_t *val);
+cy_rslt_t xensiv_pasco2_set_pressure_compensation(const xensiv_pasco2_t *dev, uint16_t pressure);
+
+#endif // XENSIV_PASCO2_MTB_H_
@@ -0,0 +1,247 @@
+//
+// Copyright: Avnet 2021
+//
+// Simulated PAS CO2 and DPS310 sensors on the shared cyhal I2C bus.
+//
+// Readings follow slow sine waves with a little noise, which resembles an
+// indoor environment:
+// CO2 around 650 ppm, temperature around 22 C and pressure around 1013 mBar.
+//
+// In continuous mode the PAS CO2 completes a measurement every measurement
+// period (a FreeRTOS timer) and drives its INT line if data ready interrupts
+// are configured. Reading the result releases the line again. A command mode
+// DPS310 readout waits for the conversions, in background mode the latest
+// results are read right away.
+//
+// HOST_PASCO2_EXTRA_US      - additional time the PAS CO2 holds the bus per transfer (default 0)
+// HOST_DPS310_EXTRA_US      - additional time the DPS310 holds the bus per transfer (default 0)
+// HOST_DPS310_CONVERSION_US - time a command mode readout waits for the conversions (default 8000)
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "timers.h"
+#include "xensiv_pasco2_mtb.h"
+#include "xensiv_dps3xx_mtb.h"
+#include "host_sim.h"
+
+#define PASCO2_REG_PROD_ID      (0x00U)
+#define PASCO2_REG_CO2PPM_H     (0x05U)
+#define PASCO2_REG_MEAS_STS     (0x07U)
+#define PASCO2_REG_PRESS_REF_H  (0x0BU)
+#define DPS310_REG_PSR_B2       (0x00U)
+#define DPS310_REG_MEAS_CFG     (0x08U)
+#define DPS310_REG_PROD_ID      (0x0DU)
+#define DPS310_REVISION_ID      (0x10U)
+#define SIM_PI                  (3.14159265358979)
+
+typedef struct {
+    uint8_t reg;
+} sim_sensor_t;
+
+static sim_sensor_t sim_pasco2;
+static sim_sensor_t sim_dps310;
+
+// PAS CO2 continuous mode
+static const xensiv_pasco2_t *pasco2_continuous;
+static TimerHandle_t pasco2_timer;
+static volatile bool pasco2_ready;
+
+static double sim_wave(double period_s, double amplitude, double noise) {
+    double t = (double) host_sim_now_us() / 1e6;
+    return amplitude * sin(2.0 * SIM_PI * t / period_s) + noise * ((double) rand() / RAND_MAX - 0.5);
+}
+
+static void sim_put_u24(uint8_t *p, int32_t value) {
+    p[0] = (uint8_t) (value >> 16);
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) value;
+}
+
+static int32_t sim_get_s24(const uint8_t *p) {
+    int32_t value = ((int32_t) p[0] << 16) | ((int32_t) p[1] << 8) | p[2];
+    return (value & 0x800000) ? value - 0x1000000 : value;
+}
+
+static cy_rslt_t pasco2_handler(void *ctx, bool is_read, uint8_t *data, uint16_t size) {
+    sim_sensor_t *sensor = (sim_sensor_t *) ctx;
+    if (!is_read) {
+        sensor->reg = size ? data[0] : sensor->reg;
+        return CY_RSLT_SUCCESS;
+    }
+    if (sensor->reg == PASCO2_REG_CO2PPM_H && size >= 2) {
+        uint16_t ppm = (uint16_t) (650.0 + sim_wave(900.0, 120.0, 8.0));
+        data[0] = (uint8_t) (ppm >> 8);
+        data[1] = (uint8_t) ppm;
+    } else {
+        memset(data, 0, size);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t dps310_handler(void *ctx, bool is_read, uint8_t *data, uint16_t size) {
+    sim_sensor_t *sensor = (sim_sensor_t *) ctx;
+    if (!is_read) {
+        sensor->reg = size ? data[0] : sensor->reg;
+        return CY_RSLT_SUCCESS;
+    }
+    if (sensor->reg == DPS310_REG_PSR_B2 && size >= 6) {
+        // Compensated values in hundredths instead of the raw ADC counts
+        sim_put_u24(&data[0], (int32_t) ((1013.25 + sim_wave(7200.0, 0.4, 0.05)) * 100.0));
+        sim_put_u24(&data[3], (int32_t) ((22.0 + sim_wave(3600.0, 0.5, 0.02)) * 100.0));
+    } else if (sensor->reg == DPS310_REG_PROD_ID && size >= 1) {
+        data[0] = DPS310_REVISION_ID;
+    } else {
+        memset(data, 0, size);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t read_register(cyhal_i2c_t *i2c, uint16_t address, uint8_t reg, uint8_t *data, uint16_t size) {
+    cy_rslt_t result = cyhal_i2c_master_write(i2c, address, &reg, 1, 0, false);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    return cyhal_i2c_master_read(i2c, address, data, size, 0, true);
+}
+
+cy_rslt_t xensiv_pasco2_mtb_init_i2c(xensiv_pasco2_t *dev, cyhal_i2c_t *i2c) {
+    uint8_t prod_id;
+    dev->i2c = i2c;
+    dev->int_config.u = 0;
+    host_sim_i2c_attach(XENSIV_PASCO2_I2C_ADDR, pasco2_handler, &sim_pasco2, "HOST_PASCO2_EXTRA_US");
+    return read_register(i2c, XENSIV_PASCO2_I2C_ADDR, PASCO2_REG_PROD_ID, &prod_id, 1);
+}
+
+cy_rslt_t xensiv_pasco2_mtb_read(xensiv_pasco2_t *dev, uint16_t press_ref, uint16_t *co2_ppm_val) {
+    uint8_t buf[2];
+    (void) press_ref;
+    if (!dev->i2c) {
+        return XENSIV_PASCO2_RSLT_ERR_COMM;
+    }
+    cy_rslt_t result = read_register(dev->i2c, XENSIV_PASCO2_I2C_ADDR, PASCO2_REG_CO2PPM_H, buf, sizeof(buf));
+    if (result == CY_RSLT_SUCCESS) {
+        *co2_ppm_val = (uint16_t) ((buf[0] << 8) | buf[1]);
+    }
+    return result;
+}
+
+cy_rslt_t xensiv_pasco2_set_interrupt_config(const xensiv_pasco2_t *dev, xensiv_pasco2_interrupt_config_t int_config) {
+    if (!dev->i2c) {
+        return XENSIV_PASCO2_RSLT_ERR_COMM;
+    }
+    ((xensiv_pasco2_t *) dev)->int_config = int_config;
+    return CY_RSLT_SUCCESS;
+}
+
+static void pasco2_drive_int(const xensiv_pasco2_t *dev, bool active) {
+    if (dev->int_config.b.int_func == XENSIV_PASCO2_INTERRUPT_FUNCTION_DRDY) {
+        bool active_high = dev->int_config.b.int_typ == XENSIV_PASCO2_INTERRUPT_TYPE_HIGH_ACTIVE;
+        host_sim_gpio_drive(HOST_SIM_PASCO2_INT_PIN, active == active_high);
+    }
+}
+
+static void pasco2_measurement_done(TimerHandle_t timer) {
+    (void) timer;
+    pasco2_ready = true;
+    pasco2_drive_int(pasco2_continuous, true);
+}
+
+cy_rslt_t xensiv_pasco2_start_continuous_mode(const xensiv_pasco2_t *dev, int16_t meas_rate) {
+    uint8_t cfg[] = { 0x02U /* MEAS_RATE_H */, (uint8_t) (meas_rate >> 8), (uint8_t) meas_rate };
+    if (!dev->i2c || meas_rate <= 0) {
+        return XENSIV_PASCO2_RSLT_ERR_COMM;
+    }
+    cy_rslt_t result = cyhal_i2c_master_write(dev->i2c, XENSIV_PASCO2_I2C_ADDR, cfg, sizeof(cfg), 0, true);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    pasco2_continuous = dev;
+    if (!pasco2_timer) {
+        pasco2_timer = xTimerCreate("PAS CO2 sim", pdMS_TO_TICKS(meas_rate * 1000), pdTRUE, NULL, pasco2_measurement_done);
+    }
+    xTimerChangePeriod(pasco2_timer, pdMS_TO_TICKS(meas_rate * 1000), portMAX_DELAY);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t xensiv_pasco2_get_result(const xensiv_pasco2_t *dev, uint16_t *val) {
+    uint8_t buf[2];
+    if (!dev->i2c) {
+        return XENSIV_PASCO2_RSLT_ERR_COMM;
+    }
+    if (!pasco2_ready) {
+        cy_rslt_t result = read_register(dev->i2c, XENSIV_PASCO2_I2C_ADDR, PASCO2_REG_MEAS_STS, buf, 1);
+        return result == CY_RSLT_SUCCESS ? XENSIV_PASCO2_READ_NRDY : result;
+    }
+    cy_rslt_t result = read_register(dev->i2c, XENSIV_PASCO2_I2C_ADDR, PASCO2_REG_CO2PPM_H, buf, sizeof(buf));
+    if (result == CY_RSLT_SUCCESS) {
+        *val = (uint16_t) ((buf[0] << 8) | buf[1]);
+        pasco2_ready = false;
+        pasco2_drive_int(dev, false);
+    }
+    return result;
+}
+
+cy_rslt_t xensiv_pasco2_set_pressure_compensation(const xensiv_pasco2_t *dev, uint16_t pressure) {
+    uint8_t buf[] = { PASCO2_REG_PRESS_REF_H, (uint8_t) (pressure >> 8), (uint8_t) pressure };
+    if (!dev->i2c) {
+        return XENSIV_PASCO2_RSLT_ERR_COMM;
+    }
+    return cyhal_i2c_master_write(dev->i2c, XENSIV_PASCO2_I2C_ADDR, buf, sizeof(buf), 0, true);
+}
+
+cy_rslt_t xensiv_dps3xx_mtb_init_i2c(xensiv_dps3xx_t *dev, cyhal_i2c_t *i2c_inst, uint8_t i2c_addr) {
+    uint8_t prod_id;
+    dev->i2c = i2c_inst;
+    dev->i2c_addr = i2c_addr;
+    dev->config.dev_mode = XENSIV_DPS3XX_MODE_COMMAND_PRESSURE;
+    dev->config.pressure_rate = XENSIV_DPS3XX_RATE_1;
+    dev->config.temperature_rate = XENSIV_DPS3XX_RATE_1;
+    host_sim_i2c_attach(i2c_addr, dps310_handler, &sim_dps310, "HOST_DPS310_EXTRA_US");
+    return read_register(i2c_inst, i2c_addr, DPS310_REG_PROD_ID, &prod_id, 1);
+}
+
+cy_rslt_t xensiv_dps3xx_read(xensiv_dps3xx_t *dev, float *pressure, float *temperature) {
+    uint8_t buf[6];
+    if (!dev->i2c) {
+        return XENSIV_DPS3XX_RSLT_ERR_COMM;
+    }
+    if (dev->config.dev_mode < XENSIV_DPS3XX_MODE_BACKGROUND_PRESSURE) {
+        // the driver starts both conversions and polls until they are done
+        host_sim_busy_us(host_sim_config("HOST_DPS310_CONVERSION_US", 8000));
+    }
+    cy_rslt_t result = read_register(dev->i2c, dev->i2c_addr, DPS310_REG_PSR_B2, buf, sizeof(buf));
+    if (result == CY_RSLT_SUCCESS) {
+        *pressure = (float) sim_get_s24(&buf[0]) / 100.0f;
+        *temperature = (float) sim_get_s24(&buf[3]) / 100.0f;
+    }
+    return result;
+}
+
+cy_rslt_t xensiv_dps3xx_get_config(xensiv_dps3xx_t *dev, xensiv_dps3xx_config_t *config) {
+    if (!dev->i2c) {
+        return XENSIV_DPS3XX_RSLT_ERR_COMM;
+    }
+    *config = dev->config;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t xensiv_dps3xx_set_config(xensiv_dps3xx_t *dev, xensiv_dps3xx_config_t *config) {
+    uint8_t meas_cfg[] = { DPS310_REG_MEAS_CFG, (uint8_t) config->dev_mode };
+    if (!dev->i2c) {
+        return XENSIV_DPS3XX_RSLT_ERR_COMM;
+    }
+    cy_rslt_t result = cyhal_i2c_master_write(dev->i2c, dev->i2c_addr, meas_cfg, sizeof(meas_cfg), 0, true);
+    if (result == CY_RSLT_SUCCESS) {
+        dev->config = *config;
+    }
+    return result;
+}
+
+cy_rslt_t xensiv_dps3xx_get_revision_id(const xensiv_dps3xx_t *dev, uint8_t *revision_id) {
+    if (!dev->i2c) {
+        return XENSIV_DPS3XX_RSLT_ERR_COMM;
+    }
+    return read_register(dev->i2c, dev->i2c_addr, DPS310_REG_PROD_ID, revision_id, 1);
+}
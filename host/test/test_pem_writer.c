@@ -0,0 +1,137 @@
+//
+// Copyright: Avnet 2021
+//
+// Checks the streaming DER to PEM encoder (pem_writer.c): the encoding of
+// every input length against a plain base64 encoder, the same output for
+// any chunking of the input, PEM_WRITER_SIZE(), and a DER that does not fit
+// into the output buffer, as device_certificate_set() can pass one.
+//
+// Usage: build/test_pem_writer
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pem_writer.h"
+#include "device_certificate.h"
+
+#define LABEL   "CERTIFICATE"
+#define GUARD   (0xA5)
+
+static int failures;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// The PEM of 'der', encoded in one go without the streaming encoder
+static size_t reference_pem(char *out, const uint8_t *der, size_t len) {
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = (size_t) sprintf(out, "-----BEGIN " LABEL "-----\n");
+    size_t column = 0;
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t bits = (uint32_t) der[i] << 16;
+        bits |= i + 1 < len ? (uint32_t) der[i + 1] << 8 : 0;
+        bits |= i + 2 < len ? der[i + 2] : 0;
+        out[n++] = b64[(bits >> 18) & 0x3F];
+        out[n++] = b64[(bits >> 12) & 0x3F];
+        out[n++] = i + 1 < len ? b64[(bits >> 6) & 0x3F] : '=';
+        out[n++] = i + 2 < len ? b64[bits & 0x3F] : '=';
+        column += 4;
+        if (column == PEM_WRITER_LINE_LEN) {
+            out[n++] = '\n';
+            column = 0;
+        }
+    }
+    if (column) {
+        out[n++] = '\n';
+    }
+    n += (size_t) sprintf(&out[n], "-----END " LABEL "-----\n");
+    return n;
+}
+
+static const char *encode(char *buf, size_t size, const uint8_t *der, size_t len, size_t chunk) {
+    pem_writer_t w;
+
+    pem_writer_begin(&w, buf, size, LABEL);
+    for (size_t i = 0; i < len; i += chunk) {
+        pem_writer_update(&w, &der[i], len - i < chunk ? len - i : chunk);
+    }
+    return pem_writer_finish(&w, LABEL);
+}
+
+static void test_lengths(const uint8_t *der) {
+    static char expected[4096];
+    static char actual[4096];
+
+    for (size_t len = 0; len <= 200; len++) {
+        size_t n = reference_pem(expected, der, len);
+        // the PEM and its NUL terminator
+        CHECK(PEM_WRITER_SIZE(len, sizeof(LABEL) - 1) == n + 1);
+        for (size_t chunk = 1; chunk <= 7; chunk++) {
+            const char *pem = encode(actual, sizeof(actual), der, len, chunk);
+            CHECK(pem && strlen(pem) == n && 0 == memcmp(pem, expected, n));
+        }
+    }
+}
+
+static void test_exact_fit(const uint8_t *der) {
+    static char expected[4096];
+    static char actual[4096];
+    size_t n = reference_pem(expected, der, 100);
+
+    // the PEM and its NUL terminator
+    CHECK(encode(actual, n + 1, der, 100, 100) != NULL);
+    CHECK(encode(actual, n, der, 100, 100) == NULL);
+}
+
+// A whole DEVICE_CERTIFICATE_DER_SIZE DER into a buffer far too small for its PEM, in one call and in
+// chunks, with guard bytes around the writer and after the buffer
+static void test_overflow(const uint8_t *der) {
+    for (size_t chunk = 1; chunk <= DEVICE_CERTIFICATE_DER_SIZE; chunk = chunk * 4 + 1) {
+        struct {
+            uint8_t before[64];
+            pem_writer_t w;
+            uint8_t after[64];
+        } frame;
+        char buf[300 + 64];
+
+        memset(&frame, GUARD, sizeof(frame));
+        memset(buf, GUARD, sizeof(buf));
+        pem_writer_begin(&frame.w, buf, 300, LABEL);
+        bool ok = true;
+        for (size_t i = 0; i < DEVICE_CERTIFICATE_DER_SIZE; i += chunk) {
+            size_t len = DEVICE_CERTIFICATE_DER_SIZE - i < chunk ? DEVICE_CERTIFICATE_DER_SIZE - i : chunk;
+            ok = pem_writer_update(&frame.w, &der[i], len);
+        }
+        CHECK(!ok);
+        CHECK(pem_writer_finish(&frame.w, LABEL) == NULL);
+        CHECK(frame.w.len < 300);
+        CHECK(frame.w.pending_len < sizeof(frame.w.pending));
+        for (size_t i = 0; i < sizeof(frame.before); i++) {
+            CHECK(frame.before[i] == GUARD && frame.after[i] == GUARD);
+        }
+        for (size_t i = 300; i < sizeof(buf); i++) {
+            CHECK((uint8_t) buf[i] == GUARD);
+        }
+    }
+}
+
+int main(void) {
+    static uint8_t der[DEVICE_CERTIFICATE_DER_SIZE];
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(der); i++) {
+        der[i] = (uint8_t) rand();
+    }
+    test_lengths(der);
+    test_exact_fit(der);
+    test_overflow(der);
+    printf("pem_writer: %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
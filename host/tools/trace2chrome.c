@@ -0,0 +1,181 @@
+//
+// Copyright: Avnet 2021
+//
+// Converts the "#TRACE" dumps of source/trace.c in a debug UART log into
+// Chrome trace JSON (chrome://tracing, https://ui.perfetto.dev, speedscope).
+//
+// Usage: build/trace2chrome [uart.log] > trace.json
+//
+// Other log lines are skipped, so the whole console output can be fed in.
+// Every ring becomes a thread named after the task that owns it. Records
+// are placed relative to the dump they came with: the tick count resolves
+// the wraps of the 32 bit cycle counter and the cycle counter gives the
+// resolution within a tick.
+//
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_FORMAT_VERSION    (1)
+#define MAX_SPANS               (256)
+#define MAX_RINGS               (32)
+#define RECORD_SIZE             (12)
+#define NAME_LEN                (64)
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t tick;
+    uint16_t arg;
+    uint8_t span;
+    uint8_t phase;
+} record_t;
+
+typedef struct {
+    bool valid;
+    unsigned long hz;
+    unsigned long tick_hz;
+    uint32_t cycles;
+    uint32_t tick;
+} dump_t;
+
+static char span_names[MAX_SPANS][NAME_LEN];
+static char ring_names[MAX_RINGS][NAME_LEN];
+static bool ring_named[MAX_RINGS];
+static unsigned int depth[MAX_RINGS];
+static unsigned long events;
+static unsigned long dropped;
+static unsigned long lost;
+
+static uint32_t le32(const uint8_t *b) {
+    return (uint32_t) b[0] | (uint32_t) b[1] << 8 | (uint32_t) b[2] << 16 | (uint32_t) b[3] << 24;
+}
+
+static bool parse_record(const char *hex, record_t *record) {
+    uint8_t b[RECORD_SIZE];
+
+    for (int i = 0; i < RECORD_SIZE; i++) {
+        unsigned int byte;
+        if (1 != sscanf(&hex[i * 2], "%2x", &byte)) {
+            return false;
+        }
+        b[i] = (uint8_t) byte;
+    }
+    record->cycles = le32(&b[0]);
+    record->tick = le32(&b[4]);
+    record->arg = (uint16_t) (b[8] | b[9] << 8);
+    record->span = b[10];
+    record->phase = b[11];
+    return true;
+}
+
+// Microseconds since boot
+static double record_time_us(const dump_t *dump, const record_t *record) {
+    uint32_t tick_age = dump->tick - record->tick;
+    uint32_t cycles_age = dump->cycles - record->cycles;
+    // age from the tick count, corrected by the cycle counter, which is off by less than a tick
+    int64_t expected = (int64_t) ((uint64_t) tick_age * dump->hz / dump->tick_hz);
+    int64_t age = expected + (int32_t) (cycles_age - (uint32_t) expected);
+
+    return (double) dump->tick * 1e6 / dump->tick_hz - (double) age * 1e6 / dump->hz;
+}
+
+static void print_event(const char *name, char phase, int tid, double ts, long arg) {
+    printf("%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+            events++ ? "," : "", name, phase, tid, ts);
+    if (arg >= 0) {
+        printf(",\"args\":{\"arg\":%ld}", arg);
+    }
+    printf("}");
+}
+
+static void print_thread_name(int ring) {
+    printf("%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            events++ ? "," : "", ring, ring_names[ring]);
+    ring_named[ring] = true;
+}
+
+static void convert_data(const dump_t *dump, int ring, const char *hex) {
+    record_t record;
+
+    for (; strlen(hex) >= RECORD_SIZE * 2 && parse_record(hex, &record); hex += RECORD_SIZE * 2) {
+        const char *name = span_names[record.span][0] ? span_names[record.span] : "unknown";
+        double ts = record_time_us(dump, &record);
+
+        if (record.phase == 0) {
+            depth[ring]++;
+            print_event(name, 'B', ring, ts, record.arg ? (long) record.arg : -1);
+        } else if (depth[ring]) {
+            depth[ring]--;
+            print_event(name, 'E', ring, ts, -1);
+        } else {
+            dropped++; // its begin was overwritten before the dump
+        }
+    }
+}
+
+static void convert_line(char *line, dump_t *dump) {
+    char *trace = strstr(line, "#TRACE ");
+    char name[NAME_LEN];
+    int version, id, offset;
+    unsigned long cycles, tick, count;
+
+    if (!trace) {
+        return;
+    }
+    trace += strlen("#TRACE ");
+    trace[strcspn(trace, "\r\n")] = '\0';
+
+    if (5 == sscanf(trace, "begin %d %lu %lu %lu %lu", &version, &dump->hz, &dump->tick_hz, &cycles, &tick)) {
+        dump->valid = TRACE_FORMAT_VERSION == version && dump->hz && dump->tick_hz;
+        if (!dump->valid) {
+            fprintf(stderr, "Skipping a dump of format %d\n", version);
+        }
+        dump->cycles = (uint32_t) cycles;
+        dump->tick = (uint32_t) tick;
+    } else if (!dump->valid) {
+        return;
+    } else if (2 == sscanf(trace, "span %d %63s", &id, name) && id >= 0 && id < MAX_SPANS) {
+        strcpy(span_names[id], name);
+    } else if (1 == sscanf(trace, "task %d %n", &id, &offset) && id >= 0 && id < MAX_RINGS) {
+        if (!ring_named[id] || strncmp(ring_names[id], &trace[offset], NAME_LEN - 1)) {
+            snprintf(ring_names[id], NAME_LEN, "%s", &trace[offset]);
+            print_thread_name(id);
+        }
+    } else if (1 == sscanf(trace, "data %d %n", &id, &offset) && id >= 0 && id < MAX_RINGS) {
+        convert_data(dump, id, &trace[offset]);
+    } else if (1 == sscanf(trace, "end %lu", &count)) {
+        lost += count;
+        dump->valid = false;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    FILE *in = stdin;
+    char line[1024];
+    dump_t dump = { 0 };
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [uart.log] > trace.json\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && !(in = fopen(argv[1], "r"))) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    while (fgets(line, sizeof(line), in)) {
+        convert_line(line, &dump);
+    }
+    printf("\n]}\n");
+
+    fprintf(stderr, "%lu events, %lu records overwritten before a dump, %lu unmatched ends dropped\n",
+            events, lost, dropped);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return events ? 0 : 1;
+}
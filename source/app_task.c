@@ -34,6 +34,7 @@
 // Copyright: Avnet 2021
 // Modified by Nik Markovic <nikola.markovic@avnet.com> on 11/11/21.
 //
+#include <string.h>
 #include "math.h"
 #include "cyhal.h"
 #include "cybsp.h"
@@ -62,57 +63,37 @@
 
 #include "app_config.h"
 #include "app_task.h"
-
-#include "xensiv_pasco2_mtb.h"
-#include "xensiv_dps3xx_mtb.h"
-#include "xensiv_dps3xx.h"
+#include "telemetry_writer.h"
+#include "telemetry_batch.h"
+#include "telemetry_filter.h"
+#include "telemetry_store.h"
+#include "timestamp.h"
+#include "boot.h"
+#include "ram_map.h"
+#include "backoff.h"
+#include "tls_session_cache.h"
+#include "tls_arena.h"
+#include "discovery_cache.h"
+#include "periodic.h"
+
+#include "sensor_sampler.h"
+#include "i2c_bus.h"
+#include "runtime_stats.h"
+#include "trace.h"
 
 #include "optiga/pal/pal_os_event.h"
 #include "optiga/pal/pal_i2c.h"
 #include "optiga_trust.h"
 #include "optiga_trust_helpers.h"
+#include "optiga_pool.h"
+#include "optiga_event.h"
+#include "device_certificate.h"
 
 #define APP_VERSION "01.00.00"
 
-#if defined(TARGET_CYSBSYSKIT_DEV_01)
-/* Output pin for sensor PSEL line */
-#define MTB_PASCO2_PSEL (P5_3)
-/* Output pin for PAS CO2 Wing Board power switch */
-#define MTB_PASCO2_POWER_SWITCH (P10_5)
-/* Output pin for PAS CO2 Wing Board LED OK */
-#define MTB_PASCO2_LED_OK (P9_0)
-/* Output pin for PAS CO2 Wing Board LED WARNING  */
-#define MTB_PASCO2_LED_WARNING (P9_1)
-#endif
-
-/* Pin state to enable I2C channel of sensor */
-#define MTB_PASCO2_PSEL_I2C_ENABLE (0U)
-/* Pin state to enable power to sensor on PAS CO2 Wing Board*/
-#define MTB_PASCO2_POWER_ON (1U)
-/* Pin state for PAS CO2 Wing Board LED off. */
-#define MTB_PASCO_LED_STATE_OFF (0U)
-/* Pin state for PAS CO2 Wing Board LED on. */
-#define MTB_PASCO_LED_STATE_ON (1U)
-/* I2C bus frequency */
-#define I2C_MASTER_FREQUENCY (400000U)  //100000U
-
-#define DEFAULT_PRESSURE_VALUE (1015.0F)
-
-/* Delay time after hardware initialization */
-#define PASCO2_INITIALIZATION_DELAY (2000)
-
-/* Delay time after each PAS CO2 readout */
-#define PASCO2_PROCESS_DELAY (1000)
-
-#define CERT_BUF_SIZE	(1200)
-
-static xensiv_pasco2_t xensiv_pasco2;
-static cyhal_i2c_t cyhal_i2c;
-static xensiv_dps3xx_t dps310_sensor;
-
 /* We don't use CLIENT_CERTIFICATE memory but instead allocate a buffer and
  * populate it with teh certificate form the Secure Element */
-static char certificate[CERT_BUF_SIZE];
+static char certificate[DEVICE_CERTIFICATE_PEM_SIZE];
 
 
 /* Macro to check if the result of an operation was successful and set the
@@ -200,185 +181,469 @@ static cy_rslt_t wifi_connect(void) {
 }
 
 
-static void publish_telemetry() {
-    IotclMessageHandle msg = iotcl_telemetry_create();
+static telemetry_batch_t telemetry_batch;
+static telemetry_filter_t telemetry_filter;
+#if APP_TELEMETRY_STORE
+static telemetry_store_t telemetry_store;
+static telemetry_batch_t replay_batch;
+#endif
 
-    // Optional. The first time you create a data point, the current timestamp will be automatically added
-    // TelemetryAddWith* calls are only required if sending multiple data points in one packet.
-    iotcl_telemetry_add_with_iso_time(msg, iotcl_iso_timestamp_now());
-    iotcl_telemetry_set_string(msg, "version", APP_VERSION);
-    iotcl_telemetry_set_number(msg, "cpu", 3.123); // test floating point numbers
+typedef struct {
+    uint32_t connects;          // successful iotconnect_sdk_init() calls, each one a full TLS handshake
+    uint32_t connect_failures;
+    uint32_t drops;             // established connections that were lost
+    uint64_t total_uptime_ms;   // of the connections that ended so far
+    uint32_t longest_uptime_ms;
+} connection_stats_t;
 
+static connection_stats_t connection_stats;
 
-    uint16_t ppm = 0;
-    float32_t pressure = DEFAULT_PRESSURE_VALUE;
-    float32_t temperature = 0;
+// The periodic jobs of the App Task while connected, in the order they run when released together
+typedef enum {
+#if APP_TELEMETRY_DIAGNOSTICS
+    APP_JOB_DIAGNOSTICS,    // ahead of the publish that carries them
+#endif
+    APP_JOB_PUBLISH,
+#if APP_TIME_RESYNC_PERIOD_MS
+    APP_JOB_TIME_RESYNC,
+#endif
+    APP_JOB_COUNT
+} app_job_t;
+
+static periodic_job_t app_jobs[APP_JOB_COUNT];
+
+static void print_connection_stats(void) {
+    printf("Connections: %lu established, %lu failed, %lu dropped, uptime %lu s total, %lu s longest\n",
+            (unsigned long) connection_stats.connects,
+            (unsigned long) connection_stats.connect_failures,
+            (unsigned long) connection_stats.drops,
+            (unsigned long) (connection_stats.total_uptime_ms / 1000),
+            (unsigned long) (connection_stats.longest_uptime_ms / 1000));
+}
 
-    // Read the pressure and temperature data
-    if (xensiv_dps3xx_read(&dps310_sensor, &pressure, &temperature) == CY_RSLT_SUCCESS)
-    {
-        // Display the pressure and temperature data in console
-        printf("Pressure : %0.2f mBar", pressure);
-        // 0xF8 - ASCII Degree Symbol
-        printf("\t Temperature: %0.2f %cC \r\n\n", temperature, 0xF8);
-    }
-    else
-    {
-        printf("\n Failed to read temperature and pressure data.\r\n");
+// Moves new samples from the sampler queue into the batch, waiting up to 'timeout' for the next one
+static void collect_samples(TickType_t timeout) {
+    telemetry_sample_t sample;
+
+    // woken up by the sampler task for every new sample
+    ulTaskNotifyTake(pdTRUE, timeout);
+    while (sensor_sampler_pop(&sample)) {
+#if APP_TELEMETRY_STORE
+        // the oldest sample goes to flash rather than being overwritten
+        if (telemetry_batch.count == APP_TELEMETRY_BATCH_CAPACITY
+                && telemetry_store_append(&telemetry_store, telemetry_batch_get(&telemetry_batch, 0))) {
+            telemetry_batch_consume(&telemetry_batch, 1);
+        }
+#endif
+        telemetry_batch_add(&telemetry_batch, &sample);
     }
+}
 
-    /* Read CO2 value from sensor */
-    cy_rslt_t result = xensiv_pasco2_mtb_read(&xensiv_pasco2, (uint16_t)pressure, &ppm); //unit PPM
-    if (result != CY_RSLT_SUCCESS)
-    {
-    	printf("pasco2 sensor read error\r\n");
+// Waits for 'delay', while still taking samples off the sampler queue
+static void collect_samples_for(TickType_t delay) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed;
+
+    while ((elapsed = xTaskGetTickCount() - start) < delay) {
+        collect_samples(delay - elapsed);
     }
+}
 
-    //round the number to 2 decimal places
-    float temp = roundf(temperature * 100) / 100;
-    printf("\nTEMP is %f\r\n\n", temp);
+// Waits for the next backoff delay
+static void wait_for_retry(backoff_t *backoff) {
+    uint32_t delay_ms = backoff_next_delay_ms(backoff);
+
+    printf("Retry %lu in %lu ms\n", (unsigned long) backoff->attempts, (unsigned long) delay_ms);
+    collect_samples_for(pdMS_TO_TICKS(delay_ms));
+}
 
-    iotcl_telemetry_set_number(msg, "co2level", ppm);
-    iotcl_telemetry_set_number(msg, "temperature", temp);
-    iotcl_telemetry_set_number(msg, "pressure", pressure);
+// Without the certificate there is nothing to connect with. Keeps taking samples for APP_OPTIGA_FAILURE_RESET_MS,
+// moves them to the flash store and resets the MCU, which starts the OPTIGA again. The reset waits for up to a
+// page of samples more, until the store has written its RAM page buffer to flash, so that no sample is lost.
+static void reset_after_optiga_failure(void) {
+    printf("Error: No certificate from the OPTIGA, resetting in %lu ms\n", (unsigned long) APP_OPTIGA_FAILURE_RESET_MS);
+    collect_samples_for(pdMS_TO_TICKS(APP_OPTIGA_FAILURE_RESET_MS));
+#if APP_TELEMETRY_STORE
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS((telemetry_store.records_per_page + 1U) * APP_TELEMETRY_SAMPLE_PERIOD_MS);
+    for (;;) {
+        while (telemetry_batch.count && telemetry_store_append(&telemetry_store, telemetry_batch_get(&telemetry_batch, 0))) {
+            telemetry_batch_consume(&telemetry_batch, 1);
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        // no usable flash, or the samples are in flash
+        if (telemetry_batch.count || !telemetry_store.buffered || elapsed >= limit) {
+            break;
+        }
+        collect_samples(limit - elapsed);
+    }
+    uint32_t lost = telemetry_batch.count + telemetry_store.buffered;
+#else
+    uint32_t lost = telemetry_batch.count;
+#endif
+    printf("Resetting, %lu samples that are not in flash are lost\n", (unsigned long) lost);
+    cyhal_system_reset_device();
+}
 
+// FNV-1a hash of the device ID, so that devices pick different backoff delays
+static uint32_t device_seed(void) {
+    uint32_t hash = 2166136261U;
+    for (const char *c = IOTCONNECT_DUID; *c; c++) {
+        hash = (hash ^ (uint8_t) *c) * 16777619U;
+    }
+    return hash;
+}
 
-    const char *str = iotcl_create_serialized_string(msg, false);
-    iotcl_telemetry_destroy(msg);
-    printf("Sending: %s\n", str);
-    iotconnect_sdk_send_packet(str); // underlying code will report an error
-    iotcl_destroy_serialized(str);
+#if APP_TELEMETRY_DIAGNOSTICS
+static runtime_stats_t diagnostics;
+static bool diagnostics_pending;
 
+// APP_JOB_DIAGNOSTICS: takes a run-time stats sample for the next live message
+static void sample_diagnostics(void) {
+    if (runtime_stats_sample(&diagnostics)) {
+        runtime_stats_print(&diagnostics);
+        diagnostics_pending = true;
+    }
 }
 
-bool use_optiga_certificate(void)
-{
-	uint16_t certificate_size = 0;
-    /* This is the place where the certificate is initialized. This is a function
-     * which will allow to read it out and populate internal mbedtls settings wit it*/
-    read_certificate_from_optiga(0xe0e0, certificate, &certificate_size);
-
-    if (certificate_size && (certificate_size < CERT_BUF_SIZE)) {
-        printf("Your certificate is:\n%s\n", certificate);
-    	return true;
-    } else if (certificate_size) {
-        printf("Error: Certificate buffer overflow!\n");
-    	return false;
-    } else {
-        printf("Error: Optiga certificate read failed!\n");
-    	return false;
+// The stats to publish, if any
+static const runtime_stats_t *take_diagnostics(void) {
+    if (!diagnostics_pending) {
+        return NULL;
     }
+    diagnostics_pending = false;
+    return &diagnostics;
 }
 
+// "<prefix><task name>_<suffix>" with the task name in lower case and spaces replaced by underscores
+static const char *diagnostics_field(const char *prefix, const char *task, const char *suffix) {
+    static char name[sizeof("diag.") + configMAX_TASK_NAME_LEN + sizeof("_stack")];
+    size_t len = strlen(prefix);
 
-static void sensor_init(void)
-{
-    cy_rslt_t result;
+    memcpy(name, prefix, len);
+    for (; *task && len < sizeof(name) - sizeof("_stack"); task++) {
+        char c = *task;
+        name[len++] = (char) ((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) ? c : '_');
+    }
+    name[len++] = '_';
+    strcpy(&name[len], suffix);
+    return name;
+}
+#endif
 
-    // initialize i2c library
-    cyhal_i2c_cfg_t i2c_master_config = {CYHAL_I2C_MODE_MASTER,
-                                         0, // address is not used for master mode
-                                         I2C_MASTER_FREQUENCY};
+// Publishes up to 'max_points' of the oldest samples of 'batch' as one message. Live samples go through the
+// deadband filter and carry the diagnostics, replayed ones are published in full. The filter takes the values
+// as published only once the message was sent.
+// A message that does not fit into the buffer is built again without the diagnostics, which are kept for the
+// next message, and then with half of the samples, the rest staying in 'batch' for the next message.
+// Returns false if the message was not sent. The samples then stay in 'batch', except for a single sample that
+// can never be sent because it does not fit into a message on its own, which is dropped.
+static bool publish_telemetry(telemetry_batch_t *batch, uint16_t max_points, bool live) {
+    uint16_t count = batch->count < max_points ? batch->count : max_points;
+#if APP_TELEMETRY_DIAGNOSTICS
+    const runtime_stats_t *diag = live ? take_diagnostics() : NULL;
+#else
+    const void *diag = NULL; // no diagnostics that need a data point
+#endif
+    const char *str;
 
-    result = cyhal_i2c_init(&cyhal_i2c, CYBSP_I2C_SDA, CYBSP_I2C_SCL, NULL);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
-    result = cyhal_i2c_configure(&cyhal_i2c, &i2c_master_config);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
+    TRACE_BEGIN(TRACE_SPAN_PUBLISH);
+    for (;;) {
+        TRACE_BEGIN_ARG(TRACE_SPAN_JSON_BUILD, count);
 
-    // Initialize and enable PAS CO2 Wing Board I2C channel communication
-    result = cyhal_gpio_init(MTB_PASCO2_PSEL, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO2_PSEL_I2C_ENABLE);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
-    }
+#if (APP_TELEMETRY_SERIALIZER == TELEMETRY_SERIALIZER_STATIC)
+        static char telemetry_buffer[APP_TELEMETRY_BUFFER_SIZE];
+        telemetry_writer_t writer;
+
+        uint16_t points = 0;
+
+        telemetry_writer_begin(&writer, telemetry_buffer, sizeof(telemetry_buffer), iotcl_get_config());
+        for (uint16_t i = 0; i < count; i++) {
+            const telemetry_sample_t *sample = telemetry_batch_get(batch, i);
+            uint32_t report = live ? telemetry_filter_apply(&telemetry_filter, sample, telemetry_batch_get_added(batch, i))
+                    : TELEMETRY_FILTER_ALL & ~TELEMETRY_FILTER_STATIC;
+            if (!report && !(diag && i == count - 1)) {
+                continue;
+            }
+            telemetry_writer_add_point(&writer, sample->timestamp);
+            points++;
+            if (report & TELEMETRY_FILTER_STATIC) {
+                telemetry_writer_set_string(&writer, "version", APP_VERSION);
+                telemetry_writer_set_float(&writer, "cpu", 3.123f, 3); // test floating point numbers
+            }
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_CO2LEVEL)) {
+                telemetry_writer_set_int(&writer, "co2level", sample->co2level);
+            }
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_TEMPERATURE)) {
+                telemetry_writer_set_float(&writer, "temperature", sample->temperature, 2);
+            }
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_PRESSURE)) {
+                telemetry_writer_set_float(&writer, "pressure", sample->pressure, 2);
+            }
+        }
+#if APP_TELEMETRY_DIAGNOSTICS
+        // the diagnostics go with the most recent data point
+        if (diag && count) {
+            telemetry_writer_begin_object(&writer, "diag");
+            telemetry_writer_set_float(&writer, "cpu_load", diag->cpu_load_permille / 10.0f, 1);
+            telemetry_writer_set_int(&writer, "heap_used", (int32_t) diag->heap_used);
+            telemetry_writer_set_int(&writer, "heap_peak", (int32_t) diag->heap_peak);
+            for (uint8_t i = 0; i < diag->task_count; i++) {
+                const runtime_stats_task_t *task = &diag->tasks[i];
+                telemetry_writer_set_float(&writer, diagnostics_field("", task->name, "cpu"), task->cpu_permille / 10.0f, 1);
+                telemetry_writer_set_int(&writer, diagnostics_field("", task->name, "stack"), (int32_t) task->stack_free_min);
+            }
+            telemetry_writer_end_object(&writer);
+        }
+#endif
+        TRACE_END(TRACE_SPAN_JSON_BUILD);
+
+        if (!points) {
+            printf("No values outside the deadband in %u samples\n", (unsigned int) count);
+            telemetry_filter_message_suppressed(&telemetry_filter);
+            telemetry_filter_commit(&telemetry_filter);
+            telemetry_batch_consume(batch, count);
+            TRACE_END(TRACE_SPAN_PUBLISH);
+            return true;
+        }
+
+        TRACE_BEGIN(TRACE_SPAN_SERIALIZE);
+        str = telemetry_writer_finish(&writer);
+        TRACE_END(TRACE_SPAN_SERIALIZE);
+        if (str) {
+            break;
+        }
+        printf("Error: Telemetry message with %u samples does not fit into %d bytes\n", (unsigned int) count,
+                APP_TELEMETRY_BUFFER_SIZE);
+#else
+        IotclMessageHandle msg = iotcl_telemetry_create();
+        uint16_t points = 0;
+
+        // Every sample with values to publish becomes a data point with the timestamp of when it was taken.
+        for (uint16_t i = 0; i < count; i++) {
+            const telemetry_sample_t *sample = telemetry_batch_get(batch, i);
+            uint32_t report = live ? telemetry_filter_apply(&telemetry_filter, sample, telemetry_batch_get_added(batch, i))
+                    : TELEMETRY_FILTER_ALL & ~TELEMETRY_FILTER_STATIC;
+            if (!report && !(diag && i == count - 1)) {
+                continue;
+            }
+            iotcl_telemetry_add_with_iso_time(msg, sample->timestamp);
+            points++;
+            if (report & TELEMETRY_FILTER_STATIC) {
+                iotcl_telemetry_set_string(msg, "version", APP_VERSION);
+                iotcl_telemetry_set_number(msg, "cpu", 3.123); // test floating point numbers
+            }
+
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_CO2LEVEL)) {
+                iotcl_telemetry_set_number(msg, "co2level", sample->co2level);
+            }
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_TEMPERATURE)) {
+                iotcl_telemetry_set_number(msg, "temperature", sample->temperature);
+            }
+            if (report & TELEMETRY_FILTER_FIELD(TELEMETRY_FIELD_PRESSURE)) {
+                iotcl_telemetry_set_number(msg, "pressure", sample->pressure);
+            }
+        }
+#if APP_TELEMETRY_DIAGNOSTICS
+        // the diagnostics go with the most recent data point, as a "diag" object (dot separated path)
+        if (diag && count) {
+            iotcl_telemetry_set_number(msg, "diag.cpu_load", diag->cpu_load_permille / 10.0);
+            iotcl_telemetry_set_number(msg, "diag.heap_used", diag->heap_used);
+            iotcl_telemetry_set_number(msg, "diag.heap_peak", diag->heap_peak);
+            for (uint8_t i = 0; i < diag->task_count; i++) {
+                const runtime_stats_task_t *task = &diag->tasks[i];
+                iotcl_telemetry_set_number(msg, diagnostics_field("diag.", task->name, "cpu"), task->cpu_permille / 10.0);
+                iotcl_telemetry_set_number(msg, diagnostics_field("diag.", task->name, "stack"), task->stack_free_min);
+            }
+        }
+#endif
+        TRACE_END(TRACE_SPAN_JSON_BUILD);
+
+        if (!points) {
+            printf("No values outside the deadband in %u samples\n", (unsigned int) count);
+            iotcl_telemetry_destroy(msg);
+            telemetry_filter_message_suppressed(&telemetry_filter);
+            telemetry_filter_commit(&telemetry_filter);
+            telemetry_batch_consume(batch, count);
+            TRACE_END(TRACE_SPAN_PUBLISH);
+            return true;
+        }
 
-    // Initialize and enable PAS CO2 Wing Board power switch
-    result = cyhal_gpio_init(MTB_PASCO2_POWER_SWITCH, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO2_POWER_ON);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
+        TRACE_BEGIN(TRACE_SPAN_SERIALIZE);
+        str = iotcl_create_serialized_string(msg, false);
+        iotcl_telemetry_destroy(msg);
+        TRACE_END(TRACE_SPAN_SERIALIZE);
+        if (str) {
+            break;
+        }
+        printf("Error: Telemetry message with %u samples could not be serialized\n", (unsigned int) count);
+#endif
+        telemetry_filter_discard(&telemetry_filter);
+        if (diag) {
+            printf("Retrying without the diagnostics, they go with the next message\n");
+#if APP_TELEMETRY_DIAGNOSTICS
+            diagnostics_pending = true;
+#endif
+            diag = NULL;
+        } else if (count > 1) {
+            count /= 2;
+            printf("Retrying with %u samples\n", (unsigned int) count);
+        } else {
+            printf("Error: Dropping a sample that does not fit into a message on its own\n");
+            telemetry_batch_consume(batch, 1);
+            TRACE_END(TRACE_SPAN_PUBLISH);
+            return false;
+        }
     }
 
-    // Initialize the LEDs on PAS CO2 Wing Board
-    result = cyhal_gpio_init(MTB_PASCO2_LED_OK, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO_LED_STATE_OFF);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
+    printf("Sending %u samples: %s\n", (unsigned int) count, str);
+    TRACE_BEGIN_ARG(TRACE_SPAN_SEND, strlen(str));
+    iotconnect_sdk_send_packet(str); // underlying code will report an error
+    TRACE_END(TRACE_SPAN_SEND);
+#if (APP_TELEMETRY_SERIALIZER != TELEMETRY_SERIALIZER_STATIC)
+    iotcl_destroy_serialized(str);
+#endif
+    // The SDK does not return whether the message went out. A connection that dropped while it was sent is taken
+    // as a failure, and the samples are sent again with the next message.
+    if (!iotconnect_sdk_is_connected()) {
+        printf("Sending failed, %u samples stay queued\n", (unsigned int) count);
+        telemetry_filter_discard(&telemetry_filter);
+#if APP_TELEMETRY_DIAGNOSTICS
+        diagnostics_pending = diagnostics_pending || diag != NULL;
+#endif
+        TRACE_END(TRACE_SPAN_PUBLISH);
+        return false;
+    }
+    telemetry_filter_commit(&telemetry_filter);
+    telemetry_batch_consume(batch, count);
+    TRACE_END(TRACE_SPAN_PUBLISH);
+    // prints the boot profile after the first message sent
+    boot_phase_end(BOOT_PHASE_FIRST_SEND);
+
+    sensor_sampler_stats_t stats;
+    sensor_sampler_get_stats(&stats);
+    printf("Sampler: %lu samples, %lu dropped, queue depth %lu (max %lu), batch dropped %lu, %lu data ready timeouts\n",
+            (unsigned long) stats.samples, (unsigned long) stats.dropped,
+            (unsigned long) stats.depth, (unsigned long) stats.max_depth,
+            (unsigned long) telemetry_batch.dropped, (unsigned long) stats.data_ready_timeouts);
+    sensor_sampler_print_schedule();
+    for (int i = 0; i < APP_JOB_COUNT; i++) {
+        periodic_print_stats(&app_jobs[i]);
     }
+    i2c_bus_print_stats();
+    telemetry_filter_print_stats(&telemetry_filter);
+#if APP_TELEMETRY_STORE
+    telemetry_store_print_stats(&telemetry_store);
+#endif
+    tls_arena_print_stats();
+    print_connection_stats();
 
-    result = cyhal_gpio_init(MTB_PASCO2_LED_WARNING, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO_LED_STATE_OFF);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        CY_ASSERT(0);
+#if APP_TRACE_ENABLED
+    static uint32_t publishes;
+    if (++publishes % APP_TRACE_DUMP_PUBLISHES == 0) {
+        trace_dump();
     }
+#endif
+    return true;
+}
 
-    // Delay 2s to wait for pasco2 sensor get ready
-    vTaskDelay(pdMS_TO_TICKS(PASCO2_INITIALIZATION_DELAY));
+#if APP_TELEMETRY_STORE
+// Publishes the oldest samples of the flash store as one message
+static void replay_stored_telemetry(void) {
+    uint32_t stored = telemetry_store_count(&telemetry_store);
+    telemetry_sample_t sample;
 
-    // Initialize PAS CO2 sensor with default parameter values
-    result = xensiv_pasco2_mtb_init_i2c(&xensiv_pasco2, &cyhal_i2c);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        printf("PAS CO2 device initialization error\n");
-        printf("Exiting pasco2_task task\n");
-        // exit current thread (suspend)
-        return;
+    telemetry_batch_init(&replay_batch);
+    for (uint32_t i = 0; i < stored && i < APP_STORE_REPLAY_BATCH_SIZE; i++) {
+        if (!telemetry_store_get(&telemetry_store, i, &sample)) {
+            break;
+        }
+        telemetry_batch_add(&replay_batch, &sample);
     }
-    // Configure PAS CO2 Wing board interrupt to enable 12V boost converter in wingboard
-    xensiv_pasco2_interrupt_config_t int_config =
-    {
-        .b.int_func = XENSIV_PASCO2_INTERRUPT_FUNCTION_NONE,
-        .b.int_typ = (uint32_t)XENSIV_PASCO2_INTERRUPT_TYPE_LOW_ACTIVE
-    };
-
-    result = xensiv_pasco2_set_interrupt_config(&xensiv_pasco2, int_config);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        printf("PAS CO2 interrupt configuration error");
-        CY_ASSERT(0);
+    uint16_t count = replay_batch.count;
+    printf("Replaying %u of %lu stored samples\n", (unsigned int) count, (unsigned long) stored);
+    if (!count) {
+        // a sample that could not be read is dropped, so that the replay makes progress
+        telemetry_store_consume(&telemetry_store, 1);
+    } else {
+        // the samples taken off the batch were sent, or dropped because they will never fit into a message,
+        // the others stay in the store for the next replay
+        publish_telemetry(&replay_batch, APP_STORE_REPLAY_BATCH_SIZE, false);
+        telemetry_store_consume(&telemetry_store, count - replay_batch.count);
     }
+}
+#endif
 
-    cyhal_gpio_write(CYBSP_USER_LED, false); // USER_LED is active low
+#if APP_TIME_RESYNC_PERIOD_MS
+// APP_JOB_TIME_RESYNC: gets the time from SNTP again and moves the timestamps to it
+static void resync_time(void) {
+    int64_t before_ms = timestamp_now_ms();
+    TickType_t before = xTaskGetTickCount();
 
-    // Turn on status LED on PAS CO2 Wing Board to indicate normal operation
-    cyhal_gpio_write(MTB_PASCO2_LED_OK, MTB_PASCO_LED_STATE_ON);
+    if (0 != iotc_mtb_time_obtain(IOTCONNECT_SNTP_SERVER)) {
+        printf("Time resync failed, the timestamps keep counting ticks\n");
+        return;
+    }
+    timestamp_sync();
+    // what the timestamps moved by, beyond the time the resync took
+    int64_t step_ms = timestamp_now_ms() - before_ms - (int64_t) (xTaskGetTickCount() - before) * portTICK_PERIOD_MS;
+    printf("Time resynced, the timestamps moved by %ld ms\n", (long) step_ms);
+}
+#endif
 
+static void print_optiga_stats(void) {
+    optiga_pool_stats_t stats;
+    optiga_pool_get_stats(&stats);
+    printf("OPTIGA: %lu operations, %lu ms blocked (max %lu ms), %lu stalled, %lu TLS signatures in %lu ms\n",
+            (unsigned long) stats.operations, (unsigned long) stats.blocked_ms,
+            (unsigned long) stats.max_blocked_ms, (unsigned long) stats.stalls,
+            (unsigned long) stats.signatures, (unsigned long) stats.signing_ms);
+    printf("OPTIGA pool: %lu instances, %lu acquisitions, %lu acquire timeouts, %lu quarantined\n",
+            (unsigned long) stats.instances, (unsigned long) stats.acquisitions,
+            (unsigned long) stats.acquire_timeouts, (unsigned long) stats.quarantines);
+    optiga_event_print_stats();
+}
 
-    // Initialize pressure sensor
-    result = xensiv_dps3xx_mtb_init_i2c(&dps310_sensor, &cyhal_i2c,
-                                        XENSIV_DPS3XX_I2C_ADDR_ALT);
-    if (result != CY_RSLT_SUCCESS)
-    {
-        printf("\r\nFailed to initialize DPS310 I2C\r\n");
-        CY_ASSERT(0);
-    }
+static void print_certificate_stats(void) {
+    device_certificate_stats_t stats;
+    device_certificate_get_stats(&stats);
+    printf("Device certificate: parsed once, shared by %lu TLS connections, %lu other certificates parsed\n",
+            (unsigned long) stats.shared, (unsigned long) stats.parsed);
+}
 
-    uint32_t revisionID = 0;
+bool use_optiga_certificate(void)
+{
+    uint16_t der_size = 0;
+    /* The certificate is read as DER and parsed once. The PEM is what the SDK takes and
+     * its parse on each connection is answered from the parsed certificate (see device_certificate.h) */
+    read_certificate_der_from_optiga(0xe0e0, device_certificate_der_buffer(), DEVICE_CERTIFICATE_DER_SIZE, &der_size);
+    print_optiga_stats();
 
-    // Retrieve the DPS310 Revision ID and display the same
-    if (xensiv_dps3xx_get_revision_id(&dps310_sensor,(uint8_t*)&revisionID) == CY_RSLT_SUCCESS)
-    {
-        printf("DPS310 Revision ID = %d\r\n\n",(uint8_t)revisionID);
-    }
-    else
-    {
-        printf("Failed to get Revision ID\r\n");
-        CY_ASSERT(0);
+    if (!der_size) {
+        printf("Error: Optiga certificate read failed!\n");
+        return false;
+    } else if (!device_certificate_set(der_size, certificate, sizeof(certificate))) {
+        printf("Error: Optiga certificate is invalid or does not fit in the certificate buffer!\n");
+        return false;
     }
-
-    printf("PAS CO2 and DPSxxx pressure sensors initialized successfully\n\n");
+    printf("Your certificate is:\n%s\n", certificate);
+    return true;
 }
 
+
 void app_task(void *pvParameters) {
 
-    /* Initialize PAS CO2 sensor */
-    sensor_init();
+    /* Initialize PAS CO2 sensor. The sensors warm up while Wi-Fi is joined (see boot.h). */
+    if (!sensor_sampler_start(xTaskGetCurrentTaskHandle())) {
+        printf("Error: Failed to start the sensor sampler task\n");
+        vTaskDelete(NULL);
+    }
+    telemetry_batch_init(&telemetry_batch);
+    telemetry_filter_init(&telemetry_filter, sizeof("\"version\":\"" APP_VERSION "\",\"cpu\":3.123,") - 1);
+#if APP_TELEMETRY_STORE
+    // samples stay in RAM only if there is no usable flash
+    telemetry_store_init(&telemetry_store);
+#endif
 
     /* Configure the Wi-Fi interface as a Wi-Fi STA (i.e. Client). */
     cy_wcm_config_t config = { .interface = CY_WCM_INTERFACE_TYPE_STA };
@@ -386,33 +651,78 @@ void app_task(void *pvParameters) {
     /* To avoid compiler warnings */
     (void) pvParameters;
 
+    backoff_t backoff;
+    backoff_init(&backoff, APP_RECONNECT_BACKOFF_MIN_MS, APP_RECONNECT_BACKOFF_MAX_MS,
+            device_seed() ^ (uint32_t) xTaskGetTickCount());
+
     /* Create a message queue to communicate with other tasks and callbacks. */
     //mqtt_task_q = xQueueCreate(MQTT_TASK_QUEUE_LENGTH, sizeof(mqtt_task_cmd_t));
-    /* Initialize the Wi-Fi Connection Manager and jump to the cleanup block
-     * upon failure.
-     */
-    if (CY_RSLT_SUCCESS != cy_wcm_init(&config)) {
+    /* Initialize the Wi-Fi Connection Manager, retrying upon failure. */
+    boot_phase_begin(BOOT_PHASE_WIFI);
+    while (CY_RSLT_SUCCESS != cy_wcm_init(&config)) {
         printf("Error: Wi-Fi Connection Manager initialization failed!\n");
-        goto exit_cleanup;
+        wait_for_retry(&backoff);
     }
+    backoff_reset(&backoff);
 
-    /* Set the appropriate bit in the status_flag to denote successful
-     * WCM initialization.
-     */
     printf("Wi-Fi Connection Manager initialized.\n");
 
-    /* Initiate connection to the Wi-Fi AP and cleanup if the operation fails. */
-    if (CY_RSLT_SUCCESS != wifi_connect()) {
-        goto exit_cleanup;
+    /* Connect to the Wi-Fi AP and get the time, retrying until both succeed. */
+    for (;;) {
+        if (CY_RSLT_SUCCESS == wifi_connect()) {
+            boot_phase_end(BOOT_PHASE_WIFI);
+            boot_phase_begin(BOOT_PHASE_TIME);
+            if (0 == iotc_mtb_time_obtain(IOTCONNECT_SNTP_SERVER)) {
+                break;
+            }
+        }
+        // called functions will print errors
+        wait_for_retry(&backoff);
     }
+    backoff_reset(&backoff);
+    // the epoch offset of the telemetry timestamps, see timestamp.h
+    timestamp_sync();
+    // cached responses are checked against their age
+    discovery_cache_init();
+    // samples are timestamped, so the sampler starts sampling from here
+    boot_phase_end(BOOT_PHASE_TIME);
 
-    if (0 != iotc_mtb_time_obtain(IOTCONNECT_SNTP_SERVER)) {
-        // called function will print errors
-        return;
-    }
 
+    tls_session_cache_init();
 
-    for (int i = 0; i < 100; i++) {
+    // all tasks of the application run from here on
+    ram_map_add("Certificate", sizeof(certificate));
+#if (APP_TELEMETRY_SERIALIZER == TELEMETRY_SERIALIZER_STATIC)
+    ram_map_add("Telemetry message", APP_TELEMETRY_BUFFER_SIZE);
+#endif
+    ram_map_add("Telemetry batch", sizeof(telemetry_batch));
+#if APP_TELEMETRY_STORE
+    ram_map_add("Telemetry store", sizeof(telemetry_store) + sizeof(replay_batch));
+#endif
+    ram_map_print();
+#if APP_TELEMETRY_DIAGNOSTICS
+    // the first diagnostics cover the time from here
+    runtime_stats_restart();
+    periodic_job_init(&app_jobs[APP_JOB_DIAGNOSTICS], "Diagnostics", APP_DIAGNOSTICS_PERIOD_MS,
+            APP_TELEMETRY_PUBLISH_PHASE_MS);
+#endif
+    periodic_job_init(&app_jobs[APP_JOB_PUBLISH], "Publish", APP_TELEMETRY_BATCH_PERIOD_MS,
+            APP_TELEMETRY_PUBLISH_PHASE_MS);
+#if APP_TIME_RESYNC_PERIOD_MS
+    periodic_job_init(&app_jobs[APP_JOB_TIME_RESYNC], "Time resync", APP_TIME_RESYNC_PERIOD_MS,
+            APP_TIME_RESYNC_PHASE_MS);
+#endif
+
+    // the TLS client authenticates with the certificate that the Optiga Client Task reads
+    if (!boot_wait(BOOT_BIT(BOOT_PHASE_OPTIGA))) {
+        reset_after_optiga_failure();
+    }
+
+    for (;;) {
+        if (!cy_wcm_is_connected_to_ap() && CY_RSLT_SUCCESS != wifi_connect()) {
+            wait_for_retry(&backoff);
+            continue;
+        }
 
         IotConnectClientConfig *iotc_config = iotconnect_sdk_init_and_get_config();
         iotc_config->duid = IOTCONNECT_DUID;
@@ -426,20 +736,97 @@ void app_task(void *pvParameters) {
         }
 
 
+        boot_phase_begin(BOOT_PHASE_CONNECT);
+        discovery_cache_connect_begin();
         cy_rslt_t ret = iotconnect_sdk_init();
+        discovery_cache_connect_end(CY_RSLT_SUCCESS == ret);
         if (CY_RSLT_SUCCESS != ret) {
             printf("Failed to initialize the IoTConnect SDK. Error code: %lu\n", ret);
-            goto exit_cleanup;
+            connection_stats.connect_failures++;
+            iotconnect_sdk_disconnect();
+            wait_for_retry(&backoff);
+            continue;
         }
+        backoff_reset(&backoff);
+        boot_phase_end(BOOT_PHASE_CONNECT);
+        boot_phase_begin(BOOT_PHASE_FIRST_SEND);
+        connection_stats.connects++;
+        telemetry_filter_reset(&telemetry_filter);
+        tls_session_cache_print_report();
+        tls_arena_print_stats();
+        discovery_cache_print_stats();
+        print_certificate_stats();
+        print_optiga_stats();
+        TickType_t connected_since = xTaskGetTickCount();
+#if APP_TELEMETRY_STORE
+        TickType_t replayed_at = connected_since;
+#endif
+        // the jobs did not run while disconnected, their next release is the next one on the grid
+        for (int i = 0; i < APP_JOB_COUNT; i++) {
+            periodic_job_start(&app_jobs[i]);
+        }
+#if APP_TELEMETRY_DIAGNOSTICS
+        // nor did the diagnostics, and the run-time counter may have wrapped since the last sample
+        runtime_stats_restart();
+#endif
 
-        for (int j = 0; iotconnect_sdk_is_connected() && j < 3; j++) {
-            publish_telemetry();
-            vTaskDelay(pdMS_TO_TICKS(10000));
+        // With APP_PUBLISHES_PER_CONNECTION set to 0 the connection is kept until it fails
+        for (int j = 0; iotconnect_sdk_is_connected() && (APP_PUBLISHES_PER_CONNECTION == 0 || j < APP_PUBLISHES_PER_CONNECTION);) {
+            // woken up by every sample and by the next release of a job
+            TickType_t wait = periodic_ticks_until(app_jobs, APP_JOB_COUNT);
+#if APP_TELEMETRY_STORE
+            // the backlog is replayed between the live messages, at a bounded rate
+            bool replay = telemetry_store_count(&telemetry_store) != 0;
+            if (replay && wait > pdMS_TO_TICKS(APP_STORE_REPLAY_PERIOD_MS)) {
+                wait = pdMS_TO_TICKS(APP_STORE_REPLAY_PERIOD_MS);
+            }
+#endif
+            collect_samples(wait);
+#if APP_TELEMETRY_DIAGNOSTICS
+            if (periodic_begin(&app_jobs[APP_JOB_DIAGNOSTICS])) {
+                sample_diagnostics();
+                periodic_end(&app_jobs[APP_JOB_DIAGNOSTICS]);
+            }
+#endif
+            if (iotconnect_sdk_is_connected() && periodic_begin(&app_jobs[APP_JOB_PUBLISH])) {
+                collect_samples(0);
+                while (iotconnect_sdk_is_connected() && telemetry_batch.count) {
+                    j++;
+                    if (!publish_telemetry(&telemetry_batch, APP_TELEMETRY_BATCH_SIZE, true)) {
+                        break;
+                    }
+                }
+                periodic_end(&app_jobs[APP_JOB_PUBLISH]);
+            }
+#if APP_TIME_RESYNC_PERIOD_MS
+            if (iotconnect_sdk_is_connected() && periodic_begin(&app_jobs[APP_JOB_TIME_RESYNC])) {
+                resync_time();
+                periodic_end(&app_jobs[APP_JOB_TIME_RESYNC]);
+            }
+#endif
+#if APP_TELEMETRY_STORE
+            if (replay && iotconnect_sdk_is_connected()
+                    && xTaskGetTickCount() - replayed_at >= pdMS_TO_TICKS(APP_STORE_REPLAY_PERIOD_MS)) {
+                replay_stored_telemetry();
+                replayed_at = xTaskGetTickCount();
+                j++;
+            }
+#endif
         }
 
+        bool dropped = !iotconnect_sdk_is_connected();
         iotconnect_sdk_disconnect();
-    }
-    exit_cleanup: printf("\nAppTask Done.\nTerminating the AppTask...\n");
-    vTaskDelete(NULL);
 
+        uint32_t uptime_ms = (uint32_t) ((xTaskGetTickCount() - connected_since) * portTICK_PERIOD_MS);
+        connection_stats.total_uptime_ms += uptime_ms;
+        if (uptime_ms > connection_stats.longest_uptime_ms) {
+            connection_stats.longest_uptime_ms = uptime_ms;
+        }
+        if (dropped) {
+            connection_stats.drops++;
+            printf("Connection lost after %lu s\n", (unsigned long) (uptime_ms / 1000));
+            print_connection_stats();
+            wait_for_retry(&backoff);
+        }
+    }
 }
@@ -0,0 +1,37 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include "backoff.h"
+
+// xorshift32. Only used to spread retries, so it does not need to be a good generator.
+static uint32_t next_random(backoff_t *b) {
+    uint32_t x = b->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    b->seed = x;
+    return x;
+}
+
+void backoff_init(backoff_t *b, uint32_t min_ms, uint32_t max_ms, uint32_t seed) {
+    b->min_ms = min_ms ? min_ms : 1;
+    b->max_ms = max_ms > b->min_ms ? max_ms : b->min_ms;
+    b->seed = seed ? seed : 0x9E3779B9U; // xorshift must not start from 0
+    backoff_reset(b);
+}
+
+uint32_t backoff_next_delay_ms(backoff_t *b) {
+    uint32_t limit = b->current_ms;
+    uint32_t half = limit / 2;
+    uint32_t delay = half + next_random(b) % (limit - half + 1);
+
+    b->attempts++;
+    b->current_ms = (limit > b->max_ms / 2) ? b->max_ms : limit * 2;
+    return delay;
+}
+
+void backoff_reset(backoff_t *b) {
+    b->current_ms = b->min_ms;
+    b->attempts = 0;
+}
@@ -0,0 +1,33 @@
+//
+// Copyright: Avnet 2021
+//
+// Capped exponential backoff with jitter for connection retries.
+//
+// The n-th retry waits a random time between half and all of
+// min(min_ms * 2^n, max_ms), so that a fleet of devices that lost the
+// connection at the same time does not reconnect in lockstep.
+//
+
+#ifndef BACKOFF_H_
+#define BACKOFF_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t current_ms;    // upper bound of the next delay
+    uint32_t attempts;      // retries since the last backoff_reset()
+    uint32_t seed;
+} backoff_t;
+
+/* 'seed' should differ between devices, e.g. a hash of the device ID */
+void backoff_init(backoff_t *b, uint32_t min_ms, uint32_t max_ms, uint32_t seed);
+
+/* Returns the time to wait before the next retry and doubles the limit for the one after it */
+uint32_t backoff_next_delay_ms(backoff_t *b);
+
+/* Call after a successful connection */
+void backoff_reset(backoff_t *b);
+
+#endif // BACKOFF_H_
@@ -0,0 +1,106 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+
+#include "boot.h"
+
+#define BOOT_NOT_YET        (UINT32_MAX)
+
+typedef struct {
+    uint32_t begin_ms;
+    uint32_t end_ms;
+    bool failed;
+} boot_phase_record_t;
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    "OPTIGA", "Sensors", "Wi-Fi", "Time", "Connect", "Send"
+};
+
+static StaticEventGroup_t boot_group_memory;
+static EventGroupHandle_t boot_group;
+static boot_phase_record_t phases[BOOT_PHASE_COUNT];
+
+static uint32_t now_ms(void) {
+    return (uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+void boot_init(void) {
+    boot_group = xEventGroupCreateStatic(&boot_group_memory);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        phases[i] = (boot_phase_record_t) { BOOT_NOT_YET, BOOT_NOT_YET, false };
+    }
+}
+
+void boot_phase_begin(boot_phase_t phase) {
+    uint32_t now = now_ms();
+
+    taskENTER_CRITICAL();
+    if (phases[phase].begin_ms == BOOT_NOT_YET) {
+        phases[phase].begin_ms = now;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void boot_phase_end(boot_phase_t phase) {
+    uint32_t now = now_ms();
+    bool first = false;
+
+    taskENTER_CRITICAL();
+    if (phases[phase].end_ms == BOOT_NOT_YET) {
+        phases[phase].end_ms = now;
+        first = true;
+    }
+    taskEXIT_CRITICAL();
+    if (first) {
+        xEventGroupSetBits(boot_group, BOOT_BIT(phase));
+        if (phase == BOOT_PHASE_FIRST_SEND) {
+            boot_print_profile();
+        }
+    }
+}
+
+void boot_phase_fail(boot_phase_t phase) {
+    printf("Error: Boot phase %s failed\n", phase_names[phase]);
+    // the phase is over for the tasks waiting for it
+    phases[phase].failed = true;
+    xEventGroupSetBits(boot_group, BOOT_BIT(phase));
+}
+
+bool boot_wait(uint32_t wanted) {
+    xEventGroupWaitBits(boot_group, wanted, pdFALSE, pdTRUE, portMAX_DELAY);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if ((wanted & BOOT_BIT(i)) && phases[i].failed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void boot_print_profile(void) {
+    uint32_t serial_ms = 0;
+
+    printf("Boot profile (ms from the start of the scheduler):\n");
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        const boot_phase_record_t *p = &phases[i];
+        if (p->begin_ms == BOOT_NOT_YET) {
+            printf("  %-8s not started\n", phase_names[i]);
+        } else if (p->end_ms == BOOT_NOT_YET) {
+            printf("  %-8s %6lu .. %s\n", phase_names[i], (unsigned long) p->begin_ms, p->failed ? "failed" : "running");
+        } else {
+            printf("  %-8s %6lu .. %6lu  %6lu ms\n", phase_names[i], (unsigned long) p->begin_ms,
+                    (unsigned long) p->end_ms, (unsigned long) (p->end_ms - p->begin_ms));
+            serial_ms += p->end_ms - p->begin_ms;
+        }
+    }
+    if (phases[BOOT_PHASE_FIRST_SEND].end_ms != BOOT_NOT_YET) {
+        // what the phases would take one after the other
+        printf("  First message sent after %lu ms, the phases add up to %lu ms\n",
+                (unsigned long) phases[BOOT_PHASE_FIRST_SEND].end_ms, (unsigned long) serial_ms);
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Copyright: Avnet 2021
+//
+// Boot pipeline and profile.
+//
+// The start-up work runs in several tasks at once, ordered by what each phase
+// needs rather than one after the other:
+//
+//   OPTIGA   - OPTIGA init and certificate read (Optiga Client Task)
+//   Sensors  - I2C bus, sensor init and the PAS CO2 warm-up (Sensor Sampler)
+//   Wi-Fi    - Wi-Fi join (App Task)
+//   Time     - SNTP, after Wi-Fi (App Task)
+//   Connect  - IoTConnect connection, after OPTIGA and Time (App Task)
+//   Send     - from the connection to the first message sent (App Task)
+//
+// Sampling starts after Sensors and Time. A task that needs the result of a
+// phase run by another task waits for it with boot_wait(), which is an event
+// group barrier.
+//
+// When the first message was sent, the start and end of every phase and the
+// time from the start of the scheduler to that send are printed. The SDK does
+// not report the PUBACK, so a message counts as sent when the connection is
+// still up after iotconnect_sdk_send_packet() returned. The board and debug
+// UART init in main() before the scheduler starts is not included.
+//
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+typedef enum {
+    BOOT_PHASE_OPTIGA,
+    BOOT_PHASE_SENSORS,
+    BOOT_PHASE_WIFI,
+    BOOT_PHASE_TIME,
+    BOOT_PHASE_CONNECT,
+    BOOT_PHASE_FIRST_SEND,
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+#define BOOT_BIT(phase)     ((uint32_t) 1 << (phase))
+
+/* Call once before the scheduler starts */
+void boot_init(void);
+
+/* Only the first call of each for a phase counts, so that retry loops can call them on every attempt */
+void boot_phase_begin(boot_phase_t phase);
+void boot_phase_end(boot_phase_t phase);
+
+/* The phase will not complete. boot_wait() for it returns false. */
+void boot_phase_fail(boot_phase_t phase);
+
+/* Waits until all phases in 'phases' (BOOT_BIT() values) have ended. False if one of them failed. */
+bool boot_wait(uint32_t phases);
+
+void boot_print_profile(void);
+
+#endif // BOOT_H_
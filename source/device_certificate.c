@@ -0,0 +1,97 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mbedtls/platform.h"
+#include "mbedtls/x509_crt.h"
+
+#include "pem_writer.h"
+#include "device_certificate.h"
+
+static uint8_t der[DEVICE_CERTIFICATE_DER_SIZE];
+static mbedtls_x509_crt certificate;
+static bool certificate_valid;
+static const char *certificate_pem;
+static size_t certificate_pem_len;
+static device_certificate_stats_t stats;
+
+int __real_mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen);
+void __real_mbedtls_x509_crt_free(mbedtls_x509_crt *crt);
+
+uint8_t *device_certificate_der_buffer(void) {
+    return der;
+}
+
+bool device_certificate_set(uint16_t der_length, char *pem, size_t pem_size) {
+    pem_writer_t writer;
+    int ret;
+
+    if (certificate_valid) {
+        __real_mbedtls_x509_crt_free(&certificate);
+        certificate_valid = false;
+    }
+    if (der_length > sizeof(der)) {
+        return false;
+    }
+
+    // the certificate points into 'der' instead of keeping a heap copy
+    mbedtls_x509_crt_init(&certificate);
+    ret = mbedtls_x509_crt_parse_der_nocopy(&certificate, der, der_length);
+    if (0 != ret) {
+        printf("Failed to parse the device certificate. Error: -0x%04x\n", (unsigned int) -ret);
+        __real_mbedtls_x509_crt_free(&certificate);
+        return false;
+    }
+
+    pem_writer_begin(&writer, pem, pem_size, "CERTIFICATE");
+    pem_writer_update(&writer, der, der_length);
+    if (!pem_writer_finish(&writer, "CERTIFICATE")) {
+        __real_mbedtls_x509_crt_free(&certificate);
+        return false;
+    }
+    certificate_pem = pem;
+    certificate_pem_len = writer.len;
+    certificate_valid = true;
+    return true;
+}
+
+void device_certificate_get_stats(device_certificate_stats_t *out) {
+    *out = stats;
+}
+
+static bool is_device_certificate_pem(const unsigned char *buf, size_t buflen) {
+    // PEM input to mbedTLS includes the NUL terminator
+    if (!certificate_valid || buflen != certificate_pem_len + 1) {
+        return false;
+    }
+    return (const char *) buf == certificate_pem || 0 == memcmp(buf, certificate_pem, buflen);
+}
+
+int __wrap_mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen) {
+    // only an empty chain can share the parsed certificate, which has no successor
+    if (0 == chain->version && is_device_certificate_pem(buf, buflen)) {
+        *chain = certificate;
+        stats.shared++;
+        return 0;
+    }
+    stats.parsed++;
+    return __real_mbedtls_x509_crt_parse(chain, buf, buflen);
+}
+
+void __wrap_mbedtls_x509_crt_free(mbedtls_x509_crt *crt) {
+    if (crt && crt != &certificate && certificate_valid && crt->raw.p == certificate.raw.p) {
+        // Certificates parsed into the chain after the shared one are its own. The real free releases
+        // everything from 'next' on but the first node itself, which the chain allocated.
+        if (crt->next) {
+            __real_mbedtls_x509_crt_free(crt->next);
+            mbedtls_free(crt->next);
+        }
+        // the names, extensions and key of the first node belong to 'certificate'
+        mbedtls_x509_crt_init(crt);
+        return;
+    }
+    __real_mbedtls_x509_crt_free(crt);
+}
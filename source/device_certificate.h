@@ -0,0 +1,53 @@
+//
+// Copyright: Avnet 2021
+//
+// Device certificate, parsed once per boot.
+//
+// The IoTConnect SDK only takes the device certificate as a PEM string, and
+// the TLS layer underneath parses it into a new mbedtls_x509_crt for every
+// connection: base64 decoding, a heap copy of the DER and the X.509 parse.
+// The certificate is kept here as DER and parsed once instead, and the
+// parse of the PEM handed to the SDK is answered from that through linker
+// wrappers (see LDFLAGS in the Makefile):
+//
+// - mbedtls_x509_crt_parse() of the device certificate PEM shares the
+//   parsed certificate instead of parsing it again.
+// - mbedtls_x509_crt_free() of such a shared certificate only forgets it,
+//   and frees the certificates that were parsed into the chain after it.
+//
+// Any other certificate, like the root CA, is parsed as usual.
+//
+
+#ifndef DEVICE_CERTIFICATE_H_
+#define DEVICE_CERTIFICATE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pem_writer.h"
+
+/* Largest DER certificate that can be held: the size of an OPTIGA Trust M certificate data object */
+#define DEVICE_CERTIFICATE_DER_SIZE (1728U)
+
+/* PEM of the largest certificate, with the NUL terminator */
+#define DEVICE_CERTIFICATE_PEM_SIZE PEM_WRITER_SIZE(DEVICE_CERTIFICATE_DER_SIZE, sizeof("CERTIFICATE") - 1)
+
+typedef struct {
+    uint32_t shared;    // TLS connections that used the parsed certificate
+    uint32_t parsed;    // other certificates parsed by the TLS layer
+} device_certificate_stats_t;
+
+/* Buffer for the DER certificate, to be filled with device_certificate_set() */
+uint8_t *device_certificate_der_buffer(void);
+
+/*
+ * Parses the 'der_length' bytes in device_certificate_der_buffer() and writes their PEM to 'pem',
+ * the string that is handed to the IoTConnect SDK. Returns false if the certificate cannot be
+ * parsed or its PEM does not fit.
+ */
+bool device_certificate_set(uint16_t der_length, char *pem, size_t pem_size);
+
+void device_certificate_get_stats(device_certificate_stats_t *stats);
+
+#endif // DEVICE_CERTIFICATE_H_
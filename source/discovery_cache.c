@@ -0,0 +1,316 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "iotc_http_request.h"
+
+#include "discovery_cache.h"
+#include "ram_map.h"
+#include "timestamp.h"
+
+#define CACHE_MAGIC         (0x44434348UL) // "DCCH"
+#define CACHE_FLASH_ALIGN   (512U)
+
+typedef struct {
+    uint32_t key;               // FNV-1a of the host, path and request body, 0 if the entry is free
+    bool valid;                 // a connection made with the response succeeded
+    uint16_t length;
+    int64_t fetched_at;         // seconds since 1970
+    char body[DISCOVERY_CACHE_BODY_SIZE];
+} cache_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;          // FNV-1a of the entries
+    cache_entry_t entries[DISCOVERY_CACHE_ENTRIES];
+} cache_image_t;
+
+// Phases of one iotconnect_sdk_init() call
+typedef enum {
+    PHASE_DISCOVERY,
+    PHASE_SYNC,
+    PHASE_COUNT
+} phase_t;
+
+static const char *const phase_names[PHASE_COUNT] = { "discovery", "sync" };
+
+// written to flash as is, in whole pages
+static union {
+    cache_image_t image;
+    uint32_t words[(sizeof(cache_image_t) + CACHE_FLASH_ALIGN - 1) / CACHE_FLASH_ALIGN * CACHE_FLASH_ALIGN / sizeof(uint32_t)];
+} cache;
+
+static discovery_cache_stats_t stats;
+static TickType_t connect_started_at;
+static uint32_t phase_ms[PHASE_COUNT];
+static bool phase_cached[PHASE_COUNT];
+static uint8_t used_entries;    // bit mask of the entries used by the current connection
+static bool requested;          // an HTTPS request was made for the current connection
+
+int __real_iotconnect_https_request(IotConnectHttpResponse *response, const char *host, const char *path,
+        const char *send_str);
+
+#if APP_DISCOVERY_CACHE_FLASH
+static cyhal_flash_t flash;
+static uint32_t flash_address;  // 0 if the cache is not kept in flash
+static uint32_t flash_page_size;
+#endif
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return hash;
+}
+
+static uint32_t request_key(const char *host, const char *path, const char *send_str) {
+    uint32_t hash = fnv1a(2166136261U, host, strlen(host) + 1);
+    hash = fnv1a(hash, path, strlen(path) + 1);
+    if (send_str) {
+        hash = fnv1a(hash, send_str, strlen(send_str));
+    }
+    return hash ? hash : 1;
+}
+
+#if APP_DISCOVERY_CACHE_FLASH
+static void flash_load(void) {
+    cyhal_flash_info_t info;
+
+    if (CY_RSLT_SUCCESS != cyhal_flash_init(&flash)) {
+        return;
+    }
+    cyhal_flash_get_info(&flash, &info);
+
+    // the main flash holds the running application
+    const cyhal_flash_block_info_t *block = NULL;
+    for (uint8_t i = 0; i < info.block_count; i++) {
+        if (info.blocks[i].start_address == CY_EM_EEPROM_BASE) {
+            block = &info.blocks[i];
+        }
+    }
+    if (!block) {
+        printf("Discovery cache: no work flash, kept in RAM only\n");
+        return;
+    }
+    // the telemetry store takes the start of the block
+    uint32_t reserved = (APP_TELEMETRY_STORE ? APP_STORE_FLASH_SIZE : 0) + sizeof(cache.words);
+    if (block->size < reserved || sizeof(cache.words) % block->page_size) {
+        printf("Discovery cache: no room in flash, kept in RAM only\n");
+        return;
+    }
+    flash_address = block->start_address + block->size - sizeof(cache.words);
+    flash_page_size = block->page_size;
+
+    if (CY_RSLT_SUCCESS != cyhal_flash_read(&flash, flash_address, (uint8_t *) cache.words, sizeof(cache.words))
+            || cache.image.magic != CACHE_MAGIC
+            || cache.image.checksum != fnv1a(2166136261U, cache.image.entries, sizeof(cache.image.entries))) {
+        memset(&cache, 0, sizeof(cache));
+    }
+}
+
+static void flash_save(void) {
+    if (!flash_address) {
+        return;
+    }
+    cache.image.magic = CACHE_MAGIC;
+    cache.image.checksum = fnv1a(2166136261U, cache.image.entries, sizeof(cache.image.entries));
+    for (uint32_t offset = 0; offset < sizeof(cache.words); offset += flash_page_size) {
+        if (CY_RSLT_SUCCESS != cyhal_flash_write(&flash, flash_address + offset, &cache.words[offset / sizeof(uint32_t)])) {
+            printf("Error: Discovery cache: flash write failed\n");
+            return;
+        }
+    }
+}
+#else
+static void flash_save(void) {
+}
+#endif
+
+void discovery_cache_init(void) {
+#if APP_DISCOVERY_CACHE_FLASH
+    flash_load();
+#endif
+    ram_map_add("Discovery cache", sizeof(cache));
+    uint8_t loaded = 0;
+    for (int i = 0; i < DISCOVERY_CACHE_ENTRIES; i++) {
+        if (cache.image.entries[i].valid) {
+            loaded++;
+        }
+    }
+    if (loaded) {
+        printf("Discovery cache: %u responses loaded from flash\n", (unsigned int) loaded);
+    }
+}
+
+static bool is_fresh(const cache_entry_t *entry, int64_t now) {
+    return entry->valid && now >= entry->fetched_at && now - entry->fetched_at < APP_DISCOVERY_CACHE_TTL_S;
+}
+
+// The entry for 'key', a free one, or the one fetched the longest time ago
+static int entry_for(uint32_t key) {
+    int slot = 0;
+    for (int i = 0; i < DISCOVERY_CACHE_ENTRIES; i++) {
+        const cache_entry_t *entry = &cache.image.entries[i];
+        if (entry->key == key) {
+            return i;
+        }
+        if (!entry->key) {
+            slot = i;
+        } else if (cache.image.entries[slot].key && entry->fetched_at < cache.image.entries[slot].fetched_at) {
+            slot = i;
+        }
+    }
+    return slot;
+}
+
+static bool lookup(IotConnectHttpResponse *response, uint32_t key) {
+    int i = entry_for(key);
+    cache_entry_t *entry = &cache.image.entries[i];
+
+    if (!APP_DISCOVERY_CACHE || entry->key != key || !is_fresh(entry, timestamp_now())) {
+        return false;
+    }
+    // freed by the SDK with iotconnect_free_https_response()
+    response->data = malloc(entry->length + 1U);
+    if (!response->data) {
+        return false;
+    }
+    memcpy(response->data, entry->body, entry->length);
+    response->data[entry->length] = '\0';
+    used_entries |= (uint8_t) (1U << i);
+    stats.hits++;
+    return true;
+}
+
+static void store(uint32_t key, const char *body) {
+    size_t length = strlen(body);
+
+    if (!APP_DISCOVERY_CACHE) {
+        return;
+    }
+    if (length > sizeof(cache.image.entries[0].body)) {
+        stats.too_large++;
+        return;
+    }
+    int i = entry_for(key);
+    cache_entry_t *entry = &cache.image.entries[i];
+    // kept once the connection succeeds
+    entry->key = key;
+    entry->valid = false;
+    entry->length = (uint16_t) length;
+    entry->fetched_at = timestamp_now();
+    memcpy(entry->body, body, length);
+    used_entries |= (uint8_t) (1U << i);
+}
+
+int __wrap_iotconnect_https_request(IotConnectHttpResponse *response, const char *host, const char *path,
+        const char *send_str) {
+    // discovery is a GET, sync a POST
+    phase_t phase = send_str ? PHASE_SYNC : PHASE_DISCOVERY;
+    uint32_t key = request_key(host, path, send_str);
+    TickType_t start = xTaskGetTickCount();
+    int ret = 0;
+
+    phase_cached[phase] = lookup(response, key);
+    if (!phase_cached[phase]) {
+        requested = true;
+        stats.fetches++;
+        ret = __real_iotconnect_https_request(response, host, path, send_str);
+        if (response->data) {
+            store(key, response->data);
+        }
+    }
+    phase_ms[phase] += (uint32_t) ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS);
+    return ret;
+}
+
+void discovery_cache_connect_begin(void) {
+    connect_started_at = xTaskGetTickCount();
+    memset(phase_ms, 0, sizeof(phase_ms));
+    memset(phase_cached, 0, sizeof(phase_cached));
+    used_entries = 0;
+    requested = false;
+}
+
+static void drop_entries(uint8_t mask) {
+    bool was_valid = false;
+
+    for (int i = 0; i < DISCOVERY_CACHE_ENTRIES; i++) {
+        if (mask & (1U << i)) {
+            was_valid |= cache.image.entries[i].valid;
+            if (cache.image.entries[i].valid) {
+                stats.invalidated++;
+            }
+            memset(&cache.image.entries[i], 0, sizeof(cache.image.entries[i]));
+        }
+    }
+    if (was_valid) {
+        flash_save();
+    }
+}
+
+void discovery_cache_connect_end(bool connected) {
+    uint32_t total_ms = (uint32_t) ((xTaskGetTickCount() - connect_started_at) * portTICK_PERIOD_MS);
+    uint32_t broker_ms = total_ms;
+
+    printf("Connect: ");
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        printf("%s %lu ms%s, ", phase_names[phase], (unsigned long) phase_ms[phase], phase_cached[phase] ? " (cached)" : "");
+        broker_ms -= phase_ms[phase] < broker_ms ? phase_ms[phase] : broker_ms;
+    }
+    printf("broker %lu ms, %lu ms in total%s\n", (unsigned long) broker_ms, (unsigned long) total_ms,
+            connected ? "" : ", failed");
+
+    if (!connected) {
+        drop_entries(used_entries);
+        return;
+    }
+    if (requested) {
+        stats.fetched_connects++;
+        stats.fetched_connect_ms += total_ms;
+    } else {
+        stats.cached_connects++;
+        stats.cached_connect_ms += total_ms;
+    }
+
+    bool fetched = false;
+    for (int i = 0; i < DISCOVERY_CACHE_ENTRIES; i++) {
+        cache_entry_t *entry = &cache.image.entries[i];
+        if ((used_entries & (1U << i)) && entry->key && !entry->valid) {
+            entry->valid = true;
+            fetched = true;
+        }
+    }
+    if (fetched) {
+        flash_save();
+    }
+}
+
+void discovery_cache_invalidate(void) {
+    drop_entries((uint8_t) ((1U << DISCOVERY_CACHE_ENTRIES) - 1));
+}
+
+void discovery_cache_get_stats(discovery_cache_stats_t *out) {
+    *out = stats;
+}
+
+void discovery_cache_print_stats(void) {
+    const discovery_cache_stats_t *s = &stats;
+
+    printf("Discovery cache: %lu hits, %lu fetches, %lu invalidated, %lu too large; "
+            "%lu connects from the cache avg %lu ms, %lu with requests avg %lu ms\n",
+            (unsigned long) s->hits, (unsigned long) s->fetches, (unsigned long) s->invalidated,
+            (unsigned long) s->too_large,
+            (unsigned long) s->cached_connects, (unsigned long) (s->cached_connects ? s->cached_connect_ms / s->cached_connects : 0),
+            (unsigned long) s->fetched_connects, (unsigned long) (s->fetched_connects ? s->fetched_connect_ms / s->fetched_connects : 0));
+}
@@ -0,0 +1,63 @@
+//
+// Copyright: Avnet 2021
+//
+// Cache of the IoTConnect discovery and sync responses.
+//
+// iotconnect_sdk_init() makes two HTTPS requests, each with its own TLS
+// handshake, before it connects to the MQTT broker: discovery, which returns
+// the agent URL, and sync, which returns the broker host, the client ID, the
+// topics and the settings of the device. Both answers rarely change, so the
+// SDK HTTPS client is wrapped (see LDFLAGS in the Makefile) and a response is
+// answered from the cache for APP_DISCOVERY_CACHE_TTL_S after it was fetched.
+//
+// A fetched response is only kept once the connection made with it succeeded,
+// and the responses used for a connection that failed are dropped, so that
+// the next attempt asks the cloud again. With APP_DISCOVERY_CACHE_FLASH the
+// cache is also written to the end of the work flash (after the telemetry
+// store) and survives a reset. Without a work flash it is kept in RAM only,
+// since the other flash blocks hold the application.
+//
+// Every connection is timed by phase (discovery, sync and the broker
+// connection), with the totals of the connections made with and without the
+// cache.
+//
+
+#ifndef DISCOVERY_CACHE_H_
+#define DISCOVERY_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* Discovery and sync */
+#define DISCOVERY_CACHE_ENTRIES     (2)
+/* Largest response that is cached */
+#define DISCOVERY_CACHE_BODY_SIZE   (1536)
+
+typedef struct {
+    uint32_t hits;
+    uint32_t fetches;
+    uint32_t too_large;         // responses that did not fit into an entry
+    uint32_t invalidated;       // cached responses dropped after a failed connection
+    uint32_t cached_connects;   // successful connections without any HTTPS request
+    uint32_t cached_connect_ms;
+    uint32_t fetched_connects;  // successful connections with at least one HTTPS request
+    uint32_t fetched_connect_ms;
+} discovery_cache_stats_t;
+
+/* Loads the cache from flash with APP_DISCOVERY_CACHE_FLASH. Call once the time is known. */
+void discovery_cache_init(void);
+
+/* Called around iotconnect_sdk_init() */
+void discovery_cache_connect_begin(void);
+void discovery_cache_connect_end(bool connected);
+
+/* Drops all cached responses */
+void discovery_cache_invalidate(void);
+
+void discovery_cache_get_stats(discovery_cache_stats_t *stats);
+
+void discovery_cache_print_stats(void);
+
+#endif // DISCOVERY_CACHE_H_
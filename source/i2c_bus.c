@@ -0,0 +1,298 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "runtime_stats.h"
+#include "ram_map.h"
+#include "i2c_bus.h"
+
+// A task using the wrapped blocking calls
+typedef struct {
+    TaskHandle_t task;          // NULL while the slot is unused
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buffer;
+    uint8_t held[I2C_BUS_HELD_WRITE_SIZE]; // register address written without a stop condition
+    uint16_t held_size;
+    uint16_t held_address;
+} client_t;
+
+static cyhal_i2c_t *bus;
+static TaskHandle_t manager_task;
+RAM_MAP_TASK_MEMORY(manager_task_memory, I2C_BUS_TASK_STACK_SIZE);
+static QueueHandle_t queue;
+static StaticQueue_t queue_buffer;
+static uint8_t queue_storage[I2C_BUS_QUEUE_LENGTH * sizeof(i2c_bus_transaction_t *)];
+
+static client_t clients[I2C_BUS_MAX_CLIENTS];
+
+// state of the transfer on the bus, shared with the bus interrupt
+static volatile bool transfer_reads;
+static volatile bool transfer_failed;
+
+static i2c_bus_stats_t stats;
+static TickType_t started_at;
+
+cy_rslt_t __real_cyhal_i2c_master_write(cyhal_i2c_t *obj, uint16_t dev_addr, const uint8_t *data, uint16_t size,
+        uint32_t timeout, bool send_stop);
+cy_rslt_t __real_cyhal_i2c_master_read(cyhal_i2c_t *obj, uint16_t dev_addr, uint8_t *data, uint16_t size,
+        uint32_t timeout, bool send_stop);
+
+static void bus_event(void *callback_arg, cyhal_i2c_event_t event) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    (void) callback_arg;
+    if (event & CYHAL_I2C_MASTER_ERR_EVENT) {
+        transfer_failed = true;
+    } else if (!(event & CYHAL_I2C_MASTER_RD_CMPLT_EVENT)
+            && !((event & CYHAL_I2C_MASTER_WR_CMPLT_EVENT) && !transfer_reads)) {
+        return; // the write part of a write-read
+    }
+    vTaskNotifyGiveFromISR(manager_task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static cy_rslt_t run_transfer(const i2c_bus_transaction_t *transaction) {
+    // drop the completion of a transfer that was aborted after it timed out
+    ulTaskNotifyTake(pdTRUE, 0);
+    transfer_reads = transaction->rx_size != 0;
+    transfer_failed = false;
+
+    cy_rslt_t result = cyhal_i2c_master_transfer_async(bus, transaction->address,
+            transaction->tx, transaction->tx_size, transaction->rx, transaction->rx_size);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(I2C_BUS_TRANSFER_TIMEOUT_MS))) {
+        cyhal_i2c_abort_async(bus);
+        return I2C_BUS_RSLT_ERR_TIMEOUT;
+    }
+    return transfer_failed ? I2C_BUS_RSLT_ERR_TRANSFER : CY_RSLT_SUCCESS;
+}
+
+// Called with interrupts masked. Returns NULL if all device slots are in use.
+static i2c_bus_device_stats_t *device_stats(uint16_t address) {
+    for (uint8_t i = 0; i < stats.device_count; i++) {
+        if (stats.devices[i].address == address) {
+            return &stats.devices[i];
+        }
+    }
+    if (stats.device_count == I2C_BUS_MAX_DEVICES) {
+        return NULL;
+    }
+    i2c_bus_device_stats_t *device = &stats.devices[stats.device_count++];
+    device->address = address;
+    return device;
+}
+
+static void account(const i2c_bus_transaction_t *transaction, uint32_t start, uint32_t end) {
+    uint32_t latency_us = end - transaction->queued_at;
+    uint32_t bus_us = end - start;
+
+    taskENTER_CRITICAL();
+    stats.busy_us += bus_us;
+    i2c_bus_device_stats_t *device = device_stats(transaction->address);
+    if (device) {
+        device->transactions++;
+        device->bytes += transaction->tx_size + transaction->rx_size;
+        device->latency_us += latency_us;
+        device->bus_us += bus_us;
+        if (latency_us > device->max_latency_us) {
+            device->max_latency_us = latency_us;
+        }
+        if (transaction->result != CY_RSLT_SUCCESS) {
+            device->errors++;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+static void i2c_bus_task(void *pvParameters) {
+    i2c_bus_transaction_t *transaction;
+
+    /* To avoid compiler warnings */
+    (void) pvParameters;
+
+    for (;;) {
+        if (pdTRUE != xQueueReceive(queue, &transaction, portMAX_DELAY)) {
+            continue;
+        }
+        uint32_t start = runtime_stats_counter();
+        transaction->result = run_transfer(transaction);
+        account(transaction, start, runtime_stats_counter());
+        if (transaction->callback) {
+            transaction->callback(transaction);
+        }
+    }
+}
+
+bool i2c_bus_init(cyhal_i2c_t *i2c) {
+    if (manager_task) {
+        return true;
+    }
+    bus = i2c;
+    queue = xQueueCreateStatic(I2C_BUS_QUEUE_LENGTH, sizeof(i2c_bus_transaction_t *), queue_storage, &queue_buffer);
+    cyhal_i2c_register_callback(bus, bus_event, NULL);
+    cyhal_i2c_enable_event(bus, (cyhal_i2c_event_t) (CYHAL_I2C_MASTER_WR_CMPLT_EVENT | CYHAL_I2C_MASTER_RD_CMPLT_EVENT
+            | CYHAL_I2C_MASTER_ERR_EVENT), CYHAL_ISR_PRIORITY_DEFAULT, true);
+    started_at = xTaskGetTickCount();
+    ram_map_add("I2C bus queue", sizeof(queue_storage) + sizeof(queue_buffer));
+    return ram_map_task_create(i2c_bus_task, "I2C Bus", &manager_task_memory, NULL, I2C_BUS_TASK_PRIORITY,
+            &manager_task);
+}
+
+cy_rslt_t i2c_bus_submit(i2c_bus_transaction_t *transaction) {
+    transaction->queued_at = runtime_stats_counter();
+    if (!queue || pdTRUE != xQueueSend(queue, &transaction, pdMS_TO_TICKS(I2C_BUS_TRANSFER_TIMEOUT_MS))) {
+        return I2C_BUS_RSLT_ERR_QUEUE;
+    }
+
+    uint32_t queued = (uint32_t) uxQueueMessagesWaiting(queue);
+    taskENTER_CRITICAL();
+    if (queued > stats.max_queued) {
+        stats.max_queued = queued;
+    }
+    taskEXIT_CRITICAL();
+    return CY_RSLT_SUCCESS;
+}
+
+static client_t *client_of(TaskHandle_t task) {
+    for (int i = 0; i < I2C_BUS_MAX_CLIENTS; i++) {
+        if (clients[i].task == task) {
+            return &clients[i];
+        }
+    }
+
+    // first transfer of this task
+    client_t *client = NULL;
+    taskENTER_CRITICAL();
+    for (int i = 0; i < I2C_BUS_MAX_CLIENTS && !client; i++) {
+        if (!clients[i].task) {
+            clients[i].task = task;
+            client = &clients[i];
+        }
+    }
+    taskEXIT_CRITICAL();
+    if (client) {
+        client->done = xSemaphoreCreateBinaryStatic(&client->done_buffer);
+    }
+    return client;
+}
+
+static void client_done(i2c_bus_transaction_t *transaction) {
+    xSemaphoreGive(((client_t *) transaction->context)->done);
+}
+
+static cy_rslt_t client_transfer(client_t *client, uint16_t address, const uint8_t *tx, uint16_t tx_size,
+        uint8_t *rx, uint16_t rx_size) {
+    i2c_bus_transaction_t transaction = {
+        .address = address,
+        .tx = tx,
+        .tx_size = tx_size,
+        .rx = rx,
+        .rx_size = rx_size,
+        .callback = client_done,
+        .context = client
+    };
+
+    cy_rslt_t result = i2c_bus_submit(&transaction);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    xSemaphoreTake(client->done, portMAX_DELAY);
+    return transaction.result;
+}
+
+cy_rslt_t i2c_bus_transfer(uint16_t address, const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size) {
+    client_t *client = client_of(xTaskGetCurrentTaskHandle());
+    return client ? client_transfer(client, address, tx, tx_size, rx, rx_size) : I2C_BUS_RSLT_ERR_CLIENTS;
+}
+
+// Sends a register address write that no read followed
+static cy_rslt_t flush_held(client_t *client) {
+    uint16_t size = client->held_size;
+    if (!size) {
+        return CY_RSLT_SUCCESS;
+    }
+    client->held_size = 0;
+    return client_transfer(client, client->held_address, client->held, size, NULL, 0);
+}
+
+static bool is_managed(const cyhal_i2c_t *obj) {
+    return manager_task && obj == bus && xTaskGetCurrentTaskHandle() != manager_task;
+}
+
+// Sensor driver accesses (linked with --wrap, see the Makefile)
+cy_rslt_t __wrap_cyhal_i2c_master_write(cyhal_i2c_t *obj, uint16_t dev_addr, const uint8_t *data, uint16_t size,
+        uint32_t timeout, bool send_stop) {
+    if (!is_managed(obj)) {
+        return __real_cyhal_i2c_master_write(obj, dev_addr, data, size, timeout, send_stop);
+    }
+    client_t *client = client_of(xTaskGetCurrentTaskHandle());
+    if (!client) {
+        return I2C_BUS_RSLT_ERR_CLIENTS;
+    }
+    cy_rslt_t result = flush_held(client);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    if (!send_stop && size <= I2C_BUS_HELD_WRITE_SIZE) {
+        // sent with the read that follows
+        memcpy(client->held, data, size);
+        client->held_size = size;
+        client->held_address = dev_addr;
+        return CY_RSLT_SUCCESS;
+    }
+    return client_transfer(client, dev_addr, data, size, NULL, 0);
+}
+
+cy_rslt_t __wrap_cyhal_i2c_master_read(cyhal_i2c_t *obj, uint16_t dev_addr, uint8_t *data, uint16_t size,
+        uint32_t timeout, bool send_stop) {
+    if (!is_managed(obj)) {
+        return __real_cyhal_i2c_master_read(obj, dev_addr, data, size, timeout, send_stop);
+    }
+    client_t *client = client_of(xTaskGetCurrentTaskHandle());
+    if (!client) {
+        return I2C_BUS_RSLT_ERR_CLIENTS;
+    }
+    if (client->held_size && client->held_address != dev_addr) {
+        cy_rslt_t result = flush_held(client);
+        if (result != CY_RSLT_SUCCESS) {
+            return result;
+        }
+    }
+    uint16_t tx_size = client->held_size;
+    client->held_size = 0;
+    return client_transfer(client, dev_addr, tx_size ? client->held : NULL, tx_size, data, size);
+}
+
+void i2c_bus_get_stats(i2c_bus_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+    out->elapsed_ms = (uint32_t) ((xTaskGetTickCount() - started_at) * portTICK_PERIOD_MS);
+}
+
+void i2c_bus_print_stats(void) {
+    i2c_bus_stats_t s;
+    i2c_bus_get_stats(&s);
+
+    // busy_us / (elapsed_ms * 1000) in tenths of a percent
+    uint32_t busy_permille = s.elapsed_ms ? (uint32_t) ((uint64_t) s.busy_us / s.elapsed_ms) : 0;
+    printf("I2C bus: %lu.%lu%% busy, up to %lu transactions queued\n",
+            (unsigned long) (busy_permille / 10), (unsigned long) (busy_permille % 10), (unsigned long) s.max_queued);
+    for (uint8_t i = 0; i < s.device_count; i++) {
+        const i2c_bus_device_stats_t *d = &s.devices[i];
+        uint32_t n = d->transactions ? d->transactions : 1;
+        printf("  0x%02x: %lu transactions, %lu errors, %lu bytes, latency %lu us (max %lu us), bus %lu us\n",
+                d->address, (unsigned long) d->transactions, (unsigned long) d->errors, (unsigned long) d->bytes,
+                (unsigned long) (d->latency_us / n), (unsigned long) d->max_latency_us, (unsigned long) (d->bus_us / n));
+    }
+}
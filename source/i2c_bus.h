@@ -0,0 +1,95 @@
+//
+// Copyright: Avnet 2021
+//
+// Shared I2C bus manager.
+//
+// A bus manager task owns the sensor I2C bus and runs queued transactions
+// one at a time with cyhal_i2c_master_transfer_async(). The bus interrupt
+// wakes it when a transfer completes and it then runs the transaction's
+// callback. While a transfer is on the bus, neither the manager nor the
+// client that is waiting for it uses the CPU.
+//
+// The sensor drivers call cyhal_i2c_master_write() and cyhal_i2c_master_read()
+// directly. On the managed bus these calls are wrapped at link time (see the
+// Makefile) into queued transactions. The calling task blocks until its
+// transaction completes. A register address written without a stop condition
+// is held back and sent with the read that follows, as one write-read
+// transaction with a repeated start.
+//
+
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cyhal.h"
+
+/* Above the sensor sampler, so that completed transfers are handed back right away */
+#define I2C_BUS_TASK_PRIORITY       (4)
+#define I2C_BUS_TASK_STACK_SIZE     (1024)
+
+#define I2C_BUS_QUEUE_LENGTH        (4)
+/* Tasks that use the wrapped blocking calls */
+#define I2C_BUS_MAX_CLIENTS         (4)
+/* Devices with their own statistics */
+#define I2C_BUS_MAX_DEVICES         (4)
+/* Largest register address write that is combined with the following read */
+#define I2C_BUS_HELD_WRITE_SIZE     (4)
+#define I2C_BUS_TRANSFER_TIMEOUT_MS (100)
+
+#define I2C_BUS_RSLT_MODULE         (CY_RSLT_MODULE_MIDDLEWARE_BASE + 0xA0U)
+#define I2C_BUS_RSLT_ERR_TRANSFER   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, I2C_BUS_RSLT_MODULE, 1U) // NACK or bus error
+#define I2C_BUS_RSLT_ERR_TIMEOUT    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, I2C_BUS_RSLT_MODULE, 2U)
+#define I2C_BUS_RSLT_ERR_CLIENTS    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, I2C_BUS_RSLT_MODULE, 3U) // too many tasks
+#define I2C_BUS_RSLT_ERR_QUEUE      CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, I2C_BUS_RSLT_MODULE, 4U)
+
+typedef struct i2c_bus_transaction i2c_bus_transaction_t;
+
+/* Runs in the bus manager task once the transaction completed */
+typedef void (*i2c_bus_callback_t)(i2c_bus_transaction_t *transaction);
+
+struct i2c_bus_transaction {
+    uint16_t address;
+    const uint8_t *tx;          // written first, may be NULL
+    uint16_t tx_size;
+    uint8_t *rx;                // then read after a repeated start, may be NULL
+    uint16_t rx_size;
+    i2c_bus_callback_t callback;
+    void *context;              // for the callback
+    cy_rslt_t result;           // set before the callback runs
+    uint32_t queued_at;         // set by i2c_bus_submit()
+};
+
+typedef struct {
+    uint16_t address;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t bytes;
+    uint32_t latency_us;        // total time from submission to completion
+    uint32_t max_latency_us;
+    uint32_t bus_us;            // total time on the bus
+} i2c_bus_device_stats_t;
+
+typedef struct {
+    uint32_t elapsed_ms;        // since i2c_bus_init()
+    uint32_t busy_us;           // time any transfer was on the bus
+    uint32_t max_queued;
+    uint8_t device_count;
+    i2c_bus_device_stats_t devices[I2C_BUS_MAX_DEVICES];
+} i2c_bus_stats_t;
+
+/* Starts the bus manager on the configured bus 'i2c' */
+bool i2c_bus_init(cyhal_i2c_t *i2c);
+
+/* Queues a transaction, which must stay valid until its callback ran */
+cy_rslt_t i2c_bus_submit(i2c_bus_transaction_t *transaction);
+
+/* Queues a transaction and blocks the calling task until it completed */
+cy_rslt_t i2c_bus_transfer(uint16_t address, const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size);
+
+void i2c_bus_get_stats(i2c_bus_stats_t *stats);
+
+void i2c_bus_print_stats(void);
+
+#endif // I2C_BUS_H_
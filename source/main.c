@@ -48,6 +48,11 @@
 #include "cybsp.h"
 #include "cy_retarget_io.h"
 #include "app_task.h"
+#include "boot.h"
+#include "optiga_event.h"
+#include "ram_map.h"
+#include "tls_arena.h"
+#include "trace.h"
 #include "FreeRTOS.h"
 #include "task.h"
 
@@ -59,24 +64,40 @@
 
 extern bool use_optiga_certificate(void);
 
+/* The certificate is read as DER straight into the static buffer of device_certificate.c and its PEM is
+ * written into the static buffer of app_task.c, which takes 2 KB less stack than the former copies of the
+ * DER and base64 data */
+#define OPTIGA_CLIENT_TASK_STACK_SIZE   (1024 * 12 - 512)
+#define OPTIGA_CLIENT_TASK_NAME         "Optiga Client Task"
+
+/* The task deletes itself once the certificate is read, and its stack goes back to the heap */
+RAM_MAP_HEAP_TASK_MEMORY(optiga_client_task_memory, OPTIGA_CLIENT_TASK_STACK_SIZE);
+RAM_MAP_TASK_MEMORY(app_task_memory, APP_TASK_STACK_SIZE);
+
 /******************************************************************************
  * Global Variables
  ******************************************************************************/
 /* This enables RTOS aware debugging. */
 volatile int uxTopUsedPriority;
 
-/* This is a place from which we can poll the status of operation */
+#if configUSE_TICK_HOOK
+/* Polls the OPTIGA PAL events unless the OPTIGA event task runs them (see optiga_event.h) */
 void vApplicationTickHook( void );
 
 
 void vApplicationTickHook( void )
 {
-    pal_os_event_trigger_registered_callback();
+#if !APP_OPTIGA_EVENT_TASK
+    optiga_event_tick();
+#endif
 }
+#endif
 
 void optiga_client_task(void *pvParameters)
 {
     /* Optiga initialize and read the certificate */
+    boot_phase_begin(BOOT_PHASE_OPTIGA);
+    optiga_event_init();
     pal_i2c_init(NULL);
     optiga_trust_init();
     /* Based on the certificate read from the chip, Optiga uses a hook(optiga-trust-m\release-v3.1.4\examples\mbedtls_port\)
@@ -84,20 +105,17 @@ void optiga_client_task(void *pvParameters)
     bool result = use_optiga_certificate();
     if (!result) {
     	//the called function will print the ERROR.
-    	return;
+    	boot_phase_fail(BOOT_PHASE_OPTIGA);
+    } else {
+        /* The App Task connects once the certificate is there */
+        boot_phase_end(BOOT_PHASE_OPTIGA);
     }
 
-    /* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen. */
-    printf("\x1b[2J\x1b[;H");
-    printf("===============================================================\n");
-    printf("Starting The App Task\n");
-    printf("===============================================================\n\n");
-
-    /* Create the MQTT Client task. */
-
-    xTaskCreate(app_task, "App Task", APP_TASK_STACK_SIZE, NULL, APP_TASK_PRIORITY, NULL);
-
-    while(1);
+    /* Nothing is left to do here: the OPTIGA operations of the other tasks are serialized by optiga_pool.c
+     * and completed by the PAL callbacks, which the OPTIGA event task runs (optiga_event.c), or the tick
+     * hook without APP_OPTIGA_EVENT_TASK. The idle task frees the stack and the TCB. */
+    ram_map_task_deleted(OPTIGA_CLIENT_TASK_NAME);
+    vTaskDelete(NULL);
 }
 
 
@@ -135,9 +153,27 @@ int main() {
     cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX,
     CY_RETARGET_IO_BAUDRATE);
 
+    /* mbedTLS allocates from its own arena, from the first allocation on. */
+    tls_arena_init();
+
+    /* Start the cycle counter used by the span trace. */
+    trace_init();
+
+    /* The start-up phases run in parallel and wait for each other (see boot.h). */
+    boot_init();
+
+    /* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen. */
+    printf("\x1b[2J\x1b[;H");
+    printf("===============================================================\n");
+    printf("Starting The App Task\n");
+    printf("===============================================================\n\n");
+
     /* Create an OPTIGA task to make sure everything related to
      * the OPTIGA stack will be called from the scheduler */
-    xTaskCreate(optiga_client_task, "Optiga Client Task", 1024 * 12, NULL, 2, NULL);
+    ram_map_task_create(optiga_client_task, OPTIGA_CLIENT_TASK_NAME, &optiga_client_task_memory, NULL, 2, NULL);
+
+    /* Create the MQTT Client task. It joins Wi-Fi and gets the time while the OPTIGA is initialized. */
+    ram_map_task_create(app_task, "App Task", &app_task_memory, NULL, APP_TASK_PRIORITY, NULL);
 
     /* Start the FreeRTOS scheduler. */
     vTaskStartScheduler();
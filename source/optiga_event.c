@@ -0,0 +1,142 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "optiga/pal/pal_os_event.h"
+
+#include "optiga_event.h"
+#include "ram_map.h"
+#include "runtime_stats.h"
+
+// Empty polls timed by optiga_event_init()
+#define POLL_CALIBRATION_CALLS  (10000U)
+#define US_PER_TICK             (1000U * portTICK_PERIOD_MS)
+
+static optiga_event_stats_t stats;
+static TickType_t init_tick;
+// the PAL has a single event, the one of the last registration
+static pal_os_event_t *volatile last_event;
+
+void __real_pal_os_event_register_callback_oneshot(pal_os_event_t *p_pal_os_event, register_callback callback,
+        void *callback_args, uint32_t time_us);
+
+#if APP_OPTIGA_EVENT_TASK
+static TaskHandle_t event_task;
+RAM_MAP_TASK_MEMORY(optiga_event_task_memory, OPTIGA_EVENT_TASK_STACK_SIZE);
+
+// A registration is passed as the number of ticks to wait in the task notification value,
+// and a later one replaces it, like it replaces the registered callback in the PAL.
+static void optiga_event_task(void *pvParameters) {
+    TickType_t armed_at = 0;
+    TickType_t delay = 0;
+    bool armed = false;
+    uint32_t ticks;
+
+    (void) pvParameters;
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (armed) {
+            TickType_t elapsed = xTaskGetTickCount() - armed_at;
+            wait = elapsed >= delay ? 0 : delay - elapsed;
+        }
+        if (pdTRUE == xTaskNotifyWait(0, UINT32_MAX, &ticks, wait)) {
+            armed = true;
+            armed_at = xTaskGetTickCount();
+            delay = (TickType_t) ticks;
+            continue;
+        }
+
+        armed = false;
+        stats.dispatches++;
+        pal_os_event_trigger_registered_callback();
+        pal_os_event_t *event = last_event;
+        if (event && event->callback_registered) {
+            // not run yet (the PAL keeps its own time) and not replaced, poll again on the next tick
+            armed = true;
+            armed_at = xTaskGetTickCount();
+            delay = 1;
+        }
+    }
+}
+#endif
+
+void __wrap_pal_os_event_register_callback_oneshot(pal_os_event_t *p_pal_os_event, register_callback callback,
+        void *callback_args, uint32_t time_us) {
+    __real_pal_os_event_register_callback_oneshot(p_pal_os_event, callback, callback_args, time_us);
+    last_event = p_pal_os_event;
+    stats.registrations++;
+
+#if APP_OPTIGA_EVENT_TASK
+    uint32_t ticks = (time_us + US_PER_TICK - 1) / US_PER_TICK;
+    if (!ticks) {
+        ticks = 1;
+    }
+    if (!event_task) {
+        return;
+    }
+    // the OPTIGA stack registers from the I2C interrupt too
+    if (xPortIsInsideInterrupt()) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xTaskNotifyFromISR(event_task, ticks, eSetValueWithOverwrite, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    } else {
+        xTaskNotify(event_task, ticks, eSetValueWithOverwrite);
+    }
+#endif
+}
+
+void optiga_event_init(void) {
+    // nothing is registered yet, so every call finds nothing to run
+    uint32_t start = runtime_stats_counter();
+    for (uint32_t i = 0; i < POLL_CALIBRATION_CALLS; i++) {
+        pal_os_event_trigger_registered_callback();
+    }
+    uint32_t elapsed_us = runtime_stats_counter() - start;
+    stats.poll_ns = (uint32_t) ((uint64_t) elapsed_us * (1000000000U / RUNTIME_STATS_COUNTER_HZ) / POLL_CALIBRATION_CALLS);
+    init_tick = xTaskGetTickCount();
+
+#if APP_OPTIGA_EVENT_TASK
+    ram_map_task_create(optiga_event_task, "OPTIGA Event", &optiga_event_task_memory, NULL,
+            OPTIGA_EVENT_TASK_PRIORITY, &event_task);
+#endif
+}
+
+#if !APP_OPTIGA_EVENT_TASK
+void optiga_event_tick(void) {
+    pal_os_event_t *event = last_event;
+    stats.tick_polls++;
+    if (!event || !event->callback_registered) {
+        stats.empty_polls++;
+    }
+    pal_os_event_trigger_registered_callback();
+}
+#endif
+
+void optiga_event_get_stats(optiga_event_stats_t *out) {
+    *out = stats;
+    out->ticks = xTaskGetTickCount() - init_tick;
+}
+
+void optiga_event_print_stats(void) {
+    optiga_event_stats_t s;
+    optiga_event_get_stats(&s);
+    // the tick hook polls that found nothing to run, or that were not made at all: the tick hook would have
+    // polled on every tick, and made the polls of the event task too
+    uint32_t wasted = s.empty_polls;
+    uint32_t polls = s.tick_polls + s.dispatches;
+    uint32_t avoided = s.ticks > polls ? s.ticks - polls : 0;
+
+    printf("OPTIGA events: %lu registrations, %lu dispatched by the event task; %lu ticks, %lu PAL polls from the tick hook\n",
+            (unsigned long) s.registrations, (unsigned long) s.dispatches,
+            (unsigned long) s.ticks, (unsigned long) s.tick_polls);
+    printf("OPTIGA events: %lu empty polls (%lu us of interrupt time), %lu polls avoided (%lu us saved) at %lu ns per poll\n",
+            (unsigned long) wasted, (unsigned long) ((uint64_t) wasted * s.poll_ns / 1000U),
+            (unsigned long) avoided, (unsigned long) ((uint64_t) avoided * s.poll_ns / 1000U),
+            (unsigned long) s.poll_ns);
+}
@@ -0,0 +1,58 @@
+//
+// Copyright: Avnet 2021
+//
+// OPTIGA PAL OS event dispatch.
+//
+// The OPTIGA stack runs its state machines from one-shot callbacks that it
+// registers with pal_os_event_register_callback_oneshot(), and the PAL runs
+// them when pal_os_event_trigger_registered_callback() is called. That call
+// used to be made from the tick hook on every tick, with or without an
+// OPTIGA operation in progress.
+//
+// With APP_OPTIGA_EVENT_TASK the registration is wrapped (see LDFLAGS in the
+// Makefile) and an event task waits for the time the callback asked for,
+// runs it and blocks again until the next registration. The tick hook is
+// then disabled (see configUSE_TICK_HOOK in FreeRTOSConfig.h), and with no
+// OPTIGA operation pending nothing wakes up for the OPTIGA at all, which
+// leaves the idle periods to tickless idle.
+//
+// The statistics count the ticks since optiga_event_init() and the PAL polls
+// made from the tick hook and the event task, and estimate the interrupt time
+// of the polls that found nothing to run (tick hook) or that were avoided
+// (event task) from the cost of an empty poll, measured by optiga_event_init().
+//
+
+#ifndef OPTIGA_EVENT_H_
+#define OPTIGA_EVENT_H_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/* Runs the OPTIGA callbacks ahead of the application tasks, like the tick hook did */
+#define OPTIGA_EVENT_TASK_PRIORITY      (4)
+#define OPTIGA_EVENT_TASK_STACK_SIZE    (1024)
+
+typedef struct {
+    uint32_t ticks;             // ticks since optiga_event_init(), one tick hook poll each
+    uint32_t tick_polls;        // PAL polls from the tick hook
+    uint32_t empty_polls;       // of these, with no callback registered
+    uint32_t registrations;     // one-shot callbacks registered by the OPTIGA stack
+    uint32_t dispatches;        // PAL polls from the event task
+    uint32_t poll_ns;           // cost of an empty PAL poll
+} optiga_event_stats_t;
+
+/* Measures the cost of an empty poll and starts the event task with APP_OPTIGA_EVENT_TASK.
+ * Must be called from a task, before the OPTIGA stack is initialized. */
+void optiga_event_init(void);
+
+#if !APP_OPTIGA_EVENT_TASK
+/* Called from vApplicationTickHook() */
+void optiga_event_tick(void);
+#endif
+
+void optiga_event_get_stats(optiga_event_stats_t *stats);
+
+void optiga_event_print_stats(void);
+
+#endif // OPTIGA_EVENT_H_
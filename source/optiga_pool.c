@@ -0,0 +1,236 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "optiga_lib_config_mtb.h"
+#include "optiga_pool.h"
+
+#if (OPTIGA_POOL_UTIL_INSTANCES + OPTIGA_POOL_CRYPT_INSTANCES) >= OPTIGA_CMD_MAX_REGISTRATIONS
+#error "The OPTIGA pool must leave command layer registrations to the OPTIGA mbedTLS port"
+#endif
+
+typedef struct pool_kind pool_kind_t;
+
+typedef struct {
+    void *me;   // optiga_util_t or optiga_crypt_t, NULL if it could not be created
+    pool_kind_t *pool;
+    bool in_use;
+    volatile bool in_flight;    // an operation was started and its callback has not run yet
+    volatile bool quarantined;  // released while in flight, goes back to the pool from the callback
+    volatile optiga_lib_status_t status;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buffer;
+} pool_slot_t;
+
+struct pool_kind {
+    pool_slot_t *slots;
+    uint8_t size;
+    SemaphoreHandle_t available;
+    StaticSemaphore_t available_buffer;
+};
+
+static pool_slot_t util_slots[OPTIGA_POOL_UTIL_INSTANCES];
+static pool_slot_t crypt_slots[OPTIGA_POOL_CRYPT_INSTANCES];
+static pool_kind_t util_pool = { .slots = util_slots, .size = OPTIGA_POOL_UTIL_INSTANCES };
+static pool_kind_t crypt_pool = { .slots = crypt_slots, .size = OPTIGA_POOL_CRYPT_INSTANCES };
+static optiga_pool_stats_t stats;
+
+// The PAL event that completes OPTIGA operations is run by the OPTIGA event task, or from the tick hook
+// in interrupt context without APP_OPTIGA_EVENT_TASK (see optiga_event.h).
+static void pool_callback(void *context, optiga_lib_status_t return_status) {
+    pool_slot_t *slot = (pool_slot_t *) context;
+
+    slot->status = return_status;
+    // pool_release() checks in_flight before it sets quarantined, so one of the two sees the other
+    slot->in_flight = false;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    bool release = slot->quarantined;
+    if (release) {
+        slot->quarantined = false;
+        slot->in_use = false;
+    }
+    if (xPortIsInsideInterrupt()) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xSemaphoreGiveFromISR(slot->done, &higher_priority_task_woken);
+        if (release) {
+            xSemaphoreGiveFromISR(slot->pool->available, &higher_priority_task_woken);
+        }
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    } else {
+        xSemaphoreGive(slot->done);
+        if (release) {
+            xSemaphoreGive(slot->pool->available);
+        }
+    }
+}
+
+static void pool_kind_init(pool_kind_t *pool, bool crypt) {
+    pool->available = xSemaphoreCreateCountingStatic(pool->size, 0, &pool->available_buffer);
+    for (uint8_t i = 0; i < pool->size; i++) {
+        pool_slot_t *slot = &pool->slots[i];
+        slot->pool = pool;
+        slot->done = xSemaphoreCreateBinaryStatic(&slot->done_buffer);
+        if (crypt) {
+            slot->me = optiga_crypt_create(0, pool_callback, slot);
+        } else {
+            slot->me = optiga_util_create(0, pool_callback, slot);
+        }
+        if (!slot->me) {
+            printf("OPTIGA pool: failed to create %s instance %u\n", crypt ? "crypt" : "util", i);
+            continue;
+        }
+        stats.instances++;
+        xSemaphoreGive(pool->available);
+    }
+}
+
+static void *pool_acquire(pool_kind_t *pool) {
+    void *me = NULL;
+
+    if (!pool->available) {
+        return NULL; // optiga_pool_init() was not called
+    }
+    if (pdTRUE != xSemaphoreTake(pool->available, pdMS_TO_TICKS(OPTIGA_POOL_ACQUIRE_TIMEOUT_MS))) {
+        taskENTER_CRITICAL();
+        stats.acquire_timeouts++;
+        taskEXIT_CRITICAL();
+        return NULL;
+    }
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < pool->size; i++) {
+        pool_slot_t *slot = &pool->slots[i];
+        if (slot->me && !slot->in_use) {
+            slot->in_use = true;
+            me = slot->me;
+            break;
+        }
+    }
+    stats.acquisitions++;
+    taskEXIT_CRITICAL();
+    return me;
+}
+
+static pool_slot_t *find_slot(pool_kind_t *pool, const void *me) {
+    for (uint8_t i = 0; i < pool->size; i++) {
+        if (me && pool->slots[i].me == me) {
+            return &pool->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static pool_slot_t *find_any_slot(const void *me) {
+    pool_slot_t *slot = find_slot(&util_pool, me);
+    return slot ? slot : find_slot(&crypt_pool, me);
+}
+
+static void pool_release(pool_kind_t *pool, const void *me) {
+    pool_slot_t *slot = find_slot(pool, me);
+    if (!slot || !slot->in_use) {
+        return;
+    }
+    taskENTER_CRITICAL();
+    // the OPTIGA may still complete an operation on it, which must not end the wait of the next user
+    bool in_flight = slot->in_flight;
+    if (in_flight) {
+        slot->quarantined = true;
+        stats.quarantines++;
+    } else {
+        slot->in_use = false;
+    }
+    taskEXIT_CRITICAL();
+    if (in_flight) {
+        printf("OPTIGA pool: instance released during an operation, kept until it completes\n");
+        return;
+    }
+    xSemaphoreGive(pool->available);
+}
+
+void optiga_pool_init(void) {
+    if (util_pool.available) {
+        return;
+    }
+    pool_kind_init(&util_pool, false);
+    pool_kind_init(&crypt_pool, true);
+}
+
+optiga_util_t *optiga_pool_acquire_util(void) {
+    return (optiga_util_t *) pool_acquire(&util_pool);
+}
+
+void optiga_pool_release_util(optiga_util_t *me) {
+    pool_release(&util_pool, me);
+}
+
+optiga_crypt_t *optiga_pool_acquire_crypt(void) {
+    return (optiga_crypt_t *) pool_acquire(&crypt_pool);
+}
+
+void optiga_pool_release_crypt(optiga_crypt_t *me) {
+    pool_release(&crypt_pool, me);
+}
+
+void optiga_pool_prepare(const void *me) {
+    pool_slot_t *slot = find_any_slot(me);
+    if (!slot) {
+        return;
+    }
+    // a slot only comes back to the pool once its last operation completed, so nothing is pending here
+    xSemaphoreTake(slot->done, 0);
+    slot->status = OPTIGA_LIB_BUSY;
+    slot->in_flight = true;
+}
+
+optiga_lib_status_t optiga_pool_wait(const void *me, optiga_lib_status_t start_status) {
+    pool_slot_t *slot = find_any_slot(me);
+    if (!slot) {
+        return OPTIGA_LIB_BUSY;
+    }
+    if (OPTIGA_LIB_SUCCESS != start_status) {
+        // not started, so there will be no callback
+        slot->in_flight = false;
+        return start_status;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    bool stalled = false;
+    while (pdTRUE != xSemaphoreTake(slot->done, pdMS_TO_TICKS(OPTIGA_POOL_OP_STALL_MS))) {
+        if (!stalled) {
+            printf("OPTIGA pool: operation stalled for %d ms, still waiting\n", OPTIGA_POOL_OP_STALL_MS);
+            stalled = true;
+        }
+    }
+    uint32_t blocked_ms = (uint32_t) ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS);
+
+    taskENTER_CRITICAL();
+    stats.operations++;
+    stats.blocked_ms += blocked_ms;
+    if (blocked_ms > stats.max_blocked_ms) {
+        stats.max_blocked_ms = blocked_ms;
+    }
+    if (stalled) {
+        stats.stalls++;
+    }
+    taskEXIT_CRITICAL();
+    return slot->status;
+}
+
+void optiga_pool_add_signature(uint32_t signing_ms) {
+    taskENTER_CRITICAL();
+    stats.signatures++;
+    stats.signing_ms += signing_ms;
+    taskEXIT_CRITICAL();
+}
+
+void optiga_pool_get_stats(optiga_pool_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
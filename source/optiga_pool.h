@@ -0,0 +1,77 @@
+//
+// Copyright: Avnet 2021
+//
+// Pool of long-lived OPTIGA util and crypt instances.
+//
+// Creating an instance registers it with the OPTIGA command layer and
+// allocates its context from the heap, so instead of creating and destroying
+// one around every operation, callers borrow a pooled instance:
+//
+//   optiga_util_t *me = optiga_pool_acquire_util();
+//   optiga_pool_prepare(me);
+//   status = optiga_pool_wait(me, optiga_util_read_data(me, ...));
+//   optiga_pool_release_util(me);
+//
+// An instance released while an operation on it is still in flight is
+// quarantined: it only goes back to the pool once the operation completed,
+// so that a late completion cannot end the wait of the next user.
+//
+// The pool only takes part of the OPTIGA_CMD_MAX_REGISTRATIONS command layer
+// registrations. The others stay available to the OPTIGA mbedTLS port, which
+// creates its own instances for ECDH and signature verification.
+//
+
+#ifndef OPTIGA_POOL_H_
+#define OPTIGA_POOL_H_
+
+#include <stdint.h>
+
+#include "optiga/optiga_util.h"
+#include "optiga/optiga_crypt.h"
+
+/* Pooled instances of each kind */
+#define OPTIGA_POOL_UTIL_INSTANCES      (1)
+#define OPTIGA_POOL_CRYPT_INSTANCES     (1)
+
+/* Upper limit for getting a pooled instance */
+#define OPTIGA_POOL_ACQUIRE_TIMEOUT_MS  (5000)
+/* An operation that takes longer than this is reported as stalled, but still waited for */
+#define OPTIGA_POOL_OP_STALL_MS         (5000)
+
+typedef struct {
+    uint32_t instances;         // instances created, stays at the pool size once warmed up
+    uint32_t acquisitions;
+    uint32_t acquire_timeouts;
+    uint32_t quarantines;       // instances released with an operation in flight
+    uint32_t operations;        // operations waited for
+    uint32_t stalls;            // operations that took longer than OPTIGA_POOL_OP_STALL_MS
+    uint32_t blocked_ms;        // time callers were blocked and the CPU was available to other tasks
+    uint32_t max_blocked_ms;
+    uint32_t signatures;        // TLS ECDSA signatures (see optiga_trust_helpers.c)
+    uint32_t signing_ms;        // time spent in them
+} optiga_pool_stats_t;
+
+/* Creates the pooled instances. Must be called after pal_init(). */
+void optiga_pool_init(void);
+
+/* Returns a pooled instance or NULL if none became available within OPTIGA_POOL_ACQUIRE_TIMEOUT_MS */
+optiga_util_t *optiga_pool_acquire_util(void);
+void optiga_pool_release_util(optiga_util_t *me);
+
+optiga_crypt_t *optiga_pool_acquire_crypt(void);
+void optiga_pool_release_crypt(optiga_crypt_t *me);
+
+/* Must be called before an operation is started on the pooled instance 'me', and be followed by optiga_pool_wait() */
+void optiga_pool_prepare(const void *me);
+
+/* 'start_status' is what the call that started the operation returned. If that failed it is returned right away,
+ * otherwise this blocks until the operation started on 'me' completes and returns its status. It does not give up: the OPTIGA
+ * writes the result into the caller's buffers, which must stay valid until then, and the command layer completes
+ * an operation with an error status when the chip does not respond. */
+optiga_lib_status_t optiga_pool_wait(const void *me, optiga_lib_status_t start_status);
+
+void optiga_pool_add_signature(uint32_t signing_ms);
+
+void optiga_pool_get_stats(optiga_pool_stats_t *stats);
+
+#endif // OPTIGA_POOL_H_
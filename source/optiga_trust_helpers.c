@@ -37,185 +37,183 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "optiga/optiga_util.h"
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/pal/pal_os_event.h"
 #include "optiga/pal/pal_gpio.h"
 #include "optiga/ifx_i2c/ifx_i2c_config.h"
 #include "optiga/pal/pal_ifx_i2c_config.h"
-#include "mbedtls/base64.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/asn1.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "optiga_pool.h"
 #include "optiga_trust_helpers.h"
 
+/* Bytes read first from a certificate data object, enough for the TLS identity header and the DER length */
+#define OPTIGA_CERT_HEADER_READ_LEN     (16)
+/* Header of the TLS identity format of the factory provisioned device certificate */
+#define OPTIGA_TLS_IDENTITY_TAG         (0xC0)
+#define OPTIGA_TLS_IDENTITY_HEADER_LEN  (9)
+
+#if defined(MBEDTLS_ECDSA_SIGN_ALT)
+/* Large enough for the r and s DER INTEGERs of a NIST P-521 signature */
+#define OPTIGA_ECDSA_SIGNATURE_MAX_LEN  (2 * (3 + 66))
+#endif
+
 /**
- * Callback when optiga_util_xxxx operation is completed asynchronously
+ * TLS client authentication signs with the OPTIGA (MBEDTLS_ECDSA_SIGN_ALT). The sign function of the
+ * OPTIGA mbedTLS port creates and destroys an optiga_crypt instance for every signature and busy waits
+ * for it. Linked with --wrap=mbedtls_ecdsa_sign, signatures are made with a pooled instance instead
+ * and the calling task blocks until the OPTIGA is done.
  */
-static volatile optiga_lib_status_t optiga_lib_status;
-static void optiga_util_callback(void * context, optiga_lib_status_t return_status)
-{
-    optiga_lib_status = return_status;
-}
+int __real_mbedtls_ecdsa_sign(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                              const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
+                              int (*f_rng)(void *, unsigned char *, size_t), void *p_rng);
 
-void read_certificate_from_optiga(uint16_t optiga_oid, char * cert_pem, uint16_t * cert_pem_length)
+int __wrap_mbedtls_ecdsa_sign(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                              const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
+                              int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1200];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
-    optiga_lib_status_t return_status;
-
-    optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1024];
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
-    
-    do
+    TickType_t start = xTaskGetTickCount();
+    int ret;
+#if defined(MBEDTLS_ECDSA_SIGN_ALT)
+    uint8_t der_signature[OPTIGA_ECDSA_SIGNATURE_MAX_LEN];
+    uint16_t der_signature_length = sizeof(der_signature);
+    unsigned char * p = der_signature;
+    optiga_crypt_t * me_crypt = optiga_pool_acquire_crypt();
+
+    if (!me_crypt)
     {
-        //Create an instance of optiga_util to read the certificate from OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
-        if(!me_util)
-        {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
-        }
-        optiga_lib_status = OPTIGA_LIB_BUSY;
-        return_status = optiga_util_read_data(me_util, optiga_oid, 0, ifx_cert_hex, &ifx_cert_hex_len);
-        if (OPTIGA_LIB_SUCCESS != return_status)
-        {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
-        }
-            
-        while (optiga_lib_status == OPTIGA_LIB_BUSY);
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
-        {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
-        }
-        
-        //convert to PEM format
-        // If the first byte is TLS Identity Tag, than we need to skip 9 first bytes
-        offset_to_read = ifx_cert_hex[0] == 0xc0? 9: 0;
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-                              ifx_cert_hex + offset_to_read, ifx_cert_hex_len - offset_to_read);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-       
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
+        //Pool exhausted, let the port use an instance of its own
+        ret = __real_mbedtls_ecdsa_sign(grp, r, s, d, buf, blen, f_rng, p_rng);
+    }
+    else
+    {
+        ret = MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+        do
         {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
-        }
-
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
+            optiga_pool_prepare(me_crypt);
+            //The digest is truncated to the curve size by the caller, like for the port.
+            //der_signature belongs to the OPTIGA until the wait returns.
+            if (OPTIGA_LIB_SUCCESS != optiga_pool_wait(me_crypt,
+                    optiga_crypt_ecdsa_sign(me_crypt, buf, (uint8_t)blen, OPTIGA_KEY_ID_E0F0,
+                                            der_signature, &der_signature_length)))
+            {
+                break;
+            }
+            //The OPTIGA returns r and s as two DER INTEGERs without the SEQUENCE
+            if (0 != mbedtls_asn1_get_mpi(&p, der_signature + der_signature_length, r) ||
+                0 != mbedtls_asn1_get_mpi(&p, der_signature + der_signature_length, s))
+            {
+                break;
+            }
+            ret = 0;
+        } while (0);
+        optiga_pool_release_crypt(me_crypt);
+    }
+#else
+    ret = __real_mbedtls_ecdsa_sign(grp, r, s, d, buf, blen, f_rng, p_rng);
+#endif
+    optiga_pool_add_signature((uint32_t)((xTaskGetTickCount() - start) * portTICK_PERIOD_MS));
+    return ret;
+}
 
-        *cert_pem_length = offset_to_write + 27;
-   
-    } while(0);
+/**
+ * Reads 'length' bytes at 'offset' of data object 'oid'. 'length' is updated with the bytes read.
+ */
+static optiga_lib_status_t read_data_chunk(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                           uint8_t * buffer, uint16_t * length)
+{
+    optiga_pool_prepare(me_util);
+    //Returns only once the OPTIGA is done with 'buffer'
+    return optiga_pool_wait(me_util, optiga_util_read_data(me_util, oid, offset, buffer, length));
+}
 
-    //me_util instance to be destroyed 
-    if (me_util)
+/**
+ * Returns the length of the DER SEQUENCE at 'data', including its tag and length, or 0 if there is none.
+ */
+static uint16_t der_sequence_length(const uint8_t * data, uint16_t length)
+{
+    if (length < 4 || data[0] != 0x30)
+    {
+        return 0;
+    }
+    if (data[1] < 0x80)
+    {
+        return 2 + data[1];
+    }
+    if (data[1] == 0x81)
     {
-        optiga_util_destroy(me_util);
+        return 3 + data[2];
     }
+    if (data[1] == 0x82)
+    {
+        return 4 + ((data[2] << 8) | data[3]);
+    }
+    return 0;
 }
 
-void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+void read_certificate_der_from_optiga(uint16_t optiga_oid, uint8_t * cert_der, uint16_t cert_der_size, uint16_t * cert_der_length)
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1200];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
-    optiga_lib_status_t return_status;
-
+    uint8_t header[OPTIGA_CERT_HEADER_READ_LEN];
+    uint16_t header_length = sizeof(header);
+    uint16_t der_offset = 0, der_length = 0, head_length, rest_length;
     optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1300];
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
 
+    *cert_der_length = 0;
     do
     {
-        //Create an instance of optiga_util to read the certificate from OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
+        //Borrow a pooled optiga_util instance to read the certificate from OPTIGA.
+        me_util = optiga_pool_acquire_util();
         if(!me_util)
         {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("no optiga_util instance available !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
-        optiga_lib_status = OPTIGA_LIB_BUSY;   
-        return_status = optiga_util_read_data(me_util, oid, 0, ifx_cert_hex, &ifx_cert_hex_len);
-        if (OPTIGA_LIB_SUCCESS != return_status)
+
+        //The first bytes tell where the DER starts and how long it is
+        if (OPTIGA_LIB_SUCCESS != read_data_chunk(me_util, optiga_oid, 0, header, &header_length))
         {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api for trust anchor returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
-            
-        while (optiga_lib_status == OPTIGA_LIB_BUSY)
+
+        // If the first byte is TLS Identity Tag, than we need to skip the header
+        if (header_length && header[0] == OPTIGA_TLS_IDENTITY_TAG)
         {
-            pal_os_timer_delay_in_milliseconds(30);
+            der_offset = OPTIGA_TLS_IDENTITY_HEADER_LEN;
         }
-        
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+        if (header_length > der_offset)
         {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed for reading trust anchor",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            der_length = der_sequence_length(header + der_offset, header_length - der_offset);
         }
-
-        //ESP_LOG_BUFFER_HEX("OPTIGA Certificate", ifx_cert_hex, ifx_cert_hex_len);
-        
-        //convert to PEM format
-       // printf("read ifx cer\r\n");
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-        //in case of TLS chain format of ceritificate
-        //                    ifx_cert_hex + 9, ifx_cert_hex_len - 9);
-                              ifx_cert_hex, ifx_cert_hex_len);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-        
-        //TBD: Verify the given cert_pem length against the ifx_cert_b64_len after conversion
-        
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
+        if (!der_length || der_length > cert_der_size)
         {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
+            optiga_lib_print_message("data object does not hold a DER certificate that fits",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
         }
 
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
-
-        *cert_pem_length = offset_to_write + 27;
-       /* for(int i=0; i<1200; i++)
+        //The start of the DER came with the header, the rest is read straight into the destination
+        head_length = header_length - der_offset < der_length ? header_length - der_offset : der_length;
+        memcpy(cert_der, header + der_offset, head_length);
+        rest_length = der_length - head_length;
+        if (rest_length &&
+            (OPTIGA_LIB_SUCCESS != read_data_chunk(me_util, optiga_oid, der_offset + head_length,
+                                                   cert_der + head_length, &rest_length) ||
+             rest_length != der_length - head_length))
         {
-            printf("%c", cert_pem[i]);
-        }*/       
+            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+        *cert_der_length = der_length;
     } while(0);
 
-    //me_util instance to be destroyed 
+    //me_util instance goes back to the pool
     if (me_util)
     {
-        optiga_util_destroy(me_util);
+        optiga_pool_release_util(me_util);
     }
 }
 
@@ -226,15 +224,15 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
     
     do
     {
-        //Create an instance of optiga_util to open the application on OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
+        //Borrow a pooled optiga_util instance.
+        me_util = optiga_pool_acquire_util();
         if(!me_util)
         {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("no optiga_util instance available !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
 
-        optiga_lib_status = OPTIGA_LIB_BUSY;
+        optiga_pool_prepare(me_util);
         return_status = optiga_util_write_data(me_util,
                                                oid,
                                                OPTIGA_UTIL_ERASE_AND_WRITE,
@@ -245,18 +243,14 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
             if (OPTIGA_LIB_SUCCESS != return_status)
             {
                 optiga_lib_print_message("optiga_util_wirte_data api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                break;
             }
 
-            while (OPTIGA_LIB_BUSY == optiga_lib_status)
-            {
-                //Wait until the optiga_util_write_data operation is completed
-            }
+            //Wait until the optiga_util_write_data operation is completed
+            return_status = optiga_pool_wait(me_util, return_status);
 
-            if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+            if (OPTIGA_LIB_SUCCESS != return_status)
             {
                 optiga_lib_print_message("optiga_util_write_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                return_status = optiga_lib_status;
                 break;
             }
             else
@@ -266,11 +260,10 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
         }
     } while (0);
 
-    //me_util instance can be destroyed 
-    //if no close_application w.r.t hibernate is required to be performed
+    //me_util instance goes back to the pool
     if (me_util)
     {
-        optiga_util_destroy(me_util);
+        optiga_pool_release_util(me_util);
     }
 }
 
@@ -572,31 +565,31 @@ void optiga_trust_init(void)
     optiga_util_t * me_util = NULL;
 
     pal_init();
+    optiga_pool_init();
 
     optiga_lib_print_message("OPTIGA Trust initialization",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
     
     do
     {
-        //Create an instance of optiga_util to open the application on OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
+        //Borrow a pooled optiga_util instance.
+        me_util = optiga_pool_acquire_util();
         if(!me_util)
         {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("no optiga_util instance available !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
 
-        optiga_lib_status = OPTIGA_LIB_BUSY;
+        optiga_pool_prepare(me_util);
         return_status = optiga_util_open_application(me_util, 0);
         {
             if (OPTIGA_LIB_SUCCESS != return_status)
             {
                 //optiga_util_open_application api returns error !!!
                 optiga_lib_print_message("optiga_util_open_application api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                break;
             }
             
-            while (optiga_lib_status == OPTIGA_LIB_BUSY);
-            if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+            return_status = optiga_pool_wait(me_util, return_status);
+            if (OPTIGA_LIB_SUCCESS != return_status)
             {
                 //optiga_util_open_application failed
                 optiga_lib_print_message("optiga_util_open_application failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
@@ -604,6 +597,10 @@ void optiga_trust_init(void)
             }
         }
 
+        //The helpers below borrow the instance themselves
+        optiga_pool_release_util(me_util);
+        me_util = NULL;
+
         //The below specified functions can be used to personalize OPTIGA w.r.t
         //certificates, Trust Anchors, etc.
         
@@ -615,11 +612,10 @@ void optiga_trust_init(void)
         optiga_lib_print_message("OPTIGA Trust initialization is successful",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
     }while(0);
 
-    //me_util instance can be destroyed 
-    //if no close_application w.r.t hibernate is required to be performed
+    //me_util instance goes back to the pool
     if (me_util)
     {
-        optiga_util_destroy(me_util);
+        optiga_pool_release_util(me_util);
     }
 }
 
@@ -35,10 +35,13 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
-void read_certificate_from_optiga(uint16_t optiga_oid, char * cert_pem, uint16_t * cert_pem_length);
-
-void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length);
+/**
+ * Read the DER certificate in data object 'optiga_oid', without a TLS identity header, into 'cert_der'.
+ * 'cert_der_length' is set to 0 if the read failed or the certificate did not fit.
+ */
+void read_certificate_der_from_optiga(uint16_t optiga_oid, uint8_t * cert_der, uint16_t cert_der_size, uint16_t * cert_der_length);
 
 void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length);
 
@@ -0,0 +1,106 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <string.h>
+
+#include "pem_writer.h"
+
+static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void put_raw(pem_writer_t *w, const char *data, size_t len) {
+    if (w->overflow) {
+        return;
+    }
+    // always keep room for the NUL terminator
+    if (len >= w->size - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->len], data, len);
+    w->len += len;
+}
+
+static void put_str(pem_writer_t *w, const char *str) {
+    put_raw(w, str, strlen(str));
+}
+
+static void put_boundary(pem_writer_t *w, const char *what, const char *label) {
+    put_str(w, "-----");
+    put_str(w, what);
+    put_str(w, " ");
+    put_str(w, label);
+    put_str(w, "-----\n");
+}
+
+// Writes one base64 quantum. 'len' input bytes (1 to 3) are padded with '='.
+static void put_quantum(pem_writer_t *w, const uint8_t *in, uint8_t len) {
+    char out[5];
+    uint32_t bits = ((uint32_t) in[0] << 16)
+            | (len > 1 ? (uint32_t) in[1] << 8 : 0)
+            | (len > 2 ? (uint32_t) in[2] : 0);
+
+    out[0] = base64[(bits >> 18) & 0x3F];
+    out[1] = base64[(bits >> 12) & 0x3F];
+    out[2] = len > 1 ? base64[(bits >> 6) & 0x3F] : '=';
+    out[3] = len > 2 ? base64[bits & 0x3F] : '=';
+    // PEM_WRITER_LINE_LEN is a multiple of 4, so lines only break between quanta
+    w->column = (uint8_t) (w->column + 4);
+    if (w->column == PEM_WRITER_LINE_LEN) {
+        out[4] = '\n';
+        w->column = 0;
+        put_raw(w, out, 5);
+    } else {
+        put_raw(w, out, 4);
+    }
+}
+
+void pem_writer_begin(pem_writer_t *w, char *buf, size_t size, const char *label) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = (size == 0);
+    w->pending_len = 0;
+    w->column = 0;
+    put_boundary(w, "BEGIN", label);
+}
+
+bool pem_writer_update(pem_writer_t *w, const uint8_t *data, size_t len) {
+    // complete a quantum started by the previous call
+    while (w->pending_len && len) {
+        w->pending[w->pending_len++] = *data++;
+        len--;
+        if (w->pending_len == 3) {
+            put_quantum(w, w->pending, 3);
+            w->pending_len = 0;
+        }
+    }
+    for (; len >= 3 && !w->overflow; data += 3, len -= 3) {
+        put_quantum(w, data, 3);
+    }
+    // the rest of the input is dropped, it could not be written anyway
+    if (w->overflow) {
+        return false;
+    }
+    // fewer than 3 bytes are left, and nothing is pending if any are
+    memcpy(w->pending + w->pending_len, data, len);
+    w->pending_len = (uint8_t) (w->pending_len + len);
+    return !w->overflow;
+}
+
+const char *pem_writer_finish(pem_writer_t *w, const char *label) {
+    if (w->pending_len) {
+        put_quantum(w, w->pending, w->pending_len);
+        w->pending_len = 0;
+    }
+    if (w->column) {
+        put_raw(w, "\n", 1);
+        w->column = 0;
+    }
+    put_boundary(w, "END", label);
+    if (w->overflow) {
+        return NULL;
+    }
+    w->buf[w->len] = '\0';
+    return w->buf;
+}
@@ -0,0 +1,47 @@
+//
+// Copyright: Avnet 2021
+//
+// Streaming DER to PEM encoder.
+//
+// Base64 encodes the data passed to pem_writer_update() straight into the
+// destination buffer, in 64 column lines between the BEGIN and END lines of
+// 'label', so DER objects can be converted while they are read in chunks,
+// without a copy of the DER or of the base64 text.
+// Once the buffer is exhausted every further call is ignored and
+// pem_writer_finish() returns NULL.
+//
+
+#ifndef PEM_WRITER_H_
+#define PEM_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Base64 characters per PEM line */
+#define PEM_WRITER_LINE_LEN (64U)
+
+/* Buffer size for the PEM of a 'der_len' byte object with a 'label_len' character label, with the NUL terminator */
+#define PEM_WRITER_SIZE(der_len, label_len) \
+    (4U * (((der_len) + 2U) / 3U) + ((der_len) + 47U) / 48U + 2U * (label_len) + 33U)
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+    uint8_t pending[3];     // input bytes that do not make up a base64 quantum yet
+    uint8_t pending_len;
+    uint8_t column;         // characters in the current line
+} pem_writer_t;
+
+/* Starts a PEM block with the given label, like "CERTIFICATE" */
+void pem_writer_begin(pem_writer_t *w, char *buf, size_t size, const char *label);
+
+/* Encodes the next 'len' bytes of the DER object */
+bool pem_writer_update(pem_writer_t *w, const uint8_t *data, size_t len);
+
+/* Terminates the block. Returns the NUL terminated PEM (w->len long) or NULL if it did not fit. */
+const char *pem_writer_finish(pem_writer_t *w, const char *label);
+
+#endif // PEM_WRITER_H_
@@ -0,0 +1,146 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "periodic.h"
+
+static const char *const bucket_names[PERIODIC_HISTOGRAM_BUCKETS] = {
+    "0", "1", "2", "4", "8", "16", "32", "64", "128", "256+"
+};
+
+static TickType_t ms_to_ticks(uint32_t ms) {
+    // pdMS_TO_TICKS() overflows for periods of hours
+    return (TickType_t) ((uint64_t) ms * configTICK_RATE_HZ / 1000U);
+}
+
+static uint32_t ticks_to_ms(TickType_t ticks) {
+    return (uint32_t) ((uint64_t) ticks * 1000U / configTICK_RATE_HZ);
+}
+
+// true once 'now' is at or past 'tick', across the wrap of the tick count
+static bool reached(TickType_t now, TickType_t tick) {
+    return (TickType_t) (now - tick) < portMAX_DELAY / 2;
+}
+
+static void record(uint32_t *histogram, uint32_t *max, uint32_t ms) {
+    uint8_t bucket = 0;
+
+    for (uint32_t v = ms; v && bucket < PERIODIC_HISTOGRAM_BUCKETS - 1; v >>= 1) {
+        bucket++;
+    }
+    histogram[bucket]++;
+    if (ms > *max) {
+        *max = ms;
+    }
+}
+
+void periodic_job_init(periodic_job_t *job, const char *name, uint32_t period_ms, uint32_t phase_ms) {
+    memset(job, 0, sizeof(*job));
+    job->name = name;
+    job->period = ms_to_ticks(period_ms);
+    if (!job->period) {
+        job->period = 1;
+    }
+    job->phase = ms_to_ticks(phase_ms) % job->period;
+    periodic_job_start(job);
+}
+
+void periodic_job_start(periodic_job_t *job) {
+    TickType_t now = xTaskGetTickCount();
+
+    job->release = now - now % job->period + job->phase;
+    if (!reached(job->release, now)) {
+        job->release += job->period;
+    }
+}
+
+TickType_t periodic_ticks_until(const periodic_job_t *jobs, size_t count) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+
+    for (size_t i = 0; i < count; i++) {
+        if (reached(now, jobs[i].release)) {
+            return 0;
+        }
+        if (jobs[i].release - now < wait) {
+            wait = jobs[i].release - now;
+        }
+    }
+    return wait;
+}
+
+void periodic_wait(periodic_job_t *job) {
+    // vTaskDelayUntil() wakes at the previous release plus the period, and returns at once if that has passed
+    TickType_t previous = job->release - job->period;
+    vTaskDelayUntil(&previous, job->period);
+}
+
+bool periodic_begin(periodic_job_t *job) {
+    TickType_t now = xTaskGetTickCount();
+
+    if (!reached(now, job->release)) {
+        return false;
+    }
+    job->runs++;
+    record(job->jitter, &job->max_jitter_ms, ticks_to_ms(now - job->release));
+    return true;
+}
+
+void periodic_begin_paced(periodic_job_t *job) {
+    TickType_t now = xTaskGetTickCount();
+
+    // the first run sets the pace
+    if (job->runs) {
+        TickType_t off = reached(now, job->release) ? now - job->release : job->release - now;
+        record(job->jitter, &job->max_jitter_ms, ticks_to_ms(off));
+    }
+    job->runs++;
+    job->release = now;
+}
+
+void periodic_end(periodic_job_t *job) {
+    TickType_t now = xTaskGetTickCount();
+
+    job->release += job->period;
+    if (reached(now, job->release) && now != job->release) {
+        job->overruns++;
+        record(job->overrun, &job->max_overrun_ms, ticks_to_ms(now - job->release));
+        // runs once more, late, but does not catch up on releases that are a period or more behind
+        while (now - job->release >= job->period) {
+            job->release += job->period;
+            job->skipped++;
+        }
+    }
+}
+
+// " <bucket>:<count>" of the non-empty buckets
+static void format_histogram(char *out, size_t size, const uint32_t *histogram) {
+    size_t len = 0;
+
+    out[0] = 0;
+    for (uint8_t i = 0; i < PERIODIC_HISTOGRAM_BUCKETS && len < size; i++) {
+        if (histogram[i]) {
+            len += (size_t) snprintf(&out[len], size - len, " %s:%lu", bucket_names[i], (unsigned long) histogram[i]);
+        }
+    }
+}
+
+void periodic_print_stats(const periodic_job_t *job) {
+    char histogram[PERIODIC_HISTOGRAM_BUCKETS * sizeof(" 256+:4294967295")];
+
+    format_histogram(histogram, sizeof(histogram), job->jitter);
+    printf("Job %s every %lu ms: %lu runs, jitter max %lu ms [ms:runs%s], %lu overruns (max %lu ms), %lu skipped\n",
+            job->name, (unsigned long) ticks_to_ms(job->period), (unsigned long) job->runs,
+            (unsigned long) job->max_jitter_ms, histogram, (unsigned long) job->overruns,
+            (unsigned long) job->max_overrun_ms, (unsigned long) job->skipped);
+    if (job->overruns) {
+        format_histogram(histogram, sizeof(histogram), job->overrun);
+        printf("Job %s overruns [ms:runs%s]\n", job->name, histogram);
+    }
+}
@@ -0,0 +1,76 @@
+//
+// Copyright: Avnet 2021
+//
+// Drift-free periodic jobs.
+//
+// A job is released on a fixed grid of the tick count: at 'phase' into every
+// 'period', counted from tick 0, so that jobs of different tasks keep their
+// phases to each other. The next release is the previous one plus the
+// period, not the end of the run plus the period, so the time a run takes
+// does not move the ones after it.
+//
+// A task runs its jobs with periodic_begin() and periodic_end() around the
+// work. One job per task can wait with periodic_wait() (vTaskDelayUntil()),
+// a task with several jobs or other events to wait for blocks for
+// periodic_ticks_until() instead. A job paced by something else, like a
+// sensor interrupt, starts with periodic_begin_paced() and is measured
+// against the period since its previous start.
+//
+// For each job the start is compared to its release (jitter), and a run that
+// ends after the next release is an overrun. An overrun job runs late once
+// more, releases that it missed by a full period or more are skipped. Jitter
+// and overruns are counted in histograms of power of two milliseconds, from
+// which the sampling and publishing times can be given as percentiles.
+//
+
+#ifndef PERIODIC_H_
+#define PERIODIC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/* Buckets of 0, 1, 2-3, 4-7, ... 128-255 and 256 ms or more */
+#define PERIODIC_HISTOGRAM_BUCKETS  (10)
+
+typedef struct {
+    const char *name;
+    TickType_t period;
+    TickType_t phase;
+    TickType_t release;         // of the next run
+    uint32_t runs;
+    uint32_t overruns;          // runs that ended after the next release
+    uint32_t skipped;           // releases missed by a full period
+    uint32_t max_jitter_ms;
+    uint32_t max_overrun_ms;
+    uint32_t jitter[PERIODIC_HISTOGRAM_BUCKETS];
+    uint32_t overrun[PERIODIC_HISTOGRAM_BUCKETS];
+} periodic_job_t;
+
+/* Periods of more than 49 days are not supported */
+void periodic_job_init(periodic_job_t *job, const char *name, uint32_t period_ms, uint32_t phase_ms);
+
+/* Releases the job at the next point of its grid. Also to be called when a job was not run for a while,
+ * like the jobs of a connection after a reconnect, which does not count the releases in between as skipped. */
+void periodic_job_start(periodic_job_t *job);
+
+/* Ticks until the earliest release of 'count' jobs, 0 if one of them is due */
+TickType_t periodic_ticks_until(const periodic_job_t *jobs, size_t count);
+
+/* Blocks until the job is released */
+void periodic_wait(periodic_job_t *job);
+
+/* False if the job is not due yet. Otherwise records its jitter, and the run must end with periodic_end(). */
+bool periodic_begin(periodic_job_t *job);
+
+/* Starts a run of a job that something else released, now. Its jitter is how far the time since the previous
+ * start is off the period. */
+void periodic_begin_paced(periodic_job_t *job);
+
+void periodic_end(periodic_job_t *job);
+
+void periodic_print_stats(const periodic_job_t *job);
+
+#endif // PERIODIC_H_
@@ -0,0 +1,118 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ram_map.h"
+
+// RAM regions of the GCC linker scripts of the PSoC 6 BSPs
+#if !defined(APP_HOST_BUILD) && defined(__GNUC__) && !defined(__ARMCC_VERSION)
+#define RAM_MAP_LINKER_REGIONS
+extern char __data_start__[], __data_end__[];
+extern char __bss_start__[], __bss_end__[];
+extern char __HeapBase[], __HeapLimit[];
+extern char __StackLimit[], __StackTop[];
+#endif
+
+typedef struct {
+    const char *name;
+    uint32_t size;
+    uint32_t stack;             // bytes of stack for a task, 0 for a buffer
+    bool on_heap;
+    bool freed;                 // a task that was deleted, its memory went back to the heap
+} ram_map_entry_t;
+
+static ram_map_entry_t entries[RAM_MAP_MAX_ENTRIES];
+static uint8_t entry_count;
+static uint8_t entries_left_out;
+
+static void record(const char *name, uint32_t size, uint32_t stack, bool on_heap) {
+    taskENTER_CRITICAL();
+    if (entry_count < RAM_MAP_MAX_ENTRIES) {
+        entries[entry_count++] = (ram_map_entry_t) { name, size, stack, on_heap, false };
+    } else {
+        entries_left_out++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool ram_map_task_create(TaskFunction_t function, const char *name, const ram_map_task_memory_t *memory,
+        void *parameter, UBaseType_t priority, TaskHandle_t *handle) {
+    TaskHandle_t task;
+    uint32_t stack = memory->stack_words * sizeof(StackType_t);
+
+    if (memory->stack) {
+        task = xTaskCreateStatic(function, name, memory->stack_words, parameter, priority, memory->stack, memory->tcb);
+    } else if (pdPASS != xTaskCreate(function, name, memory->stack_words, parameter, priority, &task)) {
+        task = NULL;
+    }
+    if (!task) {
+        printf("Error: Failed to create the %s task\n", name);
+        return false;
+    }
+    if (handle) {
+        *handle = task;
+    }
+    record(name, stack + sizeof(StaticTask_t), stack, !memory->stack);
+    return true;
+}
+
+void ram_map_add(const char *name, size_t size) {
+    record(name, (uint32_t) size, 0, false);
+}
+
+void ram_map_task_deleted(const char *name) {
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < entry_count; i++) {
+        if (0 == strcmp(entries[i].name, name)) {
+            entries[i].freed = entries[i].on_heap;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void ram_map_print(void) {
+    uint32_t static_total = 0, heap_total = 0;
+
+    printf("RAM map (%s allocation of tasks):\n", APP_STATIC_ALLOCATION ? "static" : "heap");
+    for (uint8_t i = 0; i < entry_count; i++) {
+        const ram_map_entry_t *e = &entries[i];
+        if (e->stack) {
+            printf("  %-24s %6lu bytes  task, %lu stack + %lu TCB, %s\n", e->name, (unsigned long) e->size,
+                    (unsigned long) e->stack, (unsigned long) (e->size - e->stack),
+                    e->freed ? "heap, deleted" : e->on_heap ? "heap" : "static");
+        } else {
+            printf("  %-24s %6lu bytes  buffer, static\n", e->name, (unsigned long) e->size);
+        }
+        if (e->freed) {
+            continue;
+        } else if (e->on_heap) {
+            heap_total += e->size;
+        } else {
+            static_total += e->size;
+        }
+    }
+    if (entries_left_out) {
+        printf("  %u more objects not recorded, raise RAM_MAP_MAX_ENTRIES\n", (unsigned int) entries_left_out);
+    }
+    printf("  Listed: %lu bytes static, %lu bytes on the heap\n", (unsigned long) static_total, (unsigned long) heap_total);
+
+    // heap_3 allocates from the C library heap, which only grows
+    struct mallinfo info = mallinfo();
+#if defined(RAM_MAP_LINKER_REGIONS)
+    uint32_t heap_region = (uint32_t) (__HeapLimit - __HeapBase);
+    printf("  Linked: .data %lu, .bss %lu, main stack %lu, heap region %lu bytes\n",
+            (unsigned long) (__data_end__ - __data_start__), (unsigned long) (__bss_end__ - __bss_start__),
+            (unsigned long) (__StackTop - __StackLimit), (unsigned long) heap_region);
+    // what the heap never handed out plus what was freed again
+    printf("  Heap: %lu bytes allocated, %lu taken from the region, %lu bytes headroom\n",
+            (unsigned long) info.uordblks, (unsigned long) info.arena,
+            (unsigned long) (heap_region - (uint32_t) info.arena + (uint32_t) info.fordblks));
+#else
+    printf("  Heap: %lu bytes allocated, %lu taken from the system\n",
+            (unsigned long) info.uordblks, (unsigned long) info.arena);
+#endif
+}
@@ -0,0 +1,67 @@
+//
+// Copyright: Avnet 2021
+//
+// Static RAM profile of the application.
+//
+// With APP_STATIC_ALLOCATION the tasks of the application are created with
+// xTaskCreateStatic() from a stack and a control block that the linker
+// places in .bss, next to the queues and semaphores, which are always
+// static. Only the SDK, lwIP, mbedTLS and the cJSON serializer then
+// allocate from the heap, and the heap size that is left for them is fixed
+// when the application is linked (the top level Makefile has the linker
+// print the memory usage). A task that only runs at start-up and deletes
+// itself is still taken from the heap, which gets its memory back.
+//
+// The tasks and the large static buffers are recorded with their sizes.
+// ram_map_print() lists them with the RAM regions of the linker script and
+// the heap headroom.
+//
+
+#ifndef RAM_MAP_H_
+#define RAM_MAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_config.h"
+
+/* Objects that can be recorded, further ones are left out of the map */
+#define RAM_MAP_MAX_ENTRIES (16)
+
+typedef struct {
+    StackType_t *stack;         // NULL to allocate the stack and control block from the heap
+    StaticTask_t *tcb;
+    uint32_t stack_words;       // as for xTaskCreate()
+} ram_map_task_memory_t;
+
+/* Defines the memory of a task at file scope, statically allocated with APP_STATIC_ALLOCATION */
+#if APP_STATIC_ALLOCATION
+#define RAM_MAP_TASK_MEMORY(name, stack_words) \
+    static StackType_t name##_stack[stack_words]; \
+    static StaticTask_t name##_tcb; \
+    static const ram_map_task_memory_t name = { name##_stack, &name##_tcb, (stack_words) }
+#else
+#define RAM_MAP_TASK_MEMORY(name, stack_words) \
+    static const ram_map_task_memory_t name = { NULL, NULL, (stack_words) }
+#endif
+
+/* The memory of a task that deletes itself, always taken from the heap so that the heap gets it back */
+#define RAM_MAP_HEAP_TASK_MEMORY(name, stack_words) \
+    static const ram_map_task_memory_t name = { NULL, NULL, (stack_words) }
+
+/* xTaskCreate() or xTaskCreateStatic() in 'memory', recorded as 'name' */
+bool ram_map_task_create(TaskFunction_t function, const char *name, const ram_map_task_memory_t *memory,
+        void *parameter, UBaseType_t priority, TaskHandle_t *handle);
+
+/* Records a static buffer of 'size' bytes */
+void ram_map_add(const char *name, size_t size);
+
+/* Records that the heap allocated task 'name' was deleted */
+void ram_map_task_deleted(const char *name);
+
+void ram_map_print(void);
+
+#endif // RAM_MAP_H_
@@ -0,0 +1,145 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "runtime_stats.h"
+
+// Older kernels only define the idle task name in tasks.c
+#ifndef configIDLE_TASK_NAME
+#define configIDLE_TASK_NAME "IDLE"
+#endif
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} task_run_time_t;
+
+static cyhal_timer_t counter_timer;
+static bool counter_running;
+
+static TaskStatus_t task_status[RUNTIME_STATS_MAX_TASKS];
+static task_run_time_t previous[RUNTIME_STATS_MAX_TASKS];
+static uint8_t previous_count;
+static uint32_t previous_total;
+static bool has_previous;
+static uint32_t heap_peak;
+
+void runtime_stats_counter_init(void) {
+    const cyhal_timer_cfg_t cfg = {
+        .compare_value = 0,
+        .period = UINT32_MAX,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .is_continuous = true,
+        .value = 0
+    };
+
+    if (CY_RSLT_SUCCESS != cyhal_timer_init(&counter_timer, NC, NULL)) {
+        return;
+    }
+    if (CY_RSLT_SUCCESS != cyhal_timer_configure(&counter_timer, &cfg)
+            || CY_RSLT_SUCCESS != cyhal_timer_set_frequency(&counter_timer, RUNTIME_STATS_COUNTER_HZ)
+            || CY_RSLT_SUCCESS != cyhal_timer_start(&counter_timer)) {
+        cyhal_timer_free(&counter_timer);
+        return;
+    }
+    counter_running = true;
+}
+
+// Called by the kernel on every context switch, also from interrupt context
+uint32_t runtime_stats_counter(void) {
+    if (!counter_running) {
+        // without a timer the statistics have tick resolution
+        return xTaskGetTickCountFromISR() * (RUNTIME_STATS_COUNTER_HZ / configTICK_RATE_HZ);
+    }
+    return cyhal_timer_read(&counter_timer);
+}
+
+static void sample_heap(runtime_stats_t *stats) {
+    // heap_3 allocates from the C library heap, which only grows
+    struct mallinfo info = mallinfo();
+    if ((uint32_t) info.arena > heap_peak) {
+        heap_peak = (uint32_t) info.arena;
+    }
+    stats->heap_used = (uint32_t) info.uordblks;
+    stats->heap_peak = heap_peak;
+}
+
+static uint32_t previous_run_time(TaskHandle_t handle) {
+    for (uint8_t i = 0; i < previous_count; i++) {
+        if (previous[i].handle == handle) {
+            return previous[i].run_time;
+        }
+    }
+    return 0; // created since the previous sample
+}
+
+// The run times of this sample are the baseline of the next one
+static void keep_baseline(UBaseType_t count, uint32_t total) {
+    for (UBaseType_t i = 0; i < count; i++) {
+        previous[i].handle = task_status[i].xHandle;
+        previous[i].run_time = task_status[i].ulRunTimeCounter;
+    }
+    previous_count = (uint8_t) count;
+    previous_total = total;
+    has_previous = count != 0;
+}
+
+void runtime_stats_restart(void) {
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, RUNTIME_STATS_MAX_TASKS, &total);
+
+    keep_baseline(count, total);
+}
+
+bool runtime_stats_sample(runtime_stats_t *stats) {
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, RUNTIME_STATS_MAX_TASKS, &total);
+
+    memset(stats, 0, sizeof(*stats));
+    sample_heap(stats);
+    if (!count) {
+        printf("Run-time stats: more than %d tasks\n", RUNTIME_STATS_MAX_TASKS);
+        return false;
+    }
+
+    bool valid = has_previous;
+    uint32_t interval = total - previous_total;
+    stats->interval_ms = interval / (RUNTIME_STATS_COUNTER_HZ / 1000U);
+    stats->task_count = (uint8_t) count;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *status = &task_status[i];
+        runtime_stats_task_t *task = &stats->tasks[i];
+        uint32_t run_time = status->ulRunTimeCounter - previous_run_time(status->xHandle);
+
+        strncpy(task->name, status->pcTaskName, sizeof(task->name) - 1);
+        task->cpu_permille = interval ? (uint16_t) ((uint64_t) run_time * 1000U / interval) : 0;
+        task->stack_free_min = (uint32_t) status->usStackHighWaterMark * sizeof(StackType_t);
+        if (0 == strcmp(status->pcTaskName, configIDLE_TASK_NAME)) {
+            stats->cpu_load_permille = (uint16_t) (task->cpu_permille < 1000 ? 1000 - task->cpu_permille : 0);
+        }
+    }
+    keep_baseline(count, total);
+    return valid;
+}
+
+void runtime_stats_print(const runtime_stats_t *stats) {
+    printf("Run-time stats over %lu ms: CPU load %u.%u%%, heap %lu bytes (peak %lu)\n",
+            (unsigned long) stats->interval_ms,
+            stats->cpu_load_permille / 10, stats->cpu_load_permille % 10,
+            (unsigned long) stats->heap_used, (unsigned long) stats->heap_peak);
+    for (uint8_t i = 0; i < stats->task_count; i++) {
+        const runtime_stats_task_t *task = &stats->tasks[i];
+        printf("  %-16s %3u.%u%% CPU %6lu bytes stack free\n",
+                task->name, task->cpu_permille / 10, task->cpu_permille % 10,
+                (unsigned long) task->stack_free_min);
+    }
+}
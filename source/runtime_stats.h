@@ -0,0 +1,57 @@
+//
+// Copyright: Avnet 2021
+//
+// Per-task CPU and stack run-time statistics.
+//
+// FreeRTOS accounts the time every task runs (configGENERATE_RUN_TIME_STATS)
+// with a free running 1 MHz hardware timer as the run-time counter.
+// runtime_stats_sample() returns how the CPU was split between the tasks since
+// the previous sample, the least stack every task had left and the heap usage.
+//
+// The counter is 32 bits wide and wraps after about 71 minutes, so samples
+// must be taken more often than that, or the baseline taken again with
+// runtime_stats_restart() after a longer break.
+//
+
+#ifndef RUNTIME_STATS_H_
+#define RUNTIME_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/* Run-time counter frequency */
+#define RUNTIME_STATS_COUNTER_HZ    (1000000U)
+/* Tasks that can be reported. Sampling fails if there are more. */
+#define RUNTIME_STATS_MAX_TASKS     (16)
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t cpu_permille;          // share of the CPU time since the previous sample
+    uint32_t stack_free_min;        // bytes of stack that were never used
+} runtime_stats_task_t;
+
+typedef struct {
+    uint32_t interval_ms;           // time since the previous sample
+    uint16_t cpu_load_permille;     // CPU time not spent in the idle task
+    uint32_t heap_used;             // bytes allocated from the heap right now
+    uint32_t heap_peak;             // highest heap size seen
+    uint8_t task_count;
+    runtime_stats_task_t tasks[RUNTIME_STATS_MAX_TASKS];
+} runtime_stats_t;
+
+/* portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() and portGET_RUN_TIME_COUNTER_VALUE() (see FreeRTOSConfig.h) */
+void runtime_stats_counter_init(void);
+uint32_t runtime_stats_counter(void);
+
+/* Takes a sample. Must be called from one task only. Returns false if there was no earlier sample. */
+bool runtime_stats_sample(runtime_stats_t *stats);
+
+/* Makes the next sample cover the time from now. Must be called from the task that takes the samples. */
+void runtime_stats_restart(void);
+
+void runtime_stats_print(const runtime_stats_t *stats);
+
+#endif // RUNTIME_STATS_H_
@@ -0,0 +1,395 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "math.h"
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "xensiv_pasco2_mtb.h"
+#include "xensiv_dps3xx_mtb.h"
+#include "xensiv_dps3xx.h"
+
+#include "app_config.h"
+#include "sensor_sampler.h"
+#include "telemetry_writer.h"
+#include "i2c_bus.h"
+#include "boot.h"
+#include "ram_map.h"
+#include "timestamp.h"
+#include "trace.h"
+#include "periodic.h"
+
+#if (APP_SAMPLER_QUEUE_LENGTH & (APP_SAMPLER_QUEUE_LENGTH - 1))
+#error "APP_SAMPLER_QUEUE_LENGTH must be a power of two"
+#endif
+
+#if defined(TARGET_CYSBSYSKIT_DEV_01)
+/* Output pin for sensor PSEL line */
+#define MTB_PASCO2_PSEL (P5_3)
+/* Output pin for PAS CO2 Wing Board power switch */
+#define MTB_PASCO2_POWER_SWITCH (P10_5)
+/* Output pin for PAS CO2 Wing Board LED OK */
+#define MTB_PASCO2_LED_OK (P9_0)
+/* Output pin for PAS CO2 Wing Board LED WARNING  */
+#define MTB_PASCO2_LED_WARNING (P9_1)
+/* Input pin for the PAS CO2 Wing Board INT line */
+#define MTB_PASCO2_INT (P5_5)
+#endif
+
+/* Pin state to enable I2C channel of sensor */
+#define MTB_PASCO2_PSEL_I2C_ENABLE (0U)
+/* Pin state to enable power to sensor on PAS CO2 Wing Board*/
+#define MTB_PASCO2_POWER_ON (1U)
+/* Pin state for PAS CO2 Wing Board LED off. */
+#define MTB_PASCO_LED_STATE_OFF (0U)
+/* Pin state for PAS CO2 Wing Board LED on. */
+#define MTB_PASCO_LED_STATE_ON (1U)
+/* I2C bus frequency */
+#define I2C_MASTER_FREQUENCY (400000U)  //100000U
+
+#define DEFAULT_PRESSURE_VALUE (1015.0F)
+
+/* Delay time after hardware initialization */
+#define PASCO2_INITIALIZATION_DELAY (2000)
+
+/* Delay time after each PAS CO2 readout */
+#define PASCO2_PROCESS_DELAY (1000)
+
+/* Continuous mode measurement period of the PAS CO2, in seconds */
+#define PASCO2_MEAS_RATE_S (APP_TELEMETRY_SAMPLE_PERIOD_MS / 1000)
+/* How much later than expected a data ready interrupt may come before the result is read anyway */
+#define PASCO2_DATA_READY_MARGIN_MS (2000)
+
+#if APP_SAMPLER_DATA_READY && (PASCO2_MEAS_RATE_S < 5 || PASCO2_MEAS_RATE_S > 4095)
+#error "The PAS CO2 measurement period (APP_TELEMETRY_SAMPLE_PERIOD_MS) must be between 5 s and 4095 s"
+#endif
+
+static xensiv_pasco2_t xensiv_pasco2;
+static cyhal_i2c_t cyhal_i2c;
+static xensiv_dps3xx_t dps310_sensor;
+
+/* Single producer (sampler task), single consumer (publisher) ring.
+ * Each side only writes its own index, so no lock is needed. The indices run
+ * freely and are reduced modulo the queue length on access.
+ */
+static telemetry_sample_t sample_queue[APP_SAMPLER_QUEUE_LENGTH];
+static uint32_t queue_head; // written by the consumer
+static uint32_t queue_tail; // written by the producer
+
+static uint32_t samples_taken;
+static uint32_t samples_dropped;
+static uint32_t queue_max_depth;
+static uint32_t data_ready_timeouts;
+// the sampling times against APP_TELEMETRY_SAMPLE_PERIOD_MS
+static periodic_job_t sample_job;
+
+static TaskHandle_t consumer_task;
+static TaskHandle_t sampler_task;
+RAM_MAP_TASK_MEMORY(sampler_task_memory, SENSOR_SAMPLER_TASK_STACK_SIZE);
+// only used by the sampler task
+static timestamp_formatter_t timestamp_formatter = { .hour = -1, .second = -1 };
+
+static void read_sensors(telemetry_sample_t *sample) {
+    uint16_t ppm = 0;
+    float32_t pressure = DEFAULT_PRESSURE_VALUE;
+    float32_t temperature = 0;
+
+    // Read the pressure and temperature data
+    TRACE_BEGIN(TRACE_SPAN_DPS310_READ);
+    cy_rslt_t result = xensiv_dps3xx_read(&dps310_sensor, &pressure, &temperature);
+    TRACE_END(TRACE_SPAN_DPS310_READ);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        // Display the pressure and temperature data in console, without the floating point printf
+        char pressure_text[TELEMETRY_WRITER_FLOAT_LEN];
+        char temperature_text[TELEMETRY_WRITER_FLOAT_LEN];
+        int pressure_len = (int) telemetry_writer_format_float(pressure_text, pressure, 2);
+        int temperature_len = (int) telemetry_writer_format_float(temperature_text, temperature, 2);
+        printf("Pressure : %.*s mBar", pressure_len, pressure_text);
+        // 0xF8 - ASCII Degree Symbol
+        printf("\t Temperature: %.*s %cC \r\n\n", temperature_len, temperature_text, 0xF8);
+    }
+    else
+    {
+        printf("\n Failed to read temperature and pressure data.\r\n");
+    }
+
+    /* Read CO2 value from sensor */
+    TRACE_BEGIN(TRACE_SPAN_PASCO2_READ);
+#if APP_SAMPLER_DATA_READY
+    // the result that raised the data ready interrupt, and the pressure reference for the next measurement
+    result = xensiv_pasco2_get_result(&xensiv_pasco2, &ppm); //unit PPM
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = xensiv_pasco2_set_pressure_compensation(&xensiv_pasco2, (uint16_t)pressure);
+    }
+#else
+    result = xensiv_pasco2_mtb_read(&xensiv_pasco2, (uint16_t)pressure, &ppm); //unit PPM
+#endif
+    TRACE_END(TRACE_SPAN_PASCO2_READ);
+    if (result != CY_RSLT_SUCCESS)
+    {
+    	printf("pasco2 sensor read error\r\n");
+    }
+
+    memcpy(sample->timestamp, timestamp_now_iso(&timestamp_formatter), sizeof(sample->timestamp));
+    sample->co2level = ppm;
+    //round the number to 2 decimal places
+    sample->temperature = roundf(temperature * 100) / 100;
+    sample->pressure = pressure;
+}
+
+static bool queue_push(const telemetry_sample_t *sample) {
+    uint32_t tail = queue_tail;
+    uint32_t depth = tail - __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE);
+
+    if (depth >= APP_SAMPLER_QUEUE_LENGTH) {
+        return false;
+    }
+    sample_queue[tail % APP_SAMPLER_QUEUE_LENGTH] = *sample;
+    // publish the sample before the new tail becomes visible to the consumer
+    __atomic_store_n(&queue_tail, tail + 1, __ATOMIC_RELEASE);
+
+    if (depth + 1 > queue_max_depth) {
+        queue_max_depth = depth + 1;
+    }
+    return true;
+}
+
+bool sensor_sampler_pop(telemetry_sample_t *sample) {
+    uint32_t head = queue_head;
+
+    if (head == __atomic_load_n(&queue_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    *sample = sample_queue[head % APP_SAMPLER_QUEUE_LENGTH];
+    // release the slot only after the sample was copied out
+    __atomic_store_n(&queue_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void sensor_sampler_get_stats(sensor_sampler_stats_t *stats) {
+    stats->samples = samples_taken;
+    stats->dropped = samples_dropped;
+    stats->depth = __atomic_load_n(&queue_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE);
+    stats->max_depth = queue_max_depth;
+    stats->data_ready_timeouts = data_ready_timeouts;
+}
+
+void sensor_sampler_print_schedule(void) {
+    periodic_print_stats(&sample_job);
+}
+
+#if APP_SAMPLER_DATA_READY
+static void pasco2_data_ready_isr(void *callback_arg, cyhal_gpio_event_t event) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    (void) callback_arg;
+    (void) event;
+    if (sampler_task) {
+        vTaskNotifyGiveFromISR(sampler_task, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+}
+#endif
+
+static void sensor_sampler_init(void);
+
+static void sensor_sampler_task(void *pvParameters) {
+    /* To avoid compiler warnings */
+    (void) pvParameters;
+
+    // the sensors warm up while the other tasks join Wi-Fi and read the certificate
+    boot_phase_begin(BOOT_PHASE_SENSORS);
+    sensor_sampler_init();
+    boot_phase_end(BOOT_PHASE_SENSORS);
+    // samples are timestamped, so sampling starts once the time is known
+    boot_wait(BOOT_BIT(BOOT_PHASE_TIME));
+
+    periodic_job_start(&sample_job);
+    for (;;) {
+        telemetry_sample_t sample;
+
+#if APP_SAMPLER_DATA_READY
+        // The PAS CO2 paces the sampling. It releases its INT line once the result is read,
+        // so an edge that came before this task was waiting is recovered by reading anyway.
+        if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_TELEMETRY_SAMPLE_PERIOD_MS + PASCO2_DATA_READY_MARGIN_MS))) {
+            data_ready_timeouts++;
+        }
+        periodic_begin_paced(&sample_job);
+#else
+        // on the grid of the other periodic jobs, regardless of how long the readout took
+        periodic_wait(&sample_job);
+        periodic_begin(&sample_job);
+#endif
+        read_sensors(&sample);
+        samples_taken++;
+        if (!queue_push(&sample)) {
+            samples_dropped++;
+        }
+        xTaskNotifyGive(consumer_task);
+        periodic_end(&sample_job);
+    }
+}
+
+bool sensor_sampler_start(TaskHandle_t consumer) {
+    consumer_task = consumer;
+    periodic_job_init(&sample_job, "Sample", APP_TELEMETRY_SAMPLE_PERIOD_MS, 0);
+    ram_map_add("Sample queue", sizeof(sample_queue));
+    return ram_map_task_create(sensor_sampler_task, "Sensor Sampler", &sampler_task_memory, NULL,
+            SENSOR_SAMPLER_TASK_PRIORITY, &sampler_task);
+}
+
+static void sensor_sampler_init(void)
+{
+    cy_rslt_t result;
+
+    // initialize i2c library
+    cyhal_i2c_cfg_t i2c_master_config = {CYHAL_I2C_MODE_MASTER,
+                                         0, // address is not used for master mode
+                                         I2C_MASTER_FREQUENCY};
+
+    result = cyhal_i2c_init(&cyhal_i2c, CYBSP_I2C_SDA, CYBSP_I2C_SCL, NULL);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+    result = cyhal_i2c_configure(&cyhal_i2c, &i2c_master_config);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+    // The sensor drivers' transfers go through the bus manager from here on
+    if (!i2c_bus_init(&cyhal_i2c))
+    {
+        CY_ASSERT(0);
+    }
+
+    // Initialize and enable PAS CO2 Wing Board I2C channel communication
+    result = cyhal_gpio_init(MTB_PASCO2_PSEL, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO2_PSEL_I2C_ENABLE);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+
+    // Initialize and enable PAS CO2 Wing Board power switch
+    result = cyhal_gpio_init(MTB_PASCO2_POWER_SWITCH, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO2_POWER_ON);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+
+    // Initialize the LEDs on PAS CO2 Wing Board
+    result = cyhal_gpio_init(MTB_PASCO2_LED_OK, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO_LED_STATE_OFF);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+
+    result = cyhal_gpio_init(MTB_PASCO2_LED_WARNING, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG, MTB_PASCO_LED_STATE_OFF);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+
+    // Delay 2s to wait for pasco2 sensor get ready
+    vTaskDelay(pdMS_TO_TICKS(PASCO2_INITIALIZATION_DELAY));
+
+    // Initialize PAS CO2 sensor with default parameter values
+    result = xensiv_pasco2_mtb_init_i2c(&xensiv_pasco2, &cyhal_i2c);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("PAS CO2 device initialization error\n");
+        printf("Exiting pasco2_task task\n");
+        // exit current thread (suspend)
+        return;
+    }
+    // Configure PAS CO2 Wing board interrupt to enable 12V boost converter in wingboard
+    xensiv_pasco2_interrupt_config_t int_config =
+    {
+#if APP_SAMPLER_DATA_READY
+        .b.int_func = XENSIV_PASCO2_INTERRUPT_FUNCTION_DRDY,
+#else
+        .b.int_func = XENSIV_PASCO2_INTERRUPT_FUNCTION_NONE,
+#endif
+        .b.int_typ = (uint32_t)XENSIV_PASCO2_INTERRUPT_TYPE_LOW_ACTIVE
+    };
+
+    result = xensiv_pasco2_set_interrupt_config(&xensiv_pasco2, int_config);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("PAS CO2 interrupt configuration error");
+        CY_ASSERT(0);
+    }
+
+    cyhal_gpio_write(CYBSP_USER_LED, false); // USER_LED is active low
+
+    // Turn on status LED on PAS CO2 Wing Board to indicate normal operation
+    cyhal_gpio_write(MTB_PASCO2_LED_OK, MTB_PASCO_LED_STATE_ON);
+
+
+    // Initialize pressure sensor
+    result = xensiv_dps3xx_mtb_init_i2c(&dps310_sensor, &cyhal_i2c,
+                                        XENSIV_DPS3XX_I2C_ADDR_ALT);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("\r\nFailed to initialize DPS310 I2C\r\n");
+        CY_ASSERT(0);
+    }
+
+    uint32_t revisionID = 0;
+
+    // Retrieve the DPS310 Revision ID and display the same
+    if (xensiv_dps3xx_get_revision_id(&dps310_sensor,(uint8_t*)&revisionID) == CY_RSLT_SUCCESS)
+    {
+        printf("DPS310 Revision ID = %d\r\n\n",(uint8_t)revisionID);
+    }
+    else
+    {
+        printf("Failed to get Revision ID\r\n");
+        CY_ASSERT(0);
+    }
+
+#if APP_SAMPLER_DATA_READY
+    // DPS310 converts in the background, a readout only fetches the latest results
+    xensiv_dps3xx_config_t dps_config;
+    result = xensiv_dps3xx_get_config(&dps310_sensor, &dps_config);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        dps_config.dev_mode = XENSIV_DPS3XX_MODE_BACKGROUND_ALL;
+        dps_config.pressure_rate = XENSIV_DPS3XX_RATE_1;
+        dps_config.temperature_rate = XENSIV_DPS3XX_RATE_1;
+        result = xensiv_dps3xx_set_config(&dps310_sensor, &dps_config);
+    }
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("DPS310 background mode configuration error\r\n");
+        CY_ASSERT(0);
+    }
+
+    // PAS CO2 data ready interrupt (low active) wakes the sampler task
+    result = cyhal_gpio_init(MTB_PASCO2_INT, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_PULLUP, true);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+    cyhal_gpio_register_callback(MTB_PASCO2_INT, pasco2_data_ready_isr, NULL);
+    cyhal_gpio_enable_event(MTB_PASCO2_INT, CYHAL_GPIO_IRQ_FALL, CYHAL_ISR_PRIORITY_DEFAULT, true);
+
+    result = xensiv_pasco2_start_continuous_mode(&xensiv_pasco2, PASCO2_MEAS_RATE_S);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("PAS CO2 continuous mode error\r\n");
+        CY_ASSERT(0);
+    }
+#endif
+
+    printf("PAS CO2 and DPSxxx pressure sensors initialized successfully\n\n");
+}
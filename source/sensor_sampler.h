@@ -0,0 +1,51 @@
+//
+// Copyright: Avnet 2021
+//
+// Sensor sampler task.
+//
+// Reads the DPS310 pressure/temperature sensor and the PAS CO2 sensor every
+// APP_TELEMETRY_SAMPLE_PERIOD_MS, paced by the PAS CO2 data ready interrupt
+// with APP_SAMPLER_DATA_READY, and hands the samples to the publisher
+// through a lock-free single-producer/single-consumer queue, so that the
+// sampling period does not depend on how long publishing takes. Without
+// APP_SAMPLER_DATA_READY the samples are taken at phase 0 of the grid of the
+// periodic jobs (periodic.h).
+//
+
+#ifndef SENSOR_SAMPLER_H_
+#define SENSOR_SAMPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "telemetry_sample.h"
+
+/* Above the app task, so that a long publish does not delay a readout */
+#define SENSOR_SAMPLER_TASK_PRIORITY    (3)
+#define SENSOR_SAMPLER_TASK_STACK_SIZE  (1024 * 2)
+
+typedef struct {
+    uint32_t samples;       // samples taken
+    uint32_t dropped;       // samples lost because the queue was full
+    uint32_t depth;         // samples currently queued
+    uint32_t max_depth;     // highest queue depth seen
+    uint32_t data_ready_timeouts; // samples taken without a PAS CO2 data ready interrupt
+} sensor_sampler_stats_t;
+
+/* Starts the sampler task, which initializes the I2C bus, the PAS CO2 Wing Board and both sensors
+ * (BOOT_PHASE_SENSORS) and starts sampling once BOOT_PHASE_TIME has ended (see boot.h).
+ * 'consumer' gets a task notification for every new sample. */
+bool sensor_sampler_start(TaskHandle_t consumer);
+
+/* Takes the oldest sample off the queue. Must only be called from the consumer task. */
+bool sensor_sampler_pop(telemetry_sample_t *sample);
+
+void sensor_sampler_get_stats(sensor_sampler_stats_t *stats);
+
+/* The jitter and overruns of the sampling times (see periodic.h) */
+void sensor_sampler_print_schedule(void);
+
+#endif // SENSOR_SAMPLER_H_
@@ -0,0 +1,41 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "telemetry_batch.h"
+
+void telemetry_batch_init(telemetry_batch_t *batch) {
+    memset(batch, 0, sizeof(*batch));
+}
+
+void telemetry_batch_add(telemetry_batch_t *batch, const telemetry_sample_t *sample) {
+    if (batch->count == APP_TELEMETRY_BATCH_CAPACITY) {
+        telemetry_batch_consume(batch, 1);
+        batch->dropped++;
+    }
+    uint16_t tail = (uint16_t) ((batch->head + batch->count) % APP_TELEMETRY_BATCH_CAPACITY);
+    batch->samples[tail] = *sample;
+    batch->added[tail] = xTaskGetTickCount();
+    batch->count++;
+}
+
+const telemetry_sample_t *telemetry_batch_get(const telemetry_batch_t *batch, uint16_t index) {
+    return &batch->samples[(batch->head + index) % APP_TELEMETRY_BATCH_CAPACITY];
+}
+
+TickType_t telemetry_batch_get_added(const telemetry_batch_t *batch, uint16_t index) {
+    return batch->added[(batch->head + index) % APP_TELEMETRY_BATCH_CAPACITY];
+}
+
+void telemetry_batch_consume(telemetry_batch_t *batch, uint16_t count) {
+    if (count > batch->count) {
+        count = batch->count;
+    }
+    batch->head = (uint16_t) ((batch->head + count) % APP_TELEMETRY_BATCH_CAPACITY);
+    batch->count -= count;
+}
@@ -0,0 +1,53 @@
+//
+// Copyright: Avnet 2021
+//
+// Fixed-size ring of telemetry samples waiting to be published.
+//
+// The publish job of app_task.c flushes it every APP_TELEMETRY_BATCH_PERIOD_MS,
+// in multi-point messages of up to APP_TELEMETRY_BATCH_SIZE samples.
+// While the connection is down the ring keeps up to APP_TELEMETRY_BATCH_CAPACITY
+// samples and then overwrites the oldest ones, which app_task.c moves to the
+// flash store first.
+//
+
+#ifndef TELEMETRY_BATCH_H_
+#define TELEMETRY_BATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "app_config.h"
+#include "telemetry_sample.h"
+
+#if (APP_TELEMETRY_BATCH_CAPACITY < APP_TELEMETRY_BATCH_SIZE)
+#error "APP_TELEMETRY_BATCH_CAPACITY must be at least APP_TELEMETRY_BATCH_SIZE"
+#endif
+#if (APP_TELEMETRY_STORE && APP_TELEMETRY_BATCH_CAPACITY < APP_STORE_REPLAY_BATCH_SIZE)
+#error "APP_TELEMETRY_BATCH_CAPACITY must be at least APP_STORE_REPLAY_BATCH_SIZE"
+#endif
+
+typedef struct {
+    telemetry_sample_t samples[APP_TELEMETRY_BATCH_CAPACITY];
+    uint16_t head;          // index of the oldest sample
+    uint16_t count;
+    TickType_t added[APP_TELEMETRY_BATCH_CAPACITY]; // tick count when each sample was queued
+    uint32_t dropped;       // samples overwritten before they could be published
+} telemetry_batch_t;
+
+void telemetry_batch_init(telemetry_batch_t *batch);
+
+/* Queues a copy of 'sample'. Overwrites the oldest sample if the ring is full. */
+void telemetry_batch_add(telemetry_batch_t *batch, const telemetry_sample_t *sample);
+
+/* Returns the index'th oldest sample, index < count */
+const telemetry_sample_t *telemetry_batch_get(const telemetry_batch_t *batch, uint16_t index);
+
+/* Returns the tick count when the index'th oldest sample was queued, index < count */
+TickType_t telemetry_batch_get_added(const telemetry_batch_t *batch, uint16_t index);
+
+/* Removes the 'count' oldest samples after they have been published */
+void telemetry_batch_consume(telemetry_batch_t *batch, uint16_t count);
+
+#endif // TELEMETRY_BATCH_H_
@@ -0,0 +1,262 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <string.h>
+
+#include "telemetry_cbor.h"
+
+/* SDK identification that the IoTConnect C library puts in every message */
+#define TELEMETRY_SDK_LANG      "M_C"
+#define TELEMETRY_SDK_VERSION   "2.0"
+
+#define CBOR_UINT           (0U << 5)
+#define CBOR_NEGATIVE       (1U << 5)
+#define CBOR_TEXT           (3U << 5)
+#define CBOR_ARRAY          (4U << 5)
+#define CBOR_MAP            (5U << 5)
+#define CBOR_TAG            (6U << 5)
+#define CBOR_INDEFINITE     (31U)
+#define CBOR_NULL           (0xF6U)
+#define CBOR_BREAK          (0xFFU)
+
+#define CBOR_TAG_EPOCH      (1U)
+#define CBOR_TAG_DECIMAL    (4U)
+
+static void put_raw(telemetry_cbor_t *w, const void *data, size_t len) {
+    if (w->overflow) {
+        return;
+    }
+    if (len > w->size - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->len], data, len);
+    w->len += len;
+}
+
+static void put_byte(telemetry_cbor_t *w, uint8_t byte) {
+    put_raw(w, &byte, 1);
+}
+
+// Initial byte and argument in the shortest form
+static void put_head(telemetry_cbor_t *w, uint8_t major, uint64_t value) {
+    uint8_t head[9];
+    size_t len;
+
+    if (value < 24) {
+        head[0] = (uint8_t) (major | value);
+        len = 1;
+    } else if (value <= UINT8_MAX) {
+        head[0] = (uint8_t) (major | 24);
+        len = 2;
+    } else if (value <= UINT16_MAX) {
+        head[0] = (uint8_t) (major | 25);
+        len = 3;
+    } else if (value <= UINT32_MAX) {
+        head[0] = (uint8_t) (major | 26);
+        len = 5;
+    } else {
+        head[0] = (uint8_t) (major | 27);
+        len = 9;
+    }
+    // big endian argument
+    for (size_t i = len - 1; i > 0; i--) {
+        head[i] = (uint8_t) value;
+        value >>= 8;
+    }
+    put_raw(w, head, len);
+}
+
+static void put_int(telemetry_cbor_t *w, int64_t value) {
+    if (value < 0) {
+        put_head(w, CBOR_NEGATIVE, (uint64_t) (-1 - value));
+    } else {
+        put_head(w, CBOR_UINT, (uint64_t) value);
+    }
+}
+
+static void put_text(telemetry_cbor_t *w, const char *str) {
+    size_t len = strlen(str);
+    put_head(w, CBOR_TEXT, len);
+    put_raw(w, str, len);
+}
+
+static bool put_field_name(telemetry_cbor_t *w, const char *name) {
+    if (!w->points) {
+        return false;
+    }
+    put_text(w, name);
+    return !w->overflow;
+}
+
+static bool parse_digits(const char *str, int count, int *value) {
+    *value = 0;
+    for (int i = 0; i < count; i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return false;
+        }
+        *value = *value * 10 + (str[i] - '0');
+    }
+    return true;
+}
+
+// "YYYY-MM-DDTHH:MM:SS..." (UTC) to seconds since 1970
+static bool parse_iso_timestamp(const char *iso, int64_t *epoch) {
+    int year, month, day, hour, minute, second;
+
+    if (strlen(iso) < sizeof("0000-00-00T00:00:00") - 1
+            || iso[4] != '-' || iso[7] != '-' || iso[10] != 'T' || iso[13] != ':' || iso[16] != ':'
+            || !parse_digits(&iso[0], 4, &year) || !parse_digits(&iso[5], 2, &month)
+            || !parse_digits(&iso[8], 2, &day) || !parse_digits(&iso[11], 2, &hour)
+            || !parse_digits(&iso[14], 2, &minute) || !parse_digits(&iso[17], 2, &second)
+            || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    // days since 1970-01-01 of the proleptic Gregorian calendar, with years starting in March
+    int y = year - (month <= 2);
+    int era = y / 400;
+    int year_of_era = y - era * 400;
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64_t days = (int64_t) era * 146097 + day_of_era - 719468;
+
+    *epoch = days * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+void telemetry_cbor_begin(telemetry_cbor_t *w, uint8_t *buf, size_t size, const IotclConfig *config) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = (size == 0 || !config);
+    w->points = 0;
+    w->in_object = false;
+    if (w->overflow) {
+        return;
+    }
+
+    put_head(w, CBOR_MAP, 5);
+    put_text(w, "cpId");
+    put_text(w, config->device.cpid);
+    put_text(w, "dtg");
+    put_text(w, config->telemetry.dtg);
+    put_text(w, "mt");
+    put_int(w, 0);
+    put_text(w, "sdk");
+    put_head(w, CBOR_MAP, 3);
+    put_text(w, "l");
+    put_text(w, TELEMETRY_SDK_LANG);
+    put_text(w, "v");
+    put_text(w, TELEMETRY_SDK_VERSION);
+    put_text(w, "e");
+    put_text(w, config->device.env);
+    put_text(w, "d");
+    put_head(w, CBOR_ARRAY, 1);
+    put_head(w, CBOR_MAP, 3);
+    put_text(w, "id");
+    put_text(w, config->device.duid);
+    put_text(w, "tg");
+    put_text(w, "");
+    put_text(w, "d");
+    put_byte(w, CBOR_ARRAY | CBOR_INDEFINITE);
+}
+
+bool telemetry_cbor_add_point(telemetry_cbor_t *w, const char *iso_timestamp) {
+    int64_t epoch;
+
+    if (!parse_iso_timestamp(iso_timestamp, &epoch)) {
+        w->overflow = true;
+        return false;
+    }
+    telemetry_cbor_end_object(w);
+    if (w->points++) {
+        put_byte(w, CBOR_BREAK); // fields of the previous data point
+    }
+    put_head(w, CBOR_MAP, 2);
+    put_text(w, "dt");
+    put_head(w, CBOR_TAG, CBOR_TAG_EPOCH);
+    put_int(w, epoch);
+    put_text(w, "d");
+    put_byte(w, CBOR_MAP | CBOR_INDEFINITE);
+    return !w->overflow;
+}
+
+bool telemetry_cbor_set_string(telemetry_cbor_t *w, const char *name, const char *value) {
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    put_text(w, value);
+    return !w->overflow;
+}
+
+bool telemetry_cbor_set_int(telemetry_cbor_t *w, const char *name, int32_t value) {
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    put_int(w, value);
+    return !w->overflow;
+}
+
+bool telemetry_cbor_set_float(telemetry_cbor_t *w, const char *name, float value, uint8_t decimals) {
+    static const uint32_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    // same range as telemetry_writer_set_float()
+    if (value != value || value > 1e12f || value < -1e12f) {
+        put_byte(w, CBOR_NULL);
+        return !w->overflow;
+    }
+    if (decimals > TELEMETRY_CBOR_MAX_DECIMALS) {
+        decimals = TELEMETRY_CBOR_MAX_DECIMALS;
+    }
+
+    double magnitude = value < 0 ? -(double) value : (double) value;
+    int64_t mantissa = (int64_t) (magnitude * scales[decimals] + 0.5);
+
+    // drop trailing zeros of the fraction
+    while (decimals && mantissa % 10 == 0) {
+        mantissa /= 10;
+        decimals--;
+    }
+    if (value < 0) {
+        mantissa = -mantissa;
+    }
+    if (decimals) {
+        put_head(w, CBOR_TAG, CBOR_TAG_DECIMAL);
+        put_head(w, CBOR_ARRAY, 2);
+        put_int(w, -(int64_t) decimals);
+    }
+    put_int(w, mantissa);
+    return !w->overflow;
+}
+
+bool telemetry_cbor_begin_object(telemetry_cbor_t *w, const char *name) {
+    if (w->in_object || !put_field_name(w, name)) {
+        return false;
+    }
+    put_byte(w, CBOR_MAP | CBOR_INDEFINITE);
+    w->in_object = true;
+    return !w->overflow;
+}
+
+bool telemetry_cbor_end_object(telemetry_cbor_t *w) {
+    if (!w->in_object) {
+        return false;
+    }
+    put_byte(w, CBOR_BREAK);
+    w->in_object = false;
+    return !w->overflow;
+}
+
+size_t telemetry_cbor_finish(telemetry_cbor_t *w) {
+    telemetry_cbor_end_object(w);
+    if (w->points) {
+        put_byte(w, CBOR_BREAK);
+    }
+    put_byte(w, CBOR_BREAK);
+    return w->overflow ? 0 : w->len;
+}
@@ -0,0 +1,66 @@
+//
+// Copyright: Avnet 2021
+//
+// Heap-free CBOR (RFC 8949) telemetry serializer.
+//
+// Encodes the message layout of telemetry_writer.h as CBOR maps and arrays
+// with the same keys, into a caller supplied buffer. Two things are encoded
+// more compactly than their JSON text:
+//
+// - the data point "dt" timestamps are epoch seconds (tag 1) instead of ISO
+//   8601 strings
+// - numbers set with telemetry_cbor_set_float() are fixed point decimal
+//   fractions (tag 4, [exponent, mantissa]) or plain integers when they have
+//   no fraction digits left
+//
+// Data points and their fields are written as indefinite length containers,
+// so that nothing has to be counted ahead. Once the buffer is exhausted every
+// further call is ignored and telemetry_cbor_finish() returns 0.
+//
+// host/bench/cbor_json.c decodes the messages back into JSON.
+//
+
+#ifndef TELEMETRY_CBOR_H_
+#define TELEMETRY_CBOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotconnect_lib.h"
+
+/* Maximum number of fraction digits accepted by telemetry_cbor_set_float() */
+#define TELEMETRY_CBOR_MAX_DECIMALS (6U)
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+    uint16_t points;    // data points written so far
+    bool in_object;
+} telemetry_cbor_t;
+
+/* Starts a message for the device described by 'config' (see iotcl_get_config()) */
+void telemetry_cbor_begin(telemetry_cbor_t *w, uint8_t *buf, size_t size, const IotclConfig *config);
+
+/* Starts a new data point. 'iso_timestamp' as returned by timestamp_now_iso(), milliseconds are dropped.
+ * Fields can only be set after a data point was added. */
+bool telemetry_cbor_add_point(telemetry_cbor_t *w, const char *iso_timestamp);
+
+bool telemetry_cbor_set_string(telemetry_cbor_t *w, const char *name, const char *value);
+
+bool telemetry_cbor_set_int(telemetry_cbor_t *w, const char *name, int32_t value);
+
+/* Writes 'value' rounded to 'decimals' fraction digits, without trailing zeros */
+bool telemetry_cbor_set_float(telemetry_cbor_t *w, const char *name, float value, uint8_t decimals);
+
+/* Starts a map field of the current data point. Maps cannot be nested. */
+bool telemetry_cbor_begin_object(telemetry_cbor_t *w, const char *name);
+
+bool telemetry_cbor_end_object(telemetry_cbor_t *w);
+
+/* Terminates the message. Returns its size, or 0 if it did not fit or a timestamp was malformed. */
+size_t telemetry_cbor_finish(telemetry_cbor_t *w);
+
+#endif // TELEMETRY_CBOR_H_
@@ -0,0 +1,137 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "telemetry_filter.h"
+#include "telemetry_writer.h"
+
+typedef struct {
+    const char *name;
+    uint8_t precision;          // decimals when serialized
+    float absolute;
+    float relative;
+} field_config_t;
+
+static const field_config_t field_configs[TELEMETRY_FIELD_COUNT] = {
+    [TELEMETRY_FIELD_CO2LEVEL] = { "co2level", 0, APP_DEADBAND_CO2_ABS, APP_DEADBAND_CO2_REL },
+    [TELEMETRY_FIELD_TEMPERATURE] = { "temperature", 2, APP_DEADBAND_TEMPERATURE_ABS, APP_DEADBAND_TEMPERATURE_REL },
+    [TELEMETRY_FIELD_PRESSURE] = { "pressure", 2, APP_DEADBAND_PRESSURE_ABS, APP_DEADBAND_PRESSURE_REL },
+};
+
+static float field_value(const telemetry_sample_t *sample, telemetry_field_t field) {
+    switch (field) {
+    case TELEMETRY_FIELD_CO2LEVEL:
+        return (float) sample->co2level;
+    case TELEMETRY_FIELD_TEMPERATURE:
+        return sample->temperature;
+    case TELEMETRY_FIELD_PRESSURE:
+        return sample->pressure;
+    default:
+        return 0.0f;
+    }
+}
+
+// "name":value, as the telemetry writer formats the value
+static uint32_t field_size(const field_config_t *config, float value) {
+    char number[TELEMETRY_WRITER_FLOAT_LEN];
+
+    return (uint32_t) (strlen(config->name) + sizeof("\"\":,") - 1
+            + telemetry_writer_format_float(number, value, config->precision));
+}
+
+static bool outside_deadband(const field_config_t *config, float last, float value) {
+    float delta = fabsf(value - last);
+
+    if (config->absolute <= 0.0f && config->relative <= 0.0f) {
+        return delta > 0.0f; // report on change
+    }
+    return (config->absolute > 0.0f && delta >= config->absolute)
+            || (config->relative > 0.0f && delta >= config->relative * fabsf(last));
+}
+
+void telemetry_filter_init(telemetry_filter_t *filter, uint16_t static_size) {
+    memset(filter, 0, sizeof(*filter));
+    filter->static_size = static_size;
+    telemetry_filter_reset(filter);
+}
+
+void telemetry_filter_reset(telemetry_filter_t *filter) {
+    for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        filter->sent.fields[i].reported = false;
+    }
+    filter->sent.static_due = true;
+    filter->building = filter->sent;
+}
+
+uint32_t telemetry_filter_apply(telemetry_filter_t *filter, const telemetry_sample_t *sample, TickType_t taken_at) {
+    telemetry_filter_state_t *state = &filter->building;
+#if APP_TELEMETRY_FILTER
+    uint32_t report = 0;
+
+    if (state->static_due) {
+        state->static_due = false;
+        report |= TELEMETRY_FILTER_STATIC;
+    } else {
+        state->stats.bytes_suppressed += filter->static_size;
+    }
+
+    for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        const field_config_t *config = &field_configs[i];
+        telemetry_filter_field_t *field = &state->fields[i];
+        float value = field_value(sample, (telemetry_field_t) i);
+
+        if (!field->reported
+                || taken_at - field->reported_at >= pdMS_TO_TICKS(APP_TELEMETRY_MAX_SILENCE_MS)
+                || outside_deadband(config, field->last, value)) {
+            field->reported = true;
+            field->last = value;
+            field->reported_at = taken_at;
+            state->stats.values_sent++;
+            report |= TELEMETRY_FILTER_FIELD(i);
+        } else {
+            state->stats.values_suppressed++;
+            state->stats.bytes_suppressed += field_size(config, value);
+        }
+    }
+
+    if (!report) {
+        state->stats.points_suppressed++;
+        // {"dt":"<timestamp>","d":{}},
+        state->stats.bytes_suppressed += (uint32_t) (sizeof("{\"dt\":\"\",\"d\":{}},") - 1 + strlen(sample->timestamp));
+    }
+    return report;
+#else
+    (void) sample;
+    (void) taken_at;
+    state->stats.values_sent += TELEMETRY_FIELD_COUNT;
+    return TELEMETRY_FILTER_ALL;
+#endif
+}
+
+void telemetry_filter_message_suppressed(telemetry_filter_t *filter) {
+    filter->building.stats.messages_suppressed++;
+}
+
+void telemetry_filter_commit(telemetry_filter_t *filter) {
+    filter->sent = filter->building;
+}
+
+void telemetry_filter_discard(telemetry_filter_t *filter) {
+    filter->building = filter->sent;
+}
+
+void telemetry_filter_print_stats(const telemetry_filter_t *filter) {
+    const telemetry_filter_stats_t *s = &filter->sent.stats;
+
+    printf("Filter: %lu values sent, %lu suppressed, %lu data points and %lu messages suppressed, %lu bytes saved\n",
+            (unsigned long) s->values_sent, (unsigned long) s->values_suppressed,
+            (unsigned long) s->points_suppressed, (unsigned long) s->messages_suppressed,
+            (unsigned long) s->bytes_suppressed);
+}
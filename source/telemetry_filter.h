@@ -0,0 +1,92 @@
+//
+// Copyright: Avnet 2021
+//
+// Deadband filter for the telemetry data points.
+//
+// A sensor value is published when it moved at least its absolute or
+// relative threshold (see app_config.h) away from the last published value,
+// or once it was not published for APP_TELEMETRY_MAX_SILENCE_MS. With both
+// thresholds set to 0 a value is published whenever it changed. The static
+// fields (version and the test cpu value) are only published with the first
+// data point after a connect, which also publishes every value.
+//
+// Data points left without values are dropped, and a message left without
+// data points is not sent at all. The filter counts what it left out.
+//
+// The filter decides on a copy of its state. The caller commits that copy
+// once the message was sent, or discards it, so that the values of a message
+// that was not sent are not taken as published.
+//
+
+#ifndef TELEMETRY_FILTER_H_
+#define TELEMETRY_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "app_config.h"
+#include "telemetry_sample.h"
+
+typedef enum {
+    TELEMETRY_FIELD_CO2LEVEL,
+    TELEMETRY_FIELD_TEMPERATURE,
+    TELEMETRY_FIELD_PRESSURE,
+    TELEMETRY_FIELD_COUNT
+} telemetry_field_t;
+
+/* Bits returned by telemetry_filter_apply() */
+#define TELEMETRY_FILTER_FIELD(field)   (1U << (field))
+#define TELEMETRY_FILTER_STATIC         (1U << TELEMETRY_FIELD_COUNT)
+#define TELEMETRY_FILTER_ALL            (TELEMETRY_FILTER_STATIC | (TELEMETRY_FILTER_STATIC - 1))
+
+typedef struct {
+    uint32_t values_sent;
+    uint32_t values_suppressed;
+    uint32_t points_suppressed;
+    uint32_t messages_suppressed;
+    uint32_t bytes_suppressed;  // serialized size of the values and data points left out
+} telemetry_filter_stats_t;
+
+typedef struct {
+    bool reported;              // false until the first value after a reset is published
+    float last;                 // last published value
+    TickType_t reported_at;
+} telemetry_filter_field_t;
+
+typedef struct {
+    telemetry_filter_field_t fields[TELEMETRY_FIELD_COUNT];
+    bool static_due;
+    telemetry_filter_stats_t stats;
+} telemetry_filter_state_t;
+
+typedef struct {
+    telemetry_filter_state_t sent;      // as of the last message that was sent
+    telemetry_filter_state_t building;  // including the message being built
+    uint16_t static_size;
+} telemetry_filter_t;
+
+/* 'static_size' is the serialized size of the static fields, for the suppressed byte count */
+void telemetry_filter_init(telemetry_filter_t *filter, uint16_t static_size);
+
+/* Publishes the static fields and every value with the next data point. Call on every connect. */
+void telemetry_filter_reset(telemetry_filter_t *filter);
+
+/* Returns the TELEMETRY_FILTER_* bits of what to publish of 'sample', which was taken at 'taken_at'.
+ * Call for the samples in the order they were taken, and end each message with telemetry_filter_commit()
+ * or telemetry_filter_discard(). */
+uint32_t telemetry_filter_apply(telemetry_filter_t *filter, const telemetry_sample_t *sample, TickType_t taken_at);
+
+/* Counts a message that was not sent since none of its data points had values */
+void telemetry_filter_message_suppressed(telemetry_filter_t *filter);
+
+/* The message was sent, or suppressed: its values are the last published ones */
+void telemetry_filter_commit(telemetry_filter_t *filter);
+
+/* The message was not sent: forgets what telemetry_filter_apply() decided for it */
+void telemetry_filter_discard(telemetry_filter_t *filter);
+
+void telemetry_filter_print_stats(const telemetry_filter_t *filter);
+
+#endif // TELEMETRY_FILTER_H_
@@ -0,0 +1,25 @@
+//
+// Copyright: Avnet 2021
+//
+// One sensor readout, captured with its own timestamp so that it can be
+// published later as a data point of a multi-sample telemetry message.
+//
+
+#ifndef TELEMETRY_SAMPLE_H_
+#define TELEMETRY_SAMPLE_H_
+
+#include <stdint.h>
+
+#include "timestamp.h"
+
+/* "YYYY-MM-DDTHH:MM:SS.mmmZ" as returned by timestamp_now_iso() */
+#define TELEMETRY_TIMESTAMP_LEN (TIMESTAMP_ISO_LEN)
+
+typedef struct {
+    char timestamp[TELEMETRY_TIMESTAMP_LEN];
+    uint16_t co2level;      // ppm
+    float temperature;      // degrees Celsius
+    float pressure;         // mBar
+} telemetry_sample_t;
+
+#endif // TELEMETRY_SAMPLE_H_
@@ -0,0 +1,256 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+
+#include "telemetry_store.h"
+
+#define STORE_MAGIC (0x544C4F47UL) // "TLOG"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;          // increases with every page written
+    uint16_t count;             // samples in the page
+    uint16_t record_size;       // sizeof(telemetry_sample_t) when the page was written
+    uint32_t checksum;          // FNV-1a of the header, with checksum 0, and the samples
+} page_header_t;
+
+static cyhal_flash_t flash;
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return hash;
+}
+
+static uint32_t page_checksum(const telemetry_store_t *store, const page_header_t *header) {
+    page_header_t copy = *header;
+    copy.checksum = 0;
+    uint32_t hash = fnv1a(2166136261U, &copy, sizeof(copy));
+    return fnv1a(hash, (const uint8_t *) store->page + sizeof(page_header_t),
+            (size_t) header->count * sizeof(telemetry_sample_t));
+}
+
+static telemetry_sample_t *buffered_sample(telemetry_store_t *store, uint16_t index) {
+    return (telemetry_sample_t *) ((uint8_t *) store->page + sizeof(page_header_t)) + index;
+}
+
+static uint32_t page_address(const telemetry_store_t *store, uint16_t page) {
+    return store->base + (uint32_t) page * store->page_size;
+}
+
+static uint16_t next_page(const telemetry_store_t *store, uint16_t page) {
+    return (uint16_t) ((page + 1) % store->page_count);
+}
+
+// Reads a page into the RAM buffer. True if it holds a full page of samples.
+static bool load_page(telemetry_store_t *store, uint16_t page, uint32_t *sequence) {
+    const page_header_t *header = (const page_header_t *) store->page;
+
+    if (CY_RSLT_SUCCESS != cyhal_flash_read(&flash, page_address(store, page), (uint8_t *) store->page, store->page_size)) {
+        store->stats.flash_errors++;
+        return false;
+    }
+    if (header->magic != STORE_MAGIC || header->record_size != sizeof(telemetry_sample_t)
+            || header->count != store->records_per_page || header->checksum != page_checksum(store, header)) {
+        return false;
+    }
+    *sequence = header->sequence;
+    return true;
+}
+
+// Finds the pages left from before the reset. They form one run from the oldest to the newest page.
+static void recover(telemetry_store_t *store) {
+    uint16_t valid = 0, oldest = 0, newest = 0;
+    uint32_t oldest_sequence = 0, newest_sequence = 0;
+
+    for (uint16_t page = 0; page < store->page_count; page++) {
+        uint32_t sequence;
+        if (!load_page(store, page, &sequence)) {
+            continue;
+        }
+        if (!valid || sequence < oldest_sequence) {
+            oldest = page;
+            oldest_sequence = sequence;
+        }
+        if (!valid || sequence > newest_sequence) {
+            newest = page;
+            newest_sequence = sequence;
+        }
+        valid++;
+    }
+    if (!valid) {
+        return;
+    }
+
+    uint16_t run = (uint16_t) ((newest + store->page_count - oldest) % store->page_count + 1);
+    if (run != valid || newest_sequence - oldest_sequence != (uint32_t) valid - 1) {
+        // not written by this log in this order, start over
+        printf("Telemetry store: discarding %u inconsistent pages\n", (unsigned int) valid);
+        for (uint16_t page = 0; page < store->page_count; page++) {
+            cyhal_flash_erase(&flash, page_address(store, page));
+        }
+        store->next_sequence = newest_sequence + 1;
+        return;
+    }
+    store->tail = oldest;
+    store->head = next_page(store, newest);
+    store->used = valid;
+    store->next_sequence = newest_sequence + 1;
+    store->stats.recovered = (uint32_t) valid * store->records_per_page;
+}
+
+bool telemetry_store_init(telemetry_store_t *store) {
+    cyhal_flash_info_t info;
+
+    memset(store, 0, sizeof(*store));
+    if (CY_RSLT_SUCCESS != cyhal_flash_init(&flash)) {
+        printf("Error: Telemetry store: flash initialization failed\n");
+        return false;
+    }
+    cyhal_flash_get_info(&flash, &info);
+
+    // the main flash holds the running application
+    const cyhal_flash_block_info_t *block = NULL;
+    for (uint8_t i = 0; i < info.block_count; i++) {
+        if (info.blocks[i].start_address == CY_EM_EEPROM_BASE) {
+            block = &info.blocks[i];
+        }
+    }
+    if (!block) {
+        printf("Error: Telemetry store: no work flash at 0x%08lx\n", (unsigned long) CY_EM_EEPROM_BASE);
+        return false;
+    }
+    uint32_t size = block->size < APP_STORE_FLASH_SIZE ? block->size : APP_STORE_FLASH_SIZE;
+    if (block->page_size > TELEMETRY_STORE_MAX_PAGE_SIZE
+            || block->page_size < sizeof(page_header_t) + sizeof(telemetry_sample_t)
+            || size / block->page_size < 2) {
+        printf("Error: Telemetry store: unsupported flash layout (%lu byte pages)\n", (unsigned long) block->page_size);
+        return false;
+    }
+    store->base = block->start_address;
+    store->page_size = (uint16_t) block->page_size;
+    store->page_count = (uint16_t) (size / block->page_size);
+    store->records_per_page = (uint16_t) ((store->page_size - sizeof(page_header_t)) / sizeof(telemetry_sample_t));
+    recover(store);
+    store->ready = true;
+
+    printf("Telemetry store: %u pages of %u samples at 0x%08lx, %lu samples recovered\n",
+            (unsigned int) store->page_count, (unsigned int) store->records_per_page,
+            (unsigned long) store->base, (unsigned long) store->stats.recovered);
+    return true;
+}
+
+static bool write_page(telemetry_store_t *store) {
+    page_header_t *header = (page_header_t *) store->page;
+
+    if (store->used == store->page_count) {
+        // the log is full, the oldest page makes room
+        store->stats.dropped += store->records_per_page - store->tail_read;
+        store->tail = next_page(store, store->tail);
+        store->tail_read = 0;
+        store->used--;
+    }
+
+    header->magic = STORE_MAGIC;
+    header->sequence = store->next_sequence++;
+    header->count = store->buffered;
+    header->record_size = sizeof(telemetry_sample_t);
+    header->checksum = page_checksum(store, header);
+    // the unused end of the page is written as is
+    store->buffered = 0;
+    if (CY_RSLT_SUCCESS != cyhal_flash_write(&flash, page_address(store, store->head), store->page)) {
+        store->stats.flash_errors++;
+        store->stats.dropped += header->count;
+        return false;
+    }
+    store->stats.pages_written++;
+    store->head = next_page(store, store->head);
+    store->used++;
+    return true;
+}
+
+bool telemetry_store_append(telemetry_store_t *store, const telemetry_sample_t *sample) {
+    if (!store->ready) {
+        return false;
+    }
+    *buffered_sample(store, store->buffered++) = *sample;
+    store->stats.appended++;
+    if (store->buffered == store->records_per_page) {
+        return write_page(store);
+    }
+    return true;
+}
+
+uint32_t telemetry_store_count(const telemetry_store_t *store) {
+    if (!store->used) {
+        return store->buffered;
+    }
+    return (uint32_t) store->used * store->records_per_page - store->tail_read + store->buffered;
+}
+
+bool telemetry_store_get(const telemetry_store_t *store, uint32_t index, telemetry_sample_t *sample) {
+    uint32_t in_flash = telemetry_store_count(store) - store->buffered;
+
+    if (index >= in_flash) {
+        index -= in_flash;
+        if (index >= store->buffered) {
+            return false;
+        }
+        *sample = *buffered_sample((telemetry_store_t *) store, (uint16_t) index);
+        return true;
+    }
+
+    index += store->tail_read;
+    uint16_t page = (uint16_t) ((store->tail + index / store->records_per_page) % store->page_count);
+    uint32_t address = page_address(store, page) + sizeof(page_header_t)
+            + (index % store->records_per_page) * sizeof(telemetry_sample_t);
+    return CY_RSLT_SUCCESS == cyhal_flash_read(&flash, address, (uint8_t *) sample, sizeof(*sample));
+}
+
+void telemetry_store_consume(telemetry_store_t *store, uint32_t count) {
+    while (count && store->used) {
+        uint16_t n = store->records_per_page - store->tail_read;
+        if (n > count) {
+            n = (uint16_t) count;
+        }
+        store->tail_read += n;
+        store->stats.replayed += n;
+        count -= n;
+        if (store->tail_read == store->records_per_page) {
+            // so that it is not found again after a reset
+            if (CY_RSLT_SUCCESS == cyhal_flash_erase(&flash, page_address(store, store->tail))) {
+                store->stats.pages_erased++;
+            } else {
+                store->stats.flash_errors++;
+            }
+            store->tail = next_page(store, store->tail);
+            store->tail_read = 0;
+            store->used--;
+        }
+    }
+
+    if (count) {
+        uint16_t n = count < store->buffered ? (uint16_t) count : store->buffered;
+        memmove(buffered_sample(store, 0), buffered_sample(store, n), (size_t) (store->buffered - n) * sizeof(telemetry_sample_t));
+        store->buffered -= n;
+        store->stats.replayed += n;
+    }
+}
+
+void telemetry_store_print_stats(const telemetry_store_t *store) {
+    const telemetry_store_stats_t *s = &store->stats;
+
+    printf("Store: %lu samples queued, %lu appended, %lu replayed, %lu dropped, %lu recovered, "
+            "%lu pages written, %lu erased, %lu flash errors\n",
+            (unsigned long) telemetry_store_count(store), (unsigned long) s->appended, (unsigned long) s->replayed,
+            (unsigned long) s->dropped, (unsigned long) s->recovered, (unsigned long) s->pages_written,
+            (unsigned long) s->pages_erased, (unsigned long) s->flash_errors);
+}
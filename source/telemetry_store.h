@@ -0,0 +1,78 @@
+//
+// Copyright: Avnet 2021
+//
+// Flash log of the telemetry samples that could not be published.
+//
+// Samples are appended to a page sized RAM buffer, which is written to the
+// next flash page once it is full. The pages are used as a circular log, so
+// every page is erased once per lap and wears at the same rate. When the log
+// is full the oldest page is overwritten. Replayed pages are erased, so that
+// they are not replayed again after a reset. Up to one page of samples is
+// held in RAM and lost on a reset, and a page that was partly replayed
+// before a reset is replayed again in full.
+//
+// Each page starts with a header with a sequence number and a checksum.
+// telemetry_store_init() finds the pages that are still to be replayed by
+// scanning the headers.
+//
+// The log lives at the start of the work flash (CY_EM_EEPROM_BASE) and takes
+// APP_STORE_FLASH_SIZE bytes of it. Without a work flash the store does not
+// start, since the other flash blocks hold the application.
+//
+
+#ifndef TELEMETRY_STORE_H_
+#define TELEMETRY_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "telemetry_sample.h"
+
+/* Largest flash page size supported */
+#define TELEMETRY_STORE_MAX_PAGE_SIZE (512U)
+
+typedef struct {
+    uint32_t appended;
+    uint32_t replayed;          // consumed after they were published
+    uint32_t dropped;           // overwritten before they could be replayed
+    uint32_t recovered;         // found in flash by telemetry_store_init()
+    uint32_t pages_written;
+    uint32_t pages_erased;
+    uint32_t flash_errors;
+} telemetry_store_stats_t;
+
+typedef struct {
+    bool ready;
+    uint32_t base;              // flash address of the first page
+    uint16_t page_size;
+    uint16_t page_count;
+    uint16_t records_per_page;
+    uint16_t tail;              // oldest page in the log
+    uint16_t head;              // next page to write
+    uint16_t used;              // pages in the log
+    uint16_t tail_read;         // samples of the tail page already consumed
+    uint16_t buffered;          // samples in the RAM page buffer
+    uint32_t next_sequence;
+    uint32_t page[TELEMETRY_STORE_MAX_PAGE_SIZE / sizeof(uint32_t)]; // RAM page buffer
+    telemetry_store_stats_t stats;
+} telemetry_store_t;
+
+/* Opens the log and recovers the samples left in flash. Returns false if there is no usable flash. */
+bool telemetry_store_init(telemetry_store_t *store);
+
+/* Appends a copy of 'sample'. Overwrites the oldest page of samples if the log is full. */
+bool telemetry_store_append(telemetry_store_t *store, const telemetry_sample_t *sample);
+
+/* Samples in the log, including those in the RAM buffer */
+uint32_t telemetry_store_count(const telemetry_store_t *store);
+
+/* Reads the index'th oldest sample, index < count */
+bool telemetry_store_get(const telemetry_store_t *store, uint32_t index, telemetry_sample_t *sample);
+
+/* Removes the 'count' oldest samples after they have been published */
+void telemetry_store_consume(telemetry_store_t *store, uint32_t count);
+
+void telemetry_store_print_stats(const telemetry_store_t *store);
+
+#endif // TELEMETRY_STORE_H_
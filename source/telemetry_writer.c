@@ -0,0 +1,222 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <string.h>
+
+#include "telemetry_writer.h"
+
+/* SDK identification that the IoTConnect C library puts in every message */
+#define TELEMETRY_SDK_LANG      "M_C"
+#define TELEMETRY_SDK_VERSION   "2.0"
+
+static void put_raw(telemetry_writer_t *w, const char *data, size_t len) {
+    if (w->overflow) {
+        return;
+    }
+    // always keep room for the NUL terminator
+    if (len >= w->size - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->len], data, len);
+    w->len += len;
+}
+
+static void put_str(telemetry_writer_t *w, const char *str) {
+    put_raw(w, str, strlen(str));
+}
+
+static void put_char(telemetry_writer_t *w, char c) {
+    put_raw(w, &c, 1);
+}
+
+static void put_quoted(telemetry_writer_t *w, const char *str) {
+    static const char hex[] = "0123456789abcdef";
+    const char *run = str;
+
+    put_char(w, '"');
+    for (; *str; str++) {
+        unsigned char c = (unsigned char) *str;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // flush the run of characters that need no escaping
+        put_raw(w, run, (size_t) (str - run));
+        run = str + 1;
+        if (c == '"' || c == '\\') {
+            char esc[2] = { '\\', (char) c };
+            put_raw(w, esc, sizeof(esc));
+        } else {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+            put_raw(w, esc, sizeof(esc));
+        }
+    }
+    put_raw(w, run, (size_t) (str - run));
+    put_char(w, '"');
+}
+
+// Writes the digits of 'value', zero padded to 'min_digits', to 'out' and returns their count
+static uint8_t format_uint(char *out, uint64_t value, uint8_t min_digits) {
+    char digits[20];
+    uint8_t count = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - count] = (char) ('0' + value % 10);
+        value /= 10;
+        count++;
+    } while (value || count < min_digits);
+    memcpy(out, &digits[sizeof(digits) - count], count);
+    return count;
+}
+
+static void put_uint(telemetry_writer_t *w, uint64_t value, uint8_t min_digits) {
+    char digits[20];
+
+    put_raw(w, digits, format_uint(digits, value, min_digits));
+}
+
+static bool put_field_name(telemetry_writer_t *w, const char *name) {
+    if (!w->points) {
+        return false;
+    }
+    if (w->fields++) {
+        put_char(w, ',');
+    }
+    put_quoted(w, name);
+    put_char(w, ':');
+    return !w->overflow;
+}
+
+void telemetry_writer_begin(telemetry_writer_t *w, char *buf, size_t size, const IotclConfig *config) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = (size == 0 || !config);
+    w->points = 0;
+    w->fields = 0;
+    w->outer_fields = 0;
+    w->in_object = false;
+    if (w->overflow) {
+        return;
+    }
+
+    put_str(w, "{\"cpId\":");
+    put_quoted(w, config->device.cpid);
+    put_str(w, ",\"dtg\":");
+    put_quoted(w, config->telemetry.dtg);
+    put_str(w, ",\"mt\":0,\"sdk\":{\"l\":\"" TELEMETRY_SDK_LANG "\",\"v\":\"" TELEMETRY_SDK_VERSION "\",\"e\":");
+    put_quoted(w, config->device.env);
+    put_str(w, "},\"d\":[{\"id\":");
+    put_quoted(w, config->device.duid);
+    put_str(w, ",\"tg\":\"\",\"d\":[");
+}
+
+bool telemetry_writer_add_point(telemetry_writer_t *w, const char *iso_timestamp) {
+    telemetry_writer_end_object(w);
+    if (w->points++) {
+        put_str(w, "}},");
+    }
+    w->fields = 0;
+    put_str(w, "{\"dt\":");
+    put_quoted(w, iso_timestamp);
+    put_str(w, ",\"d\":{");
+    return !w->overflow;
+}
+
+bool telemetry_writer_set_string(telemetry_writer_t *w, const char *name, const char *value) {
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    put_quoted(w, value);
+    return !w->overflow;
+}
+
+bool telemetry_writer_set_int(telemetry_writer_t *w, const char *name, int32_t value) {
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    if (value < 0) {
+        put_char(w, '-');
+    }
+    put_uint(w, value < 0 ? (uint64_t) -(int64_t) value : (uint64_t) value, 1);
+    return !w->overflow;
+}
+
+size_t telemetry_writer_format_float(char *out, float value, uint8_t decimals) {
+    static const uint32_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+    size_t len = 0;
+
+    // JSON has no NaN or infinity. Anything beyond the fixed point range is reported as null too.
+    if (value != value || value > 1e12f || value < -1e12f) {
+        memcpy(out, "null", 4);
+        return 4;
+    }
+    if (decimals > TELEMETRY_WRITER_MAX_DECIMALS) {
+        decimals = TELEMETRY_WRITER_MAX_DECIMALS;
+    }
+
+    double magnitude = value < 0 ? -(double) value : (double) value;
+    uint64_t scaled = (uint64_t) (magnitude * scales[decimals] + 0.5);
+    uint64_t integer = scaled / scales[decimals];
+    uint32_t fraction = (uint32_t) (scaled % scales[decimals]);
+
+    // drop trailing zeros of the fraction
+    while (decimals && fraction % 10 == 0) {
+        fraction /= 10;
+        decimals--;
+    }
+    if (value < 0 && scaled) {
+        out[len++] = '-';
+    }
+    len += format_uint(&out[len], integer, 1);
+    if (decimals) {
+        out[len++] = '.';
+        len += format_uint(&out[len], fraction, decimals);
+    }
+    return len;
+}
+
+bool telemetry_writer_set_float(telemetry_writer_t *w, const char *name, float value, uint8_t decimals) {
+    char number[TELEMETRY_WRITER_FLOAT_LEN];
+
+    if (!put_field_name(w, name)) {
+        return false;
+    }
+    put_raw(w, number, telemetry_writer_format_float(number, value, decimals));
+    return !w->overflow;
+}
+
+bool telemetry_writer_begin_object(telemetry_writer_t *w, const char *name) {
+    if (w->in_object || !put_field_name(w, name)) {
+        return false;
+    }
+    put_char(w, '{');
+    w->outer_fields = w->fields;
+    w->fields = 0;
+    w->in_object = true;
+    return !w->overflow;
+}
+
+bool telemetry_writer_end_object(telemetry_writer_t *w) {
+    if (!w->in_object) {
+        return false;
+    }
+    put_char(w, '}');
+    w->fields = w->outer_fields;
+    w->in_object = false;
+    return !w->overflow;
+}
+
+const char *telemetry_writer_finish(telemetry_writer_t *w) {
+    telemetry_writer_end_object(w);
+    if (w->points) {
+        put_str(w, "}}");
+    }
+    put_str(w, "]}]}");
+    if (w->overflow) {
+        return NULL;
+    }
+    w->buf[w->len] = '\0';
+    return w->buf;
+}
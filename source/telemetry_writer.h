@@ -0,0 +1,69 @@
+//
+// Copyright: Avnet 2021
+//
+// Heap-free IoTConnect telemetry serializer.
+//
+// Writes the same message layout as iotcl_telemetry_create() and
+// iotcl_create_serialized_string() straight into a caller supplied buffer:
+//
+// {"cpId":"..","dtg":"..","mt":0,"sdk":{"l":"M_C","v":"2.0","e":".."},
+//  "d":[{"id":"..","tg":"","d":[{"dt":"..","d":{"name":value,...}},...]}]}
+//
+// Numbers are formatted with integer arithmetic, because newlib's floating
+// point printf allocates from the heap.
+// Once the buffer is exhausted every further call is ignored and
+// telemetry_writer_finish() returns NULL.
+//
+
+#ifndef TELEMETRY_WRITER_H_
+#define TELEMETRY_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotconnect_lib.h"
+
+/* Maximum number of fraction digits accepted by telemetry_writer_set_float() */
+#define TELEMETRY_WRITER_MAX_DECIMALS (6U)
+
+/* Longest number written by telemetry_writer_format_float(): sign, 13 integer digits, point and decimals */
+#define TELEMETRY_WRITER_FLOAT_LEN (15U + TELEMETRY_WRITER_MAX_DECIMALS)
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+    uint16_t points;    // data points written so far
+    uint16_t fields;    // fields in the current data point or object
+    uint16_t outer_fields; // fields of the data point, while an object is open
+    bool in_object;
+} telemetry_writer_t;
+
+/* Starts a message for the device described by 'config' (see iotcl_get_config()) */
+void telemetry_writer_begin(telemetry_writer_t *w, char *buf, size_t size, const IotclConfig *config);
+
+/* Starts a new data point. Fields can only be set after a data point was added. */
+bool telemetry_writer_add_point(telemetry_writer_t *w, const char *iso_timestamp);
+
+bool telemetry_writer_set_string(telemetry_writer_t *w, const char *name, const char *value);
+
+bool telemetry_writer_set_int(telemetry_writer_t *w, const char *name, int32_t value);
+
+/* Writes 'value' rounded to 'decimals' fraction digits, without trailing zeros */
+bool telemetry_writer_set_float(telemetry_writer_t *w, const char *name, float value, uint8_t decimals);
+
+/* Formats 'value' as telemetry_writer_set_float() writes it into 'out', which must hold
+ * TELEMETRY_WRITER_FLOAT_LEN characters. Returns the length, 'out' is not NUL terminated. */
+size_t telemetry_writer_format_float(char *out, float value, uint8_t decimals);
+
+/* Starts an object field of the current data point. Objects cannot be nested. */
+bool telemetry_writer_begin_object(telemetry_writer_t *w, const char *name);
+
+bool telemetry_writer_end_object(telemetry_writer_t *w);
+
+/* Terminates the message. Returns the NUL terminated message or NULL if it did not fit. */
+const char *telemetry_writer_finish(telemetry_writer_t *w);
+
+#endif // TELEMETRY_WRITER_H_
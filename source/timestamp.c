@@ -0,0 +1,125 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "timestamp.h"
+
+static bool synced;
+static int64_t base_ms;         // time at base_ticks
+static uint64_t base_ticks;
+
+// Tick count that does not wrap, from the overflow count FreeRTOS keeps for timeouts
+static uint64_t ticks_now(void) {
+    TimeOut_t now;
+    vTaskSetTimeOutState(&now);
+    return ((uint64_t) (UBaseType_t) now.xOverflowCount << (8 * sizeof(TickType_t))) | now.xTimeOnEntering;
+}
+
+void timestamp_sync(void) {
+    time_t start = time(NULL);
+    time_t now;
+    TickType_t waited_from = xTaskGetTickCount();
+
+    // time() counts whole seconds, its next step is the start of a second
+    while ((now = time(NULL)) == start && xTaskGetTickCount() - waited_from < pdMS_TO_TICKS(1000)) {
+        vTaskDelay(1);
+    }
+    uint64_t ticks = ticks_now();
+
+    taskENTER_CRITICAL();
+    base_ms = (int64_t) now * 1000;
+    base_ticks = ticks;
+    synced = true;
+    taskEXIT_CRITICAL();
+}
+
+bool timestamp_is_synced(void) {
+    return synced;
+}
+
+int64_t timestamp_now_ms(void) {
+    int64_t ms;
+
+    taskENTER_CRITICAL();
+    if (synced) {
+        ms = base_ms + (int64_t) ((ticks_now() - base_ticks) * 1000 / configTICK_RATE_HZ);
+    } else {
+        ms = (int64_t) time(NULL) * 1000;
+    }
+    taskEXIT_CRITICAL();
+    return ms;
+}
+
+int64_t timestamp_now(void) {
+    return timestamp_now_ms() / 1000;
+}
+
+void timestamp_formatter_init(timestamp_formatter_t *f) {
+    f->hour = -1;
+    f->second = -1;
+    f->iso[0] = '\0';
+}
+
+static void put_digits(char *p, uint32_t value, int count) {
+    while (count--) {
+        p[count] = (char) ('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// "YYYY-MM-DDTHH:" of hours since 1970, the date from the day number as in the proleptic Gregorian calendar
+static void format_prefix(char *p, int64_t hour) {
+    int64_t days = hour / 24 + 719468; // days since 0000-03-01
+    int64_t era = days / 146097;
+    uint32_t day_of_era = (uint32_t) (days - era * 146097);
+    uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    uint32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    uint32_t month_from_march = (5 * day_of_year + 2) / 153;
+    uint32_t day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+    uint32_t month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+    uint32_t year = (uint32_t) (era * 400) + year_of_era + (month <= 2);
+
+    put_digits(&p[0], year, 4);
+    p[4] = '-';
+    put_digits(&p[5], month, 2);
+    p[7] = '-';
+    put_digits(&p[8], day, 2);
+    p[10] = 'T';
+    put_digits(&p[11], (uint32_t) (hour % 24), 2);
+    p[13] = ':';
+}
+
+const char *timestamp_format_iso(timestamp_formatter_t *f, int64_t epoch_ms) {
+    if (epoch_ms < 0) {
+        epoch_ms = 0;
+    }
+    int64_t second = epoch_ms / 1000;
+
+    if (second != f->second) {
+        int64_t hour = second / 3600;
+        uint32_t second_of_hour = (uint32_t) (second % 3600);
+
+        if (hour != f->hour) {
+            format_prefix(f->iso, hour);
+            f->iso[16] = ':';
+            f->iso[19] = '.';
+            f->iso[23] = 'Z';
+            f->iso[24] = '\0';
+            f->hour = hour;
+        }
+        put_digits(&f->iso[14], second_of_hour / 60, 2);
+        put_digits(&f->iso[17], second_of_hour % 60, 2);
+        f->second = second;
+    }
+    put_digits(&f->iso[20], (uint32_t) (epoch_ms % 1000), 3);
+    return f->iso;
+}
+
+const char *timestamp_now_iso(timestamp_formatter_t *f) {
+    return timestamp_format_iso(f, timestamp_now_ms());
+}
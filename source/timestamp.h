@@ -0,0 +1,51 @@
+//
+// Copyright: Avnet 2021
+//
+// Wall clock time for telemetry timestamps without gmtime() and strftime().
+//
+// timestamp_sync() takes the time that SNTP set as an epoch offset of the
+// FreeRTOS tick count. The time is then the offset plus the ticks since, in
+// milliseconds, and never goes backwards between two syncs.
+//
+// A timestamp_formatter_t caches the "YYYY-MM-DDTHH:" prefix of the hour it
+// formatted last, so that a timestamp in the same hour only rewrites the
+// minute, second and millisecond digits, and one in the same second only
+// the milliseconds. The prefix is computed from the day number once per hour.
+//
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* "YYYY-MM-DDTHH:MM:SS.mmmZ", the iotcl_iso_timestamp_now() format with milliseconds */
+#define TIMESTAMP_ISO_LEN (sizeof("0000-00-00T00:00:00.000Z"))
+
+typedef struct {
+    int64_t hour;               // hours since 1970 of the prefix in 'iso', -1 before the first use
+    int64_t second;             // seconds since 1970 of the digits in 'iso'
+    char iso[TIMESTAMP_ISO_LEN];
+} timestamp_formatter_t;
+
+/* Call after SNTP has set the time. Waits for time() to tick over to align the milliseconds (up to a second). */
+void timestamp_sync(void);
+
+/* True once timestamp_sync() was called. Before that the time is taken from time(). */
+bool timestamp_is_synced(void);
+
+/* Milliseconds since 1970 */
+int64_t timestamp_now_ms(void);
+
+/* Seconds since 1970 */
+int64_t timestamp_now(void);
+
+void timestamp_formatter_init(timestamp_formatter_t *f);
+
+/* Formats 'epoch_ms' (1970 to 9999). The result is valid until the next call with the same formatter. */
+const char *timestamp_format_iso(timestamp_formatter_t *f, int64_t epoch_ms);
+
+/* timestamp_format_iso() of timestamp_now_ms() */
+const char *timestamp_now_iso(timestamp_formatter_t *f);
+
+#endif // TIMESTAMP_H_
@@ -0,0 +1,224 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "mbedtls/platform.h"
+
+#include "ram_map.h"
+#include "tls_arena.h"
+
+#if APP_TLS_ARENA_SIZE
+
+#if !defined(MBEDTLS_PLATFORM_MEMORY)
+#error "The TLS arena needs MBEDTLS_PLATFORM_MEMORY (see mbedtls_user_config.h)"
+#endif
+
+#define ARENA_ALIGN         (8U)
+#define ARENA_END           (UINT32_MAX)    // end of the free list
+#define ARENA_ALLOCATED     (0xA110CA7EU)   // 'next' of an allocated block
+
+// Precedes every block. Offsets are from the start of the arena.
+typedef struct {
+    uint32_t size;          // of the block, including this header
+    uint32_t next;          // offset of the next free block, ARENA_ALLOCATED if in use
+} arena_block_t;
+
+#define ARENA_MIN_BLOCK     (2 * sizeof(arena_block_t))
+
+static uint64_t arena[APP_TLS_ARENA_SIZE / sizeof(uint64_t)];
+static uint32_t free_head = ARENA_END;
+static bool handshaking;
+static tls_arena_stats_t stats;
+
+static arena_block_t *block_at(uint32_t offset) {
+    return (arena_block_t *) ((uint8_t *) arena + offset);
+}
+
+// The scheduler is suspended rather than a mutex taken, so that this also works before it starts
+static void arena_lock(void) {
+    vTaskSuspendAll();
+}
+
+static void arena_unlock(void) {
+    xTaskResumeAll();
+}
+
+static void *arena_calloc(size_t count, size_t size) {
+    if (count && size > sizeof(arena) / count) {
+        arena_lock();
+        stats.failures++;
+        arena_unlock();
+        return NULL;
+    }
+    uint32_t need = (uint32_t) ((count * size + sizeof(arena_block_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+    if (need < ARENA_MIN_BLOCK) {
+        need = ARENA_MIN_BLOCK;
+    }
+
+    arena_lock();
+    uint32_t previous = ARENA_END;
+    uint32_t offset = free_head;
+    while (offset != ARENA_END && block_at(offset)->size < need) {
+        previous = offset;
+        offset = block_at(offset)->next;
+    }
+    if (offset == ARENA_END) {
+        stats.failures++;
+        arena_unlock();
+        return NULL;
+    }
+
+    arena_block_t *block = block_at(offset);
+    uint32_t next = block->next;
+    if (block->size - need >= ARENA_MIN_BLOCK) {
+        // the rest of the block stays free
+        arena_block_t *rest = block_at(offset + need);
+        rest->size = block->size - need;
+        rest->next = next;
+        next = offset + need;
+        block->size = need;
+    }
+    if (previous == ARENA_END) {
+        free_head = next;
+    } else {
+        block_at(previous)->next = next;
+    }
+    block->next = ARENA_ALLOCATED;
+
+    stats.allocations++;
+    stats.used += block->size;
+    if (stats.used > stats.peak) {
+        stats.peak = stats.used;
+    }
+    if (handshaking && stats.used > stats.handshake_peak) {
+        stats.handshake_peak = stats.used;
+    }
+    arena_unlock();
+
+    memset(block + 1, 0, block->size - sizeof(arena_block_t));
+    return block + 1;
+}
+
+static void arena_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    arena_block_t *block = (arena_block_t *) ptr - 1;
+    uint32_t offset = (uint32_t) ((uintptr_t) block - (uintptr_t) arena);
+
+    arena_lock();
+    if ((uintptr_t) block < (uintptr_t) arena || (uintptr_t) block >= (uintptr_t) arena + sizeof(arena)
+            || offset % ARENA_ALIGN || block->next != ARENA_ALLOCATED) {
+        stats.bad_frees++;
+        arena_unlock();
+        return;
+    }
+    stats.used -= block->size;
+
+    uint32_t previous = ARENA_END;
+    uint32_t next = free_head;
+    while (next != ARENA_END && next < offset) {
+        previous = next;
+        next = block_at(next)->next;
+    }
+    block->next = next;
+    if (next != ARENA_END && offset + block->size == next) {
+        block->size += block_at(next)->size;
+        block->next = block_at(next)->next;
+    }
+    if (previous == ARENA_END) {
+        free_head = offset;
+    } else if (previous + block_at(previous)->size == offset) {
+        block_at(previous)->size += block->size;
+        block_at(previous)->next = block->next;
+    } else {
+        block_at(previous)->next = offset;
+    }
+    arena_unlock();
+}
+
+void tls_arena_init(void) {
+    arena_block_t *block = block_at(0);
+
+    block->size = sizeof(arena);
+    block->next = ARENA_END;
+    free_head = 0;
+    stats.size = sizeof(arena);
+    mbedtls_platform_set_calloc_free(arena_calloc, arena_free);
+    ram_map_add("TLS arena", sizeof(arena));
+}
+
+void tls_arena_handshake_begin(void) {
+    arena_lock();
+    handshaking = true;
+    stats.handshake_peak = stats.used;
+    arena_unlock();
+}
+
+void tls_arena_handshake_end(bool success) {
+    arena_lock();
+    handshaking = false;
+    if (stats.handshake_peak > stats.handshake_peak_max) {
+        stats.handshake_peak_max = stats.handshake_peak;
+    }
+    if (success) {
+        stats.after_handshake = stats.used;
+    }
+    arena_unlock();
+}
+
+void tls_arena_get_stats(tls_arena_stats_t *out) {
+    arena_lock();
+    *out = stats;
+    out->free_blocks = 0;
+    out->largest_free = 0;
+    for (uint32_t offset = free_head; offset != ARENA_END; offset = block_at(offset)->next) {
+        out->free_blocks++;
+        if (block_at(offset)->size > out->largest_free) {
+            out->largest_free = block_at(offset)->size;
+        }
+    }
+    arena_unlock();
+}
+
+void tls_arena_print_stats(void) {
+    tls_arena_stats_t s;
+    tls_arena_get_stats(&s);
+
+    uint32_t free_bytes = s.size - s.used;
+    printf("TLS arena: %lu of %lu bytes in use (peak %lu), handshake peak %lu (max %lu), %lu after the last handshake\n",
+            (unsigned long) s.used, (unsigned long) s.size, (unsigned long) s.peak,
+            (unsigned long) s.handshake_peak, (unsigned long) s.handshake_peak_max, (unsigned long) s.after_handshake);
+    // the share of the free space that is not in the largest free block
+    printf("TLS arena: %lu allocations, %lu failed, %lu bad frees, %lu bytes free in %lu blocks, largest %lu (%lu%% fragmented)\n",
+            (unsigned long) s.allocations, (unsigned long) s.failures, (unsigned long) s.bad_frees,
+            (unsigned long) free_bytes, (unsigned long) s.free_blocks, (unsigned long) s.largest_free,
+            (unsigned long) (free_bytes ? 100 - (uint64_t) s.largest_free * 100 / free_bytes : 0));
+}
+
+#else
+
+void tls_arena_init(void) {
+}
+
+void tls_arena_handshake_begin(void) {
+}
+
+void tls_arena_handshake_end(bool success) {
+    (void) success;
+}
+
+void tls_arena_get_stats(tls_arena_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void tls_arena_print_stats(void) {
+}
+
+#endif // APP_TLS_ARENA_SIZE
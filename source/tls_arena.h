@@ -0,0 +1,55 @@
+//
+// Copyright: Avnet 2021
+//
+// Dedicated heap for mbedTLS.
+//
+// mbedTLS allocates through mbedtls_calloc() and mbedtls_free()
+// (MBEDTLS_PLATFORM_MEMORY in mbedtls_user_config.h), which tls_arena_init()
+// points at a first fit allocator on a static arena of APP_TLS_ARENA_SIZE
+// bytes. The record buffers and handshake state of every connection then
+// come and go without fragmenting the heap that the SDK, lwIP and cJSON use,
+// and a leak or an oversized handshake shows up as a failed TLS allocation
+// instead of a heap exhaustion elsewhere.
+//
+// Free blocks are kept in address order and merged with their neighbours
+// when freed. The statistics give the bytes in use, the peak of the last and
+// of the largest handshake (mbedtls_ssl_handshake() is wrapped by
+// tls_session_cache.c), and how fragmented the free space is.
+//
+
+#ifndef TLS_ARENA_H_
+#define TLS_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+typedef struct {
+    uint32_t size;              // of the arena
+    uint32_t used;              // bytes allocated right now, including the block headers
+    uint32_t peak;              // highest 'used' since tls_arena_init()
+    uint32_t handshake_peak;    // highest 'used' during the last handshake
+    uint32_t handshake_peak_max;
+    uint32_t after_handshake;   // 'used' right after the last successful handshake
+    uint32_t allocations;
+    uint32_t failures;          // allocations that did not fit
+    uint32_t bad_frees;         // pointers that were not allocated from the arena
+    uint32_t free_blocks;       // free space, filled in by tls_arena_get_stats()
+    uint32_t largest_free;
+} tls_arena_stats_t;
+
+/* Must be called before the first mbedTLS allocation, i.e. before the scheduler starts. Does nothing with
+ * APP_TLS_ARENA_SIZE 0, and mbedTLS then allocates from the heap. */
+void tls_arena_init(void);
+
+/* Called around every handshake */
+void tls_arena_handshake_begin(void);
+void tls_arena_handshake_end(bool success);
+
+void tls_arena_get_stats(tls_arena_stats_t *stats);
+
+void tls_arena_print_stats(void);
+
+#endif // TLS_ARENA_H_
@@ -0,0 +1,318 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "mbedtls/ssl.h"
+
+#include "tls_session_cache.h"
+#include "tls_arena.h"
+#include "trace.h"
+
+typedef struct {
+    char host[TLS_SESSION_CACHE_HOST_LEN];
+    mbedtls_ssl_session session;
+    bool valid;
+    TickType_t last_used;
+} cache_entry_t;
+
+typedef struct {
+    mbedtls_ssl_context *ssl;   // NULL if the slot is free
+    cache_entry_t *entry;       // cache entry of the host being connected to
+
+    // original I/O callbacks of secure sockets
+    void *p_bio;
+    mbedtls_ssl_send_t *f_send;
+    mbedtls_ssl_recv_t *f_recv;
+    mbedtls_ssl_recv_timeout_t *f_recv_timeout;
+
+    bool offered;               // a cached session was offered to the server
+    bool in_handshake;
+    unsigned char offered_id[32];
+    size_t offered_id_len;      // session ID sent in the ClientHello
+    TickType_t start;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+} connection_t;
+
+int __real_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname);
+void __real_mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+        mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout);
+int __real_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl);
+void __real_mbedtls_ssl_free(mbedtls_ssl_context *ssl);
+
+static cache_entry_t cache[TLS_SESSION_CACHE_HOSTS];
+static connection_t connections[TLS_SESSION_CACHE_CONNECTIONS];
+static tls_session_stats_t stats;
+
+static SemaphoreHandle_t lock;
+static StaticSemaphore_t lock_buffer;
+
+static void cache_lock(void) {
+    if (lock) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+    }
+}
+
+static void cache_unlock(void) {
+    if (lock) {
+        xSemaphoreGive(lock);
+    }
+}
+
+// Called with the lock held. Returns NULL if all slots are in use.
+static connection_t *get_connection(mbedtls_ssl_context *ssl, bool create) {
+    connection_t *free_slot = NULL;
+
+    for (int i = 0; i < TLS_SESSION_CACHE_CONNECTIONS; i++) {
+        if (connections[i].ssl == ssl) {
+            return &connections[i];
+        }
+        if (!connections[i].ssl && !free_slot) {
+            free_slot = &connections[i];
+        }
+    }
+    if (create && free_slot) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->ssl = ssl;
+    }
+    return create ? free_slot : NULL;
+}
+
+// Called with the lock held. Reuses the least recently used entry for a new host.
+static cache_entry_t *get_entry(const char *host) {
+    cache_entry_t *oldest = &cache[0];
+
+    for (int i = 0; i < TLS_SESSION_CACHE_HOSTS; i++) {
+        if (0 == strcmp(cache[i].host, host)) {
+            return &cache[i];
+        }
+        if (!cache[i].host[0] || (oldest->host[0] && cache[i].last_used < oldest->last_used)) {
+            oldest = &cache[i];
+        }
+    }
+    mbedtls_ssl_session_free(&oldest->session);
+    mbedtls_ssl_session_init(&oldest->session);
+    oldest->valid = false;
+    strcpy(oldest->host, host);
+    return oldest;
+}
+
+static int counting_send(void *ctx, const unsigned char *buf, size_t len) {
+    connection_t *c = (connection_t *) ctx;
+
+    if (c->in_handshake && !c->tx_bytes) {
+        // first flight is the ClientHello, which carries the session ID being offered
+        const mbedtls_ssl_session *offered = c->ssl->session_negotiate;
+        c->offered_id_len = (offered && offered->id_len <= sizeof(c->offered_id)) ? offered->id_len : 0;
+        if (c->offered_id_len) {
+            memcpy(c->offered_id, offered->id, c->offered_id_len);
+        }
+    }
+    TRACE_BEGIN_ARG(TRACE_SPAN_SOCKET_WRITE, len);
+    int ret = c->f_send(c->p_bio, buf, len);
+    TRACE_END(TRACE_SPAN_SOCKET_WRITE);
+    if (c->in_handshake && ret > 0) {
+        c->tx_bytes += (uint32_t) ret;
+    }
+    return ret;
+}
+
+static int counting_recv(void *ctx, unsigned char *buf, size_t len) {
+    connection_t *c = (connection_t *) ctx;
+    int ret = c->f_recv(c->p_bio, buf, len);
+    if (c->in_handshake && ret > 0) {
+        c->rx_bytes += (uint32_t) ret;
+    }
+    return ret;
+}
+
+static int counting_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout) {
+    connection_t *c = (connection_t *) ctx;
+    int ret = c->f_recv_timeout(c->p_bio, buf, len, timeout);
+    if (c->in_handshake && ret > 0) {
+        c->rx_bytes += (uint32_t) ret;
+    }
+    return ret;
+}
+
+static void account_handshake(tls_handshake_stats_t *s, const connection_t *c, uint32_t ms) {
+    s->count++;
+    s->total_ms += ms;
+    if (ms > s->max_ms) {
+        s->max_ms = ms;
+    }
+    s->tx_bytes += c->tx_bytes;
+    s->rx_bytes += c->rx_bytes;
+}
+
+static void handshake_done(connection_t *c) {
+    uint32_t ms = (uint32_t) ((xTaskGetTickCount() - c->start) * portTICK_PERIOD_MS);
+    const mbedtls_ssl_session *session = c->ssl->session;
+
+    // The server accepts a resumption by echoing the session ID of the ClientHello
+    bool resumed = c->offered && c->offered_id_len && session && session->id_len == c->offered_id_len
+            && 0 == memcmp(session->id, c->offered_id, c->offered_id_len);
+
+    if (resumed) {
+        account_handshake(&stats.resumed, c, ms);
+    } else {
+        account_handshake(&stats.full, c, ms);
+        if (c->offered) {
+            stats.rejected++;
+        }
+    }
+    printf("TLS: %s handshake with %s in %lu ms, %lu bytes sent, %lu bytes received\n",
+            resumed ? "resumed" : "full", c->entry ? c->entry->host : "?",
+            (unsigned long) ms, (unsigned long) c->tx_bytes, (unsigned long) c->rx_bytes);
+
+    // keep the newest session (and ticket) for the next connection to this host
+    if (c->entry) {
+        mbedtls_ssl_session_free(&c->entry->session);
+        mbedtls_ssl_session_init(&c->entry->session);
+        c->entry->valid = (0 == mbedtls_ssl_get_session(c->ssl, &c->entry->session));
+        c->entry->last_used = xTaskGetTickCount();
+    }
+}
+
+int __wrap_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname) {
+    int ret = __real_mbedtls_ssl_set_hostname(ssl, hostname);
+    if (ret || !hostname || strlen(hostname) >= TLS_SESSION_CACHE_HOST_LEN) {
+        return ret;
+    }
+
+    cache_lock();
+    connection_t *c = get_connection(ssl, true);
+    if (c) {
+        c->entry = get_entry(hostname);
+        if (c->entry->valid && 0 == mbedtls_ssl_set_session(ssl, &c->entry->session)) {
+            c->offered = true;
+        }
+    }
+    cache_unlock();
+    return ret;
+}
+
+void __wrap_mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+        mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout) {
+    cache_lock();
+    connection_t *c = get_connection(ssl, true);
+    if (c) {
+        c->p_bio = p_bio;
+        c->f_send = f_send;
+        c->f_recv = f_recv;
+        c->f_recv_timeout = f_recv_timeout;
+    }
+    cache_unlock();
+
+    if (!c) {
+        // not tracked, pass through without accounting
+        __real_mbedtls_ssl_set_bio(ssl, p_bio, f_send, f_recv, f_recv_timeout);
+        return;
+    }
+    __real_mbedtls_ssl_set_bio(ssl, c,
+            f_send ? counting_send : NULL,
+            f_recv ? counting_recv : NULL,
+            f_recv_timeout ? counting_recv_timeout : NULL);
+}
+
+int __wrap_mbedtls_ssl_handshake(mbedtls_ssl_context *ssl) {
+    cache_lock();
+    connection_t *c = get_connection(ssl, false);
+    bool begin = c && !c->in_handshake;
+    if (begin) {
+        c->in_handshake = true;
+        c->start = xTaskGetTickCount();
+        c->tx_bytes = 0;
+        c->rx_bytes = 0;
+    }
+    cache_unlock();
+
+    if (begin) {
+        tls_arena_handshake_begin();
+    }
+
+    int ret = __real_mbedtls_ssl_handshake(ssl);
+    if (!c || ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return ret;
+    }
+
+    tls_arena_handshake_end(ret == 0);
+    cache_lock();
+    c->in_handshake = false;
+    if (ret == 0) {
+        handshake_done(c);
+    } else {
+        stats.failed++;
+        if (c->entry && c->offered) {
+            // do not offer a session again that may have caused the failure
+            c->entry->valid = false;
+        }
+    }
+    cache_unlock();
+    return ret;
+}
+
+void __wrap_mbedtls_ssl_free(mbedtls_ssl_context *ssl) {
+    cache_lock();
+    connection_t *c = get_connection(ssl, false);
+    if (c) {
+        c->ssl = NULL;
+    }
+    cache_unlock();
+    __real_mbedtls_ssl_free(ssl);
+}
+
+void tls_session_cache_init(void) {
+    if (!lock) {
+        lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+    }
+    for (int i = 0; i < TLS_SESSION_CACHE_HOSTS; i++) {
+        mbedtls_ssl_session_init(&cache[i].session);
+    }
+}
+
+void tls_session_cache_clear(void) {
+    cache_lock();
+    for (int i = 0; i < TLS_SESSION_CACHE_HOSTS; i++) {
+        mbedtls_ssl_session_free(&cache[i].session);
+        mbedtls_ssl_session_init(&cache[i].session);
+        cache[i].valid = false;
+        cache[i].host[0] = '\0';
+    }
+    cache_unlock();
+}
+
+void tls_session_cache_get_stats(tls_session_stats_t *s) {
+    cache_lock();
+    *s = stats;
+    cache_unlock();
+}
+
+static void print_handshake_stats(const char *name, const tls_handshake_stats_t *s) {
+    if (!s->count) {
+        printf("TLS %-8s handshakes: none\n", name);
+        return;
+    }
+    printf("TLS %-8s handshakes: %lu, avg %lu ms, max %lu ms, avg %lu bytes sent, %lu bytes received\n",
+            name, (unsigned long) s->count,
+            (unsigned long) (s->total_ms / s->count), (unsigned long) s->max_ms,
+            (unsigned long) (s->tx_bytes / s->count), (unsigned long) (s->rx_bytes / s->count));
+}
+
+void tls_session_cache_print_report(void) {
+    tls_session_stats_t s;
+
+    tls_session_cache_get_stats(&s);
+    print_handshake_stats("full", &s.full);
+    print_handshake_stats("resumed", &s.resumed);
+    printf("TLS resumptions rejected by the server: %lu, failed handshakes: %lu\n",
+            (unsigned long) s.rejected, (unsigned long) s.failed);
+}
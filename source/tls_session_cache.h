@@ -0,0 +1,58 @@
+//
+// Copyright: Avnet 2021
+//
+// TLS session resumption for the connections made by the secure sockets
+// library (IoTConnect discovery and sync over HTTPS and the MQTT broker).
+//
+// The TLS contexts are owned by secure sockets, so the cache hooks into
+// mbedTLS through linker wrappers (see LDFLAGS in the Makefile):
+//
+// - mbedtls_ssl_set_hostname() offers the last session negotiated with the
+//   same host (session ticket or session ID).
+// - mbedtls_ssl_set_bio() counts the handshake bytes sent and received.
+// - mbedtls_ssl_handshake() times the handshake and stores the new session.
+// - mbedtls_ssl_free() drops the per connection state.
+//
+// The cache lives in RAM, so the first connection after a reset is a full
+// handshake.
+//
+
+#ifndef TLS_SESSION_CACHE_H_
+#define TLS_SESSION_CACHE_H_
+
+#include <stdint.h>
+
+/* Number of hosts with a cached session: discovery, sync and MQTT broker */
+#define TLS_SESSION_CACHE_HOSTS         (3)
+/* Maximum host name length that can be cached */
+#define TLS_SESSION_CACHE_HOST_LEN      (64)
+/* TLS connections that can be tracked at the same time */
+#define TLS_SESSION_CACHE_CONNECTIONS   (2)
+
+typedef struct {
+    uint32_t count;
+    uint32_t total_ms;
+    uint32_t max_ms;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+} tls_handshake_stats_t;
+
+typedef struct {
+    tls_handshake_stats_t full;
+    tls_handshake_stats_t resumed;
+    uint32_t failed;            // handshakes that returned an error
+    uint32_t rejected;          // a cached session was offered, but the server did a full handshake
+} tls_session_stats_t;
+
+/* Must be called once before the first TLS connection */
+void tls_session_cache_init(void);
+
+/* Forgets all cached sessions, e.g. after the broker rejected the device */
+void tls_session_cache_clear(void);
+
+void tls_session_cache_get_stats(tls_session_stats_t *stats);
+
+/* Prints the full vs resumed handshake latency and size report */
+void tls_session_cache_print_report(void);
+
+#endif // TLS_SESSION_CACHE_H_
@@ -0,0 +1,181 @@
+//
+// Copyright: Avnet 2021
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#if defined(APP_HOST_BUILD)
+#include <time.h>
+#else
+#include "cy_pdl.h"
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "mbedtls/ssl.h"
+
+#include "ram_map.h"
+#include "trace.h"
+
+#if APP_TRACE_ENABLED
+// bump when trace_record_t or the dump format changes (see host/tools/trace2chrome.c)
+#define TRACE_FORMAT_VERSION    (1)
+#define TRACE_RECORDS_PER_LINE  (8)
+
+typedef struct {
+    TaskHandle_t owner;         // NULL while the ring is unclaimed
+    uint32_t head;              // records written, only advanced by the owner
+    uint32_t dumped;            // head at the previous dump
+    trace_record_t records[APP_TRACE_RECORDS];
+} trace_ring_t;
+
+static const char *const span_names[TRACE_SPAN_COUNT] = {
+    [TRACE_SPAN_PUBLISH] = "publish_telemetry",
+    [TRACE_SPAN_DPS310_READ] = "dps310_read",
+    [TRACE_SPAN_PASCO2_READ] = "pasco2_read",
+    [TRACE_SPAN_JSON_BUILD] = "json_build",
+    [TRACE_SPAN_SERIALIZE] = "serialize",
+    [TRACE_SPAN_SEND] = "send_packet",
+    [TRACE_SPAN_TLS_WRITE] = "tls_write",
+    [TRACE_SPAN_SOCKET_WRITE] = "socket_write",
+};
+
+static trace_ring_t rings[APP_TRACE_TASKS];
+static volatile bool paused;
+
+#if defined(APP_HOST_BUILD)
+#define TRACE_CYCLES_HZ (1000000000UL)
+
+static inline uint32_t trace_cycles(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * TRACE_CYCLES_HZ + (uint64_t) now.tv_nsec);
+}
+#else
+#define TRACE_CYCLES_HZ (SystemCoreClock)
+
+static inline uint32_t trace_cycles(void) {
+    return DWT->CYCCNT;
+}
+#endif
+
+void trace_init(void) {
+#if !defined(APP_HOST_BUILD)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    ram_map_add("Trace rings", sizeof(rings));
+}
+
+static trace_ring_t *ring_of(TaskHandle_t task) {
+    for (int i = 0; i < APP_TRACE_TASKS; i++) {
+        if (rings[i].owner == task) {
+            return &rings[i];
+        }
+    }
+
+    // first record of this task
+    trace_ring_t *ring = NULL;
+    taskENTER_CRITICAL();
+    for (int i = 0; i < APP_TRACE_TASKS && !ring; i++) {
+        if (!rings[i].owner) {
+            rings[i].owner = task;
+            ring = &rings[i];
+        }
+    }
+    taskEXIT_CRITICAL();
+    return ring; // NULL if more than APP_TRACE_TASKS tasks trace
+}
+
+void trace_record(trace_span_t span, uint8_t phase, uint32_t arg) {
+    if (paused) {
+        return;
+    }
+    trace_ring_t *ring = ring_of(xTaskGetCurrentTaskHandle());
+    if (!ring) {
+        return;
+    }
+
+    trace_record_t *record = &ring->records[ring->head % APP_TRACE_RECORDS];
+    record->cycles = trace_cycles();
+    record->tick = xTaskGetTickCount();
+    record->arg = (uint16_t) (arg > UINT16_MAX ? UINT16_MAX : arg);
+    record->span = (uint8_t) span;
+    record->phase = phase;
+    // publish the record to trace_dump() only once it is complete
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+static void dump_ring(int index, trace_ring_t *ring, uint32_t *lost) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t first = ring->dumped;
+
+    if (head - first > APP_TRACE_RECORDS) {
+        *lost += head - first - APP_TRACE_RECORDS;
+        first = head - APP_TRACE_RECORDS;
+    }
+    if (first == head) {
+        return;
+    }
+    printf("#TRACE task %d %s\n", index, pcTaskGetName(ring->owner));
+    for (uint32_t i = first; i != head;) {
+        printf("#TRACE data %d ", index);
+        for (int n = 0; n < TRACE_RECORDS_PER_LINE && i != head; n++, i++) {
+            // raw little endian record
+            const uint8_t *bytes = (const uint8_t *) &ring->records[i % APP_TRACE_RECORDS];
+            for (size_t b = 0; b < sizeof(trace_record_t); b++) {
+                printf("%02x", bytes[b]);
+            }
+        }
+        printf("\n");
+    }
+    ring->dumped = head;
+}
+
+void trace_dump(void) {
+    uint32_t lost = 0;
+
+    // Tasks that are about to record see the flag. A record that was already being
+    // written can land in the dump or in the next one.
+    paused = true;
+    printf("#TRACE begin %d %lu %lu %lu %lu\n", TRACE_FORMAT_VERSION,
+            (unsigned long) TRACE_CYCLES_HZ, (unsigned long) configTICK_RATE_HZ,
+            (unsigned long) trace_cycles(), (unsigned long) xTaskGetTickCount());
+    for (int i = 0; i < TRACE_SPAN_COUNT; i++) {
+        printf("#TRACE span %d %s\n", i, span_names[i]);
+    }
+    for (int i = 0; i < APP_TRACE_TASKS; i++) {
+        if (rings[i].owner) {
+            dump_ring(i, &rings[i], &lost);
+        }
+    }
+    printf("#TRACE end %lu\n", (unsigned long) lost);
+    paused = false;
+}
+#else
+// the trace points compile to nothing and no rings are kept
+void trace_init(void) {
+}
+
+void trace_record(trace_span_t span, uint8_t phase, uint32_t arg) {
+    (void) span;
+    (void) phase;
+    (void) arg;
+}
+
+void trace_dump(void) {
+}
+#endif
+
+int __real_mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len);
+
+// TLS record encryption and the socket writes below it (linked with --wrap, see the Makefile)
+int __wrap_mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len) {
+    TRACE_BEGIN_ARG(TRACE_SPAN_TLS_WRITE, len);
+    int ret = __real_mbedtls_ssl_write(ssl, buf, len);
+    TRACE_END(TRACE_SPAN_TLS_WRITE);
+    return ret;
+}
@@ -0,0 +1,71 @@
+//
+// Copyright: Avnet 2021
+//
+// Span tracing of the telemetry hot path.
+//
+// TRACE_BEGIN()/TRACE_END() store a fixed size binary record with a cycle
+// count (the DWT cycle counter on the target, CLOCK_MONOTONIC nanoseconds in
+// the host build) into a ring owned by the calling task. Each ring has a
+// single writer, so recording takes no lock. The oldest records are
+// overwritten once a ring is full.
+//
+// trace_dump() prints the rings as "#TRACE" lines on the debug UART.
+// host/tools/trace2chrome.c turns a captured log into Chrome trace JSON
+// (chrome://tracing, Perfetto or speedscope):
+//
+//   build/trace2chrome < uart.log > trace.json
+//
+// Trace points must only be used in task context. They compile to nothing
+// unless APP_TRACE_ENABLED is set to 1 in app_config.h for profiling.
+//
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* Span IDs. Keep in sync with span_names in trace.c. */
+typedef enum {
+    TRACE_SPAN_PUBLISH,         // publish_telemetry()
+    TRACE_SPAN_DPS310_READ,
+    TRACE_SPAN_PASCO2_READ,
+    TRACE_SPAN_JSON_BUILD,      // data points into the message (arg: samples)
+    TRACE_SPAN_SERIALIZE,       // message to JSON text
+    TRACE_SPAN_SEND,            // iotconnect_sdk_send_packet() (arg: bytes)
+    TRACE_SPAN_TLS_WRITE,       // mbedtls_ssl_write(), encryption and socket writes (arg: bytes)
+    TRACE_SPAN_SOCKET_WRITE,    // one TLS record to the socket (arg: bytes)
+    TRACE_SPAN_COUNT
+} trace_span_t;
+
+#define TRACE_PHASE_BEGIN   (0)
+#define TRACE_PHASE_END     (1)
+
+typedef struct {
+    uint32_t cycles;    // cycle counter, wraps
+    uint32_t tick;      // RTOS tick count, resolves the cycle counter wraps
+    uint16_t arg;       // span specific, saturates
+    uint8_t span;       // trace_span_t
+    uint8_t phase;      // TRACE_PHASE_BEGIN or TRACE_PHASE_END
+} trace_record_t;
+
+#if APP_TRACE_ENABLED
+#define TRACE_BEGIN(span)           trace_record((span), TRACE_PHASE_BEGIN, 0)
+#define TRACE_BEGIN_ARG(span, arg)  trace_record((span), TRACE_PHASE_BEGIN, (arg))
+#define TRACE_END(span)             trace_record((span), TRACE_PHASE_END, 0)
+#else
+#define TRACE_BEGIN(span)           do { } while (0)
+#define TRACE_BEGIN_ARG(span, arg)  do { (void) (arg); } while (0)
+#define TRACE_END(span)             do { } while (0)
+#endif
+
+/* Starts the cycle counter. Call once before the scheduler starts. */
+void trace_init(void);
+
+void trace_record(trace_span_t span, uint8_t phase, uint32_t arg);
+
+/* Prints the records taken since the previous dump and starts over */
+void trace_dump(void);
+
+#endif // TRACE_H_